@@ -5,6 +5,7 @@
 #include "StarDirectoryAssetSource.hpp"
 #include "StarPackedAssetSource.hpp"
 #include "StarMemoryAssetSource.hpp"
+#include "StarProcessedImageCache.hpp"
 #include "StarJsonBuilder.hpp"
 #include "StarJsonExtra.hpp"
 #include "StarJsonPatch.hpp"
@@ -18,6 +19,7 @@
 #include "StarLexicalCast.hpp"
 #include "StarSha256.hpp"
 #include "StarDataStreamDevices.hpp"
+#include "StarXXHash.hpp"
 #include "StarLua.hpp"
 #include "StarImageLuaBindings.hpp"
 #include "StarUtilityLuaBindings.hpp"
@@ -414,6 +416,9 @@ Assets::Assets(Settings settings, StringList assetSources) {
 
   m_digest = digest.compute();
 
+  if (m_settings.processedImageCache)
+    m_processedImageCache = make_shared<ProcessedImageCache>(*m_settings.processedImageCache, m_settings.processedImageCacheSize);
+
   int workerPoolSize = m_settings.workerPoolSize;
   for (int i = 0; i < workerPoolSize; i++)
     m_workerThreads.append(Thread::invoke("Assets::workerMain", mem_fn(&Assets::workerMain), this));
@@ -662,13 +667,10 @@ void Assets::clearCache() {
   MutexLocker assetsLocker(m_assetsMutex);
 
   // Clear all assets that are not queued or broken.
-  auto it = makeSMutableMapIterator(m_assetsCache);
-  while (it.hasNext()) {
-    auto const& pair = it.next();
-    // Don't clean up queued, persistent, or broken assets.
-    if (pair.second && !pair.second->shouldPersist() && !m_queue.contains(pair.first))
-      it.remove();
-  }
+  m_assetsCache.removeWhere([&](AssetId const& id, shared_ptr<AssetData> const& asset) {
+      // Don't clean up queued, persistent, or broken assets.
+      return asset && !asset->shouldPersist() && !m_queue.contains(id);
+    });
 }
 
 void Assets::cleanup() {
@@ -676,21 +678,80 @@ void Assets::cleanup() {
 
   double time = Time::monotonicTime();
 
-  auto it = makeSMutableMapIterator(m_assetsCache);
-  while (it.hasNext()) {
-    auto pair = it.next();
-    // Don't clean up broken assets or queued assets.
-    if (pair.second && !m_queue.contains(pair.first)) {
-      double liveTime = time - pair.second->time;
-      if (liveTime > m_settings.assetTimeToLive) {
-        // If the asset should persist, just refresh the access time.
-        if (pair.second->shouldPersist())
-          pair.second->time = time;
-        else
-          it.remove();
+  m_assetsCache.removeWhere([&](AssetId const& id, shared_ptr<AssetData> const& asset) {
+      // Don't clean up broken assets or queued assets.
+      if (asset && !m_queue.contains(id)) {
+        double liveTime = time - asset->time;
+        if (liveTime > m_settings.assetTimeToLive) {
+          // If the asset should persist, just refresh the access time.
+          if (asset->shouldPersist())
+            asset->time = time;
+          else
+            return true;
+        }
+      }
+      return false;
+    });
+}
+
+auto Assets::AssetCache::find(AssetId const& id, size_t idHash) const -> Maybe<shared_ptr<AssetData>> {
+  auto& stripe = m_stripes[idHash % StripeCount];
+  MutexLocker stripeLocker(stripe.mutex);
+  if (auto entries = stripe.assets.ptr(idHash)) {
+    for (auto const& entry : *entries) {
+      if (entry.first == id) {
+        if (entry.second)
+          entry.second->time = Time::monotonicTime();
+        return entry.second;
       }
     }
   }
+  return {};
+}
+
+auto Assets::AssetCache::find(AssetId const& id) const -> Maybe<shared_ptr<AssetData>> {
+  return find(id, AssetIdHash()(id));
+}
+
+void Assets::AssetCache::set(AssetId const& id, shared_ptr<AssetData> asset, bool postProcessed) {
+  size_t idHash = AssetIdHash()(id);
+  auto& stripe = m_stripes[idHash % StripeCount];
+  MutexLocker stripeLocker(stripe.mutex);
+  if (postProcessed) {
+    asset->needsPostProcessing = false;
+    asset->time = Time::monotonicTime();
+  }
+  auto& entries = stripe.assets[idHash];
+  for (auto& entry : entries) {
+    if (entry.first == id) {
+      entry.second = std::move(asset);
+      return;
+    }
+  }
+  entries.append({id, std::move(asset)});
+}
+
+void Assets::AssetCache::clear() {
+  for (auto& stripe : m_stripes) {
+    MutexLocker stripeLocker(stripe.mutex);
+    stripe.assets.clear();
+  }
+}
+
+void Assets::AssetCache::removeWhere(function<bool(AssetId const&, shared_ptr<AssetData> const&)> const& filter) {
+  for (auto& stripe : m_stripes) {
+    MutexLocker stripeLocker(stripe.mutex);
+    eraseWhere(stripe.assets, [&](auto& pair) {
+        pair.second.filter([&](auto const& entry) {
+            return !filter(entry.first, entry.second);
+          });
+        return pair.second.empty();
+      });
+  }
+}
+
+size_t Assets::AssetCache::IdentityHash::operator()(size_t idHash) const {
+  return idHash;
 }
 
 bool Assets::AssetId::operator==(AssetId const& assetId) const {
@@ -822,11 +883,7 @@ void Assets::queueAssets(List<AssetId> const& assetIds) const {
 }
 
 void Assets::queueAsset(AssetId const& assetId) const {
-  auto i = m_assetsCache.find(assetId);
-  if (i != m_assetsCache.end()) {
-    if (i->second)
-      freshen(i->second);
-  } else {
+  if (!m_assetsCache.find(assetId)) {
     auto j = m_queue.find(assetId);
     if (j == m_queue.end()) {
       m_queue[assetId] = QueuePriority::Load;
@@ -836,16 +893,22 @@ void Assets::queueAsset(AssetId const& assetId) const {
 }
 
 shared_ptr<Assets::AssetData> Assets::tryAsset(AssetId const& id) const {
+  size_t idHash = AssetIdHash()(id);
+  if (auto asset = m_assetsCache.find(id, idHash)) {
+    if (*asset)
+      return *asset;
+    else
+      throw AssetException::format("Error loading asset {}", id.path);
+  }
+
   MutexLocker assetsLocker(m_assetsMutex);
 
-  auto i = m_assetsCache.find(id);
-  if (i != m_assetsCache.end()) {
-    if (i->second) {
-      freshen(i->second);
-      return i->second;
-    } else {
+  // The asset may have finished loading before the lock was taken
+  if (auto asset = m_assetsCache.find(id, idHash)) {
+    if (*asset)
+      return *asset;
+    else
       throw AssetException::format("Error loading asset {}", id.path);
-    }
   } else {
     auto j = m_queue.find(id);
     if (j == m_queue.end()) {
@@ -857,18 +920,22 @@ shared_ptr<Assets::AssetData> Assets::tryAsset(AssetId const& id) const {
 }
 
 shared_ptr<Assets::AssetData> Assets::getAsset(AssetId const& id) const {
+  size_t idHash = AssetIdHash()(id);
+  if (auto asset = m_assetsCache.find(id, idHash)) {
+    if (*asset)
+      return *asset;
+    else
+      throw AssetException::format("Error loading asset {}", id.path);
+  }
+
   MutexLocker assetsLocker(m_assetsMutex);
 
   while (true) {
-    auto j = m_assetsCache.find(id);
-    if (j != m_assetsCache.end()) {
-      if (j->second) {
-        auto asset = j->second;
-        freshen(asset);
-        return asset;
-      } else {
+    if (auto asset = m_assetsCache.find(id, idHash)) {
+      if (*asset)
+        return *asset;
+      else
         throw AssetException::format("Error loading asset {}", id.path);
-      }
     } else {
       // Try to load the asset in-thread, if we cannot, then the asset has been
       // queued so wait for a worker thread to finish it.
@@ -1001,6 +1068,60 @@ FramesSpecificationConstPtr Assets::bestFramesSpecification(String const& image)
   return framesSpecification;
 }
 
+Maybe<List<pair<AssetSourcePtr, String>>> Assets::imageSourceFiles(AssetPath const& path, StringList const& references) const {
+  List<pair<AssetSourcePtr, String>> files;
+  auto addFile = [&](String const& assetPath) {
+    auto descriptor = m_files.ptr(assetPath);
+    if (!descriptor || as<MemoryAssetSource>(descriptor->source))
+      return false;
+    files.append({descriptor->source, descriptor->sourceName});
+    for (auto const& patch : descriptor->patchSources) {
+      if (as<MemoryAssetSource>(patch.second))
+        return false;
+      files.append({patch.second, patch.first});
+    }
+    return true;
+  };
+
+  auto addImage = [&](AssetPath const& imagePath) {
+    if (!addFile(imagePath.basePath))
+      return false;
+    if (imagePath.subPath) {
+      if (auto frames = bestFramesSpecification(imagePath.basePath))
+        return addFile(frames->framesFile);
+    }
+    return true;
+  };
+
+  if (!addImage(path))
+    return {};
+  for (auto const& reference : references) {
+    if (!addImage(AssetPath::split(reference)))
+      return {};
+  }
+  return files;
+}
+
+uint64_t Assets::digestSourceFiles(List<pair<AssetSourcePtr, String>> const& files) const {
+  XXHash3 hasher;
+  for (auto const& file : files) {
+    Maybe<uint64_t> fileDigest;
+    {
+      MutexLocker digestsLocker(m_sourceDigestsMutex);
+      fileDigest = m_sourceDigests.maybe(file);
+    }
+    if (!fileDigest) {
+      ByteArray contents = file.first->read(file.second);
+      fileDigest = xxHash3(contents.ptr(), contents.size());
+      MutexLocker digestsLocker(m_sourceDigestsMutex);
+      m_sourceDigests[file] = *fileDigest;
+    }
+    hasher.push(file.second.utf8Ptr(), file.second.utf8Size());
+    hasher.push((char const*)&*fileDigest, sizeof(uint64_t));
+  }
+  return hasher.digest();
+}
+
 IODevicePtr Assets::open(String const& path) const {
   if (auto p = m_files.ptr(path))
     return p->source->open(p->sourceName);
@@ -1163,7 +1284,7 @@ bool Assets::doLoad(AssetId const& id) const {
 
   // There was an exception, remove the asset from the queue and fill the cache
   // with null so that getAsset will throw.
-  m_assetsCache[id] = {};
+  m_assetsCache.set(id, {});
   m_assetsDone.broadcast();
   m_queue.remove(id);
   return true;
@@ -1172,7 +1293,7 @@ bool Assets::doLoad(AssetId const& id) const {
 bool Assets::doPost(AssetId const& id) const {
   shared_ptr<AssetData> assetData;
   try {
-    assetData = m_assetsCache.get(id);
+    assetData = m_assetsCache.find(id).value();
     if (id.type == AssetType::Audio)
       assetData = postProcessAudio(assetData);
   } catch (std::exception const& e) {
@@ -1183,9 +1304,9 @@ bool Assets::doPost(AssetId const& id) const {
 
   m_queue.remove(id);
   if (assetData) {
-    assetData->needsPostProcessing = false;
-    m_assetsCache[id] = assetData;
-    freshen(assetData);
+    // The post processed asset may be the cached original, so the cache must
+    // update it under the lock readers freshen it with.
+    m_assetsCache.set(id, std::move(assetData), true);
     m_assetsDone.broadcast();
   }
 
@@ -1193,7 +1314,7 @@ bool Assets::doPost(AssetId const& id) const {
 }
 
 shared_ptr<Assets::AssetData> Assets::loadAsset(AssetId const& id) const {
-  if (auto asset = m_assetsCache.value(id))
+  if (auto asset = m_assetsCache.find(id).value())
     return asset;
 
   if (m_queue.value(id, QueuePriority::None) == QueuePriority::Working)
@@ -1233,9 +1354,11 @@ shared_ptr<Assets::AssetData> Assets::loadAsset(AssetId const& id) const {
         m_queue[id] = QueuePriority::PostProcess;
       else
         m_queue.remove(id);
-      m_assetsCache[id] = assetData;
-      m_assetsDone.broadcast();
+      // Freshened before it is visible to readers, which freshen it with
+      // only the cache stripe locked
       freshen(assetData);
+      m_assetsCache.set(id, assetData);
+      m_assetsDone.broadcast();
 
     } else {
       // We have failed to load an asset because it depends on an asset
@@ -1250,7 +1373,7 @@ shared_ptr<Assets::AssetData> Assets::loadAsset(AssetId const& id) const {
 
   } catch (...) {
     m_queue.remove(id);
-    m_assetsCache[id] = {};
+    m_assetsCache.set(id, {});
     m_assetsDone.broadcast();
     throw;
   }
@@ -1288,10 +1411,6 @@ shared_ptr<Assets::AssetData> Assets::loadJson(AssetPath const& path) const {
 shared_ptr<Assets::AssetData> Assets::loadImage(AssetPath const& path) const {
   validatePath(path, true, true);
   if (!path.directives.empty()) {
-    shared_ptr<ImageData> source =
-        as<ImageData>(loadAsset(AssetId{AssetType::Image, {path.basePath, path.subPath, {}}}));
-    if (!source)
-      return {};
     StringMap<ImageConstPtr> references;
     StringList referencePaths;
 
@@ -1302,6 +1421,28 @@ shared_ptr<Assets::AssetData> Assets::loadImage(AssetPath const& path) const {
       addImageOperationReferences(entry.operation, referencePaths);
     }); // TODO: This can definitely be better, was changed quickly to support the new Directives.
 
+    String cacheKey;
+    Maybe<uint64_t> sourceDigest;
+    if (m_processedImageCache) {
+      if (auto sourceFiles = imageSourceFiles(path, referencePaths)) {
+        cacheKey = AssetPath::join(path);
+        auto cachedImage = unlockDuring([&]() {
+          sourceDigest = digestSourceFiles(*sourceFiles);
+          return m_processedImageCache->get(cacheKey, *sourceDigest);
+        });
+        if (cachedImage) {
+          auto newData = make_shared<ImageData>();
+          newData->image = std::move(cachedImage);
+          return newData;
+        }
+      }
+    }
+
+    shared_ptr<ImageData> source =
+        as<ImageData>(loadAsset(AssetId{AssetType::Image, {path.basePath, path.subPath, {}}}));
+    if (!source)
+      return {};
+
 
     for (auto const& ref : referencePaths) {
       auto components = AssetPath::split(ref);
@@ -1315,6 +1456,8 @@ shared_ptr<Assets::AssetData> Assets::loadImage(AssetPath const& path) const {
     return unlockDuring([&]() {
       auto newData = make_shared<ImageData>();
       auto newImage = path.directives.applyNewImage(*source->image, [&](String const& ref) { return references.get(ref).get(); });
+      if (sourceDigest)
+        m_processedImageCache->set(cacheKey, *sourceDigest, newImage);
       newData->image = make_shared<Image>(std::move(newImage));
       return newData;
     });
@@ -16,6 +16,7 @@ STAR_CLASS(Audio);
 STAR_CLASS(Image);
 STAR_STRUCT(FramesSpecification);
 STAR_CLASS(Assets);
+STAR_CLASS(ProcessedImageCache);
 
 STAR_CLASS(LuaContext);
 
@@ -69,6 +70,11 @@ public:
     // Same, but only ignores the file for the purposes of calculating the
     // digest.
     StringList digestIgnore;
+
+    // If given, images with directives applied to them are kept in this file
+    // between runs, which is kept under processedImageCacheSize bytes.
+    Maybe<String> processedImageCache;
+    uint64_t processedImageCacheSize;
   };
 
   enum class QueuePriority {
@@ -105,7 +111,9 @@ public:
     // the cache.
     virtual bool shouldPersist() const = 0;
 
-    double time = 0.0;
+    // Freshened by readers holding only a cache stripe lock, so it may be
+    // touched from several threads at once.
+    atomic<double> time{0.0};
     bool needsPostProcessing = false;
     bool forcePersist = false;
   };
@@ -264,6 +272,46 @@ private:
       {AssetType::Bytes, "bytes"}
   };
 
+  // Loaded assets, split into separately locked stripes so that looking up
+  // an asset that is already loaded never has to take the assets mutex.  The
+  // cache is still only ever modified with the assets mutex held, the stripe
+  // locks only guard against concurrent readers.
+  class AssetCache {
+  public:
+    // Returns nothing if the asset is not cached, and a null pointer if it is
+    // cached as having failed to load.  Freshens assets that are found.
+    // 'idHash' must be the AssetIdHash of the id.
+    Maybe<shared_ptr<AssetData>> find(AssetId const& id, size_t idHash) const;
+    Maybe<shared_ptr<AssetData>> find(AssetId const& id) const;
+
+    // If 'postProcessed' is set, the asset has finished post processing, and
+    // its post-processing flag is cleared and it is freshened with the stripe
+    // locked, as it may be the one already visible to readers.
+    void set(AssetId const& id, shared_ptr<AssetData> asset, bool postProcessed = false);
+    void clear();
+    // Removes every asset for which the filter returns true, with the stripe
+    // the asset is in locked.
+    void removeWhere(function<bool(AssetId const&, shared_ptr<AssetData> const&)> const& filter);
+
+  private:
+    // A prime number of stripes keeps both the choice of stripe and the
+    // buckets within each stripe well distributed, even though they both come
+    // from the same hash.
+    static size_t const StripeCount = 31;
+
+    // Asset ids within a stripe are keyed by their already computed hash
+    struct IdentityHash {
+      size_t operator()(size_t idHash) const;
+    };
+
+    struct Stripe {
+      mutable Mutex mutex;
+      HashMap<size_t, List<pair<AssetId, shared_ptr<AssetData>>>, IdentityHash> assets;
+    };
+
+    std::array<Stripe, StripeCount> m_stripes;
+  };
+
   static FramesSpecification parseFramesSpecification(Json const& frameConfig, String path);
 
   void queueAssets(List<AssetId> const& assetIds) const;
@@ -285,6 +333,14 @@ private:
   // Returns the best frames specification for the given image path, if it exists.
   FramesSpecificationConstPtr bestFramesSpecification(String const& basePath) const;
 
+  // The asset files that an image with directives is produced from, which
+  // are its base image and every referenced image, along with their patches
+  // and frames files.  Returns nothing if any of them only exist in memory.
+  Maybe<List<pair<AssetSourcePtr, String>>> imageSourceFiles(AssetPath const& path, StringList const& references) const;
+  // Does not need the asset mutex locked.  The digest of each file is only
+  // calculated the first time it is needed.
+  uint64_t digestSourceFiles(List<pair<AssetSourcePtr, String>> const& files) const;
+
   IODevicePtr open(String const& basePath) const;
   ByteArray read(String const& basePath) const;
   ImageConstPtr readImage(String const& path) const;
@@ -326,7 +382,7 @@ private:
   mutable OrderedHashMap<AssetId, QueuePriority, AssetIdHash> m_queue;
 
   mutable ConditionVariable m_assetsDone;
-  mutable HashMap<AssetId, shared_ptr<AssetData>, AssetIdHash> m_assetsCache;
+  mutable AssetCache m_assetsCache;
 
   mutable StringMap<String> m_bestFramesFiles;
   mutable StringMap<FramesSpecificationConstPtr> m_framesSpecifications;
@@ -349,6 +405,10 @@ private:
 
   ByteArray m_digest;
 
+  ProcessedImageCachePtr m_processedImageCache;
+  mutable Mutex m_sourceDigestsMutex;
+  mutable HashMap<pair<AssetSourcePtr, String>, uint64_t> m_sourceDigests;
+
   List<ThreadFunction<void>> m_workerThreads;
   atomic<bool> m_stopThreads;
 };
@@ -2,8 +2,141 @@
 #include "StarInterpolation.hpp"
 // just specializing these in a cpp file so I can iterate on them without recompiling like 40 files!!
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_LIGHT_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Star {
 
+namespace {
+  // Takes the max of dest[i] and source[i] - dropoff[i] for every i in [0, count).
+  void spreadScalarSpan(float const* source, float* dest, float const* dropoff, size_t count) {
+    size_t i = 0;
+#ifdef STAR_LIGHT_SSE2
+    for (; i + 4 <= count; i += 4) {
+      __m128 spread = _mm_sub_ps(_mm_loadu_ps(source + i), _mm_loadu_ps(dropoff + i));
+      _mm_storeu_ps(dest + i, _mm_max_ps(spread, _mm_loadu_ps(dest + i)));
+    }
+#endif
+    for (; i < count; ++i)
+      dest[i] = std::max(source[i] - dropoff[i], dest[i]);
+  }
+
+  // Colored version of spreadScalarSpan, but each channel is dropped by
+  // dropScale[i] times its own value rather than by a constant, which keeps the
+  // color ratios the same.  Cells with a drop scale of zero spread nothing.
+  void spreadColoredSpan(float const* const* source, float* const* dest, float const* dropScale, size_t count) {
+    size_t i = 0;
+#ifdef STAR_LIGHT_SSE2
+    __m128 const zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+      __m128 drop = _mm_loadu_ps(dropScale + i);
+      __m128 lit = _mm_cmpgt_ps(drop, zero);
+      for (size_t c = 0; c < 3; ++c) {
+        __m128 s = _mm_loadu_ps(source[c] + i);
+        __m128 d = _mm_loadu_ps(dest[c] + i);
+        __m128 spread = _mm_max_ps(_mm_sub_ps(s, _mm_mul_ps(s, drop)), d);
+        _mm_storeu_ps(dest[c] + i, _mm_or_ps(_mm_and_ps(lit, spread), _mm_andnot_ps(lit, d)));
+      }
+    }
+#endif
+    for (; i < count; ++i) {
+      if (dropScale[i] <= 0.0f)
+        continue;
+      for (size_t c = 0; c < 3; ++c)
+        dest[c][i] = std::max(source[c][i] - source[c][i] * dropScale[i], dest[c][i]);
+    }
+  }
+
+  // Computes the proportional drop scale of every light for spreadColoredSpan,
+  // the same as ColoredLightTraits::spread, or zero for unlit cells.
+  void coloredDropScale(float const* const* source, float const* dropoff, float* dropScale, size_t count) {
+    size_t i = 0;
+#ifdef STAR_LIGHT_SSE2
+    __m128 const zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+      __m128 maxChannel = _mm_max_ps(_mm_loadu_ps(source[0] + i), _mm_max_ps(_mm_loadu_ps(source[1] + i), _mm_loadu_ps(source[2] + i)));
+      __m128 lit = _mm_cmpgt_ps(maxChannel, zero);
+      // Unlit cells divide by zero here, but are masked out.
+      __m128 drop = _mm_div_ps(_mm_loadu_ps(dropoff + i), maxChannel);
+      _mm_storeu_ps(dropScale + i, _mm_and_ps(lit, drop));
+    }
+#endif
+    for (; i < count; ++i) {
+      float maxChannel = std::max(source[0][i], std::max(source[1][i], source[2][i]));
+      dropScale[i] = maxChannel > 0.0f ? dropoff[i] / maxChannel : 0.0f;
+    }
+  }
+}
+
+void ScalarLightTraits::spreadColumn(float* const* column, float const* dropoff, size_t begin, size_t end, bool up) {
+  float* light = column[0];
+  if (up) {
+    for (size_t y = begin; y < end; ++y)
+      light[y + 1] = spread(light[y], light[y + 1], dropoff[y]);
+  } else {
+    for (size_t y = end; y > begin; --y)
+      light[y - 2] = spread(light[y - 1], light[y - 2], dropoff[y - 1]);
+  }
+}
+
+void ScalarLightTraits::spreadAcross(float* const* source, float* const* dest,
+    float const* straightDropoff, float const* diagDropoff, size_t begin, size_t end) {
+  size_t count = end - begin;
+  spreadScalarSpan(source[0] + begin, dest[0] + begin, straightDropoff + begin, count);
+  spreadScalarSpan(source[0] + begin, dest[0] + begin + 1, diagDropoff + begin, count);
+  spreadScalarSpan(source[0] + begin, dest[0] + begin - 1, diagDropoff + begin, count);
+}
+
+void ColoredLightTraits::spreadColumn(float* const* column, float const* dropoff, size_t begin, size_t end, bool up) {
+  float* r = column[0];
+  float* g = column[1];
+  float* b = column[2];
+  auto spreadCell = [&](size_t source, size_t dest, float drop) {
+    float maxChannel = std::max(r[source], std::max(g[source], b[source]));
+    if (maxChannel <= 0.0f)
+      return;
+
+    drop /= maxChannel;
+    r[dest] = std::max(r[source] - r[source] * drop, r[dest]);
+    g[dest] = std::max(g[source] - g[source] * drop, g[dest]);
+    b[dest] = std::max(b[source] - b[source] * drop, b[dest]);
+  };
+
+  if (up) {
+    for (size_t y = begin; y < end; ++y)
+      spreadCell(y, y + 1, dropoff[y]);
+  } else {
+    for (size_t y = end; y > begin; --y)
+      spreadCell(y - 1, y - 2, dropoff[y - 1]);
+  }
+}
+
+void ColoredLightTraits::spreadAcross(float* const* source, float* const* dest,
+    float const* straightDropoff, float const* diagDropoff, size_t begin, size_t end) {
+  // Work in fixed size blocks so the drop scales can live on the stack.
+  size_t const BlockSize = 256;
+  float straightScale[BlockSize];
+  float diagScale[BlockSize];
+
+  for (size_t blockBegin = begin; blockBegin < end; blockBegin += BlockSize) {
+    size_t count = std::min(BlockSize, end - blockBegin);
+    float const* sourceSpan[3] = {source[0] + blockBegin, source[1] + blockBegin, source[2] + blockBegin};
+    coloredDropScale(sourceSpan, straightDropoff + blockBegin, straightScale, count);
+    coloredDropScale(sourceSpan, diagDropoff + blockBegin, diagScale, count);
+
+    float* destSpan[3] = {dest[0] + blockBegin, dest[1] + blockBegin, dest[2] + blockBegin};
+    spreadColoredSpan(sourceSpan, destSpan, straightScale, count);
+
+    float* destUpSpan[3] = {destSpan[0] + 1, destSpan[1] + 1, destSpan[2] + 1};
+    spreadColoredSpan(sourceSpan, destUpSpan, diagScale, count);
+
+    float* destDownSpan[3] = {destSpan[0] - 1, destSpan[1] - 1, destSpan[2] - 1};
+    spreadColoredSpan(sourceSpan, destDownSpan, diagScale, count);
+  }
+}
+
 template <>
 void CellularLightArray<ScalarLightTraits>::calculatePointLighting(size_t xmin, size_t ymin, size_t xmax, size_t ymax) {
   float pointPerBlockObstacleAttenuation = 1.0f / m_pointMaxObstacle;
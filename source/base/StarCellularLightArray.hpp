@@ -9,6 +9,10 @@ namespace Star {
 struct ScalarLightTraits {
   typedef float Value;
 
+  // Number of float channels in a light value, when light values are stored as
+  // a structure of arrays with one array per channel.
+  static size_t const Channels = 1;
+
   static float spread(float source, float dest, float drop);
   static float subtract(float value, float drop);
   static float multiply(float v1, float v2);
@@ -17,6 +21,20 @@ struct ScalarLightTraits {
   static float minIntensity(float value);
 
   static float max(float v1, float v2);
+
+  static float load(float* const* channels, size_t i);
+  static void store(float* const* channels, size_t i, float value);
+
+  // Spreads light along a single column of cells, in order, from each cell in
+  // [begin, end) to the cell after it if 'up' is true, or to the cell before it
+  // otherwise, starting from the last cell.
+  static void spreadColumn(float* const* column, float const* dropoff, size_t begin, size_t end, bool up);
+
+  // Spreads light from each cell in [begin, end) of the source column to the
+  // same cell in the destination column, and diagonally to the cells above and
+  // below it.  Every destination cell is independent, so this is vectorized.
+  static void spreadAcross(float* const* source, float* const* dest,
+      float const* straightDropoff, float const* diagDropoff, size_t begin, size_t end);
 };
 
 // Operations for 3 component (colored) lighting.  Spread and subtract are
@@ -33,6 +51,15 @@ struct ColoredLightTraits {
   static float minIntensity(Vec3F const& value);
 
   static Vec3F max(Vec3F const& v1, Vec3F const& v2);
+
+  static size_t const Channels = 3;
+
+  static Vec3F load(float* const* channels, size_t i);
+  static void store(float* const* channels, size_t i, Vec3F const& value);
+
+  static void spreadColumn(float* const* column, float const* dropoff, size_t begin, size_t end, bool up);
+  static void spreadAcross(float* const* source, float* const* dest,
+      float const* straightDropoff, float const* diagDropoff, size_t begin, size_t end);
 };
 
 template <typename LightTraits>
@@ -71,6 +98,17 @@ public:
   // existing light and collision data.
   void begin(size_t newWidth, size_t newHeight);
 
+  // Begin a new calculation over the columns [xMin, xMax) of another array,
+  // copying its parameters, cell data and light sources, with the light
+  // positions moved into the index space of this array.
+  void beginColumns(CellularLightArray const& source, size_t xMin, size_t xMax);
+
+  // Widens the columns [xMin, xMax) to take in every point light that can
+  // light a cell in them, and the cells between the light and those columns
+  // that attenuate it, so that calculating a copy of the widened columns gives
+  // the same point lighting in the original ones.
+  void pointLightColumns(size_t& xMin, size_t& xMax) const;
+
   // Position is in index space, spread lights will have no effect if they are
   // outside of the array.  Integer points are assumed to be on the corners of
   // the grid (not the center)
@@ -105,7 +143,9 @@ private:
   // attenuation.
   void setSpreadLightingPoints();
 
-  // Spreads light out in an octagonal based cellular automata
+  // Spreads light out in an octagonal based cellular automata.  The spread
+  // region is copied out to m_spreadBuffer first so that the passes can work
+  // on whole columns at a time.
   void calculateLightSpread(size_t xmin, size_t ymin, size_t xmax, size_t ymax);
 
   // Loops through each light and adds light strength based on distance and
@@ -123,6 +163,11 @@ private:
   List<SpreadLight> m_spreadLights;
   List<PointLight> m_pointLights;
 
+  // Structure of arrays copy of the region being spread, one column major
+  // array per light channel followed by the straight and diagonal dropoff of
+  // every cell.
+  List<float> m_spreadBuffer;
+
   unsigned m_spreadPasses;
   float m_spreadMaxAir;
   float m_spreadMaxObstacle;
@@ -203,6 +248,24 @@ inline Vec3F ColoredLightTraits::max(Vec3F const& v1, Vec3F const& v2) {
   return vmax(v1, v2);
 }
 
+inline float ScalarLightTraits::load(float* const* channels, size_t i) {
+  return channels[0][i];
+}
+
+inline void ScalarLightTraits::store(float* const* channels, size_t i, float value) {
+  channels[0][i] = value;
+}
+
+inline Vec3F ColoredLightTraits::load(float* const* channels, size_t i) {
+  return Vec3F(channels[0][i], channels[1][i], channels[2][i]);
+}
+
+inline void ColoredLightTraits::store(float* const* channels, size_t i, Vec3F const& value) {
+  channels[0][i] = value[0];
+  channels[1][i] = value[1];
+  channels[2][i] = value[2];
+}
+
 template <typename LightTraits>
 void CellularLightArray<LightTraits>::setParameters(unsigned spreadPasses, float spreadMaxAir, float spreadMaxObstacle,
     float pointMaxAir, float pointMaxObstacle, float pointObstacleBoost, bool pointAdditive) {
@@ -237,6 +300,50 @@ void CellularLightArray<LightTraits>::begin(size_t newWidth, size_t newHeight) {
   }
 }
 
+template <typename LightTraits>
+void CellularLightArray<LightTraits>::beginColumns(CellularLightArray const& source, size_t xMin, size_t xMax) {
+  starAssert(xMin < xMax && xMax <= source.m_width);
+
+  setParameters(source.m_spreadPasses, source.m_spreadMaxAir, source.m_spreadMaxObstacle,
+      source.m_pointMaxAir, source.m_pointMaxObstacle, source.m_pointObstacleBoost, source.m_pointAdditive);
+
+  size_t newWidth = xMax - xMin;
+  if (!m_cells || newWidth != m_width || source.m_height != m_height) {
+    m_width = newWidth;
+    m_height = source.m_height;
+    m_cells.reset(new Cell[m_width * m_height]);
+  }
+  // Cells are stored column major, so the columns are one contiguous range.
+  std::copy(source.m_cells.get() + xMin * m_height, source.m_cells.get() + xMax * m_height, m_cells.get());
+
+  Vec2F offset((float)xMin, 0.0f);
+  m_spreadLights.clear();
+  for (auto const& spreadLight : source.m_spreadLights)
+    m_spreadLights.append({spreadLight.position - offset, spreadLight.value});
+  m_pointLights.clear();
+  for (auto pointLight : source.m_pointLights) {
+    pointLight.position -= offset;
+    m_pointLights.append(pointLight);
+  }
+}
+
+template <typename LightTraits>
+void CellularLightArray<LightTraits>::pointLightColumns(size_t& xMin, size_t& xMax) const {
+  for (auto const& light : m_pointLights) {
+    // Lights outside of the array are ignored by calculatePointLighting
+    if (light.position[0] < 0 || light.position[0] > m_width - 1 || light.position[1] < 0 || light.position[1] > m_height - 1)
+      continue;
+
+    // Limited both by the light's intensity and by air attenuation alone
+    float maxAir = light.asSpread ? m_spreadMaxAir : m_pointMaxAir;
+    float reach = min(LightTraits::maxIntensity(light.value) * maxAir, maxAir);
+    if (light.position[0] + reach > xMin && light.position[0] - reach < xMax) {
+      xMin = min<size_t>(xMin, std::floor(light.position[0]));
+      xMax = max<size_t>(xMax, std::ceil(light.position[0]) + 1);
+    }
+  }
+}
+
 template <typename LightTraits>
 void CellularLightArray<LightTraits>::addSpreadLight(SpreadLight const& spreadLight) {
   m_spreadLights.append(spreadLight);
@@ -351,53 +458,67 @@ void CellularLightArray<LightTraits>::calculateLightSpread(size_t xMin, size_t y
   xMax = min(m_width, xMax + (size_t)ceil(m_spreadMaxAir));
   yMax = min(m_height, yMax + (size_t)ceil(m_spreadMaxAir));
 
+  if (m_spreadPasses == 0 || xMax < xMin + 3 || yMax < yMin + 3)
+    return;
+
+  size_t const Channels = LightTraits::Channels;
+  size_t width = xMax - xMin;
+  size_t height = yMax - yMin;
+  size_t planeSize = width * height;
+  m_spreadBuffer.resize(planeSize * (Channels + 2));
+
+  float* channels[Channels];
+  for (size_t c = 0; c < Channels; ++c)
+    channels[c] = m_spreadBuffer.ptr() + planeSize * c;
+  float* straightDropoff = m_spreadBuffer.ptr() + planeSize * Channels;
+  float* diagDropoff = straightDropoff + planeSize;
+
+  for (size_t x = 0; x < width; ++x) {
+    size_t cellOffset = (xMin + x) * m_height + yMin;
+    size_t spreadOffset = x * height;
+    for (size_t y = 0; y < height; ++y) {
+      auto const& cell = cellAtIndex(cellOffset + y);
+      LightTraits::store(channels, spreadOffset + y, cell.light);
+      straightDropoff[spreadOffset + y] = cell.obstacle ? dropoffObstacle : dropoffAir;
+      diagDropoff[spreadOffset + y] = cell.obstacle ? dropoffObstacleDiag : dropoffAirDiag;
+    }
+  }
+
+  // Light only ever spreads in one direction along a column during a pass, so
+  // each pass runs the serial spread along the column first and then spreads
+  // the finished column across into the next one, which is the same as
+  // spreading cell by cell since spreading only ever takes the max.
+  float* column[Channels];
+  float* nextColumn[Channels];
+  auto setColumns = [&](size_t x, size_t nextX) {
+    for (size_t c = 0; c < Channels; ++c) {
+      column[c] = channels[c] + x * height;
+      nextColumn[c] = channels[c] + nextX * height;
+    }
+  };
+
   for (unsigned p = 0; p < m_spreadPasses; ++p) {
     // Spread right and up and diag up right / diag down right
-    for (size_t x = xMin + 1; x < xMax - 1; ++x) {
-      size_t xCellOffset = x * m_height;
-      size_t xRightCellOffset = (x + 1) * m_height;
-
-      for (size_t y = yMin + 1; y < yMax - 1; ++y) {
-        auto cell = cellAtIndex(xCellOffset + y);
-        auto& cellRight = cellAtIndex(xRightCellOffset + y);
-        auto& cellUp = cellAtIndex(xCellOffset + y + 1);
-        auto& cellRightUp = cellAtIndex(xRightCellOffset + y + 1);
-        auto& cellRightDown = cellAtIndex(xRightCellOffset + y - 1);
-
-        float straightDropoff = cell.obstacle ? dropoffObstacle : dropoffAir;
-        float diagDropoff = cell.obstacle ? dropoffObstacleDiag : dropoffAirDiag;
-
-        cellRight.light = LightTraits::spread(cell.light, cellRight.light, straightDropoff);
-        cellUp.light = LightTraits::spread(cell.light, cellUp.light, straightDropoff);
-
-        cellRightUp.light = LightTraits::spread(cell.light, cellRightUp.light, diagDropoff);
-        cellRightDown.light = LightTraits::spread(cell.light, cellRightDown.light, diagDropoff);
-      }
+    for (size_t x = 1; x < width - 1; ++x) {
+      setColumns(x, x + 1);
+      LightTraits::spreadColumn(column, straightDropoff + x * height, 1, height - 1, true);
+      LightTraits::spreadAcross(column, nextColumn, straightDropoff + x * height, diagDropoff + x * height, 1, height - 1);
     }
 
     // Spread left and down and diag up left / diag down left
-    for (size_t x = xMax - 2; x > xMin; --x) {
-      size_t xCellOffset = x * m_height;
-      size_t xLeftCellOffset = (x - 1) * m_height;
-
-      for (size_t y = yMax - 2; y > yMin; --y) {
-        auto cell = cellAtIndex(xCellOffset + y);
-        auto& cellLeft = cellAtIndex(xLeftCellOffset + y);
-        auto& cellDown = cellAtIndex(xCellOffset + y - 1);
-        auto& cellLeftUp = cellAtIndex(xLeftCellOffset + y + 1);
-        auto& cellLeftDown = cellAtIndex(xLeftCellOffset + y - 1);
-
-        float straightDropoff = cell.obstacle ? dropoffObstacle : dropoffAir;
-        float diagDropoff = cell.obstacle ? dropoffObstacleDiag : dropoffAirDiag;
-
-        cellLeft.light = LightTraits::spread(cell.light, cellLeft.light, straightDropoff);
-        cellDown.light = LightTraits::spread(cell.light, cellDown.light, straightDropoff);
-
-        cellLeftUp.light = LightTraits::spread(cell.light, cellLeftUp.light, diagDropoff);
-        cellLeftDown.light = LightTraits::spread(cell.light, cellLeftDown.light, diagDropoff);
-      }
+    for (size_t x = width - 2; x > 0; --x) {
+      setColumns(x, x - 1);
+      LightTraits::spreadColumn(column, straightDropoff + x * height, 1, height - 1, false);
+      LightTraits::spreadAcross(column, nextColumn, straightDropoff + x * height, diagDropoff + x * height, 1, height - 1);
     }
   }
+
+  for (size_t x = 0; x < width; ++x) {
+    size_t cellOffset = (xMin + x) * m_height + yMin;
+    size_t spreadOffset = x * height;
+    for (size_t y = 0; y < height; ++y)
+      cellAtIndex(cellOffset + y).light = LightTraits::load(channels, spreadOffset + y);
+  }
 }
 
 template <typename LightTraits>
@@ -42,7 +42,7 @@ Lightmap::operator ImageView() {
 }
 
 CellularLightingCalculator::CellularLightingCalculator(bool monochrome)
-    : m_monochrome(monochrome)
+    : m_monochrome(monochrome), m_threadCount(1)
 {
     if (monochrome)
         m_lightArray.setRight(ScalarCellularLightArray());
@@ -50,6 +50,70 @@ CellularLightingCalculator::CellularLightingCalculator(bool monochrome)
         m_lightArray.setLeft(ColoredCellularLightArray());
 }
 
+template <typename LightArray, typename OutputFunction>
+void CellularLightingCalculator::calculateStrips(LightArray& lightArray, List<LightArray>& strips, OutputFunction&& output) {
+  Vec2S arrayMin = Vec2S(m_queryRegion.min() - m_calculationRegion.min());
+  Vec2S arrayMax = Vec2S(m_queryRegion.max() - m_calculationRegion.min());
+
+  size_t queryWidth = arrayMax[0] - arrayMin[0];
+  size_t stripCount = clamp<size_t>(queryWidth / MinimumStripWidth, 1, m_threadCount);
+
+  if (stripCount == 1) {
+    lightArray.calculate(arrayMin[0], arrayMin[1], arrayMax[0], arrayMax[1]);
+    for (size_t x = arrayMin[0]; x < arrayMax[0]; ++x) {
+      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y)
+        output(x - arrayMin[0], y - arrayMin[1], lightArray.getLight(x, y));
+    }
+    return;
+  }
+
+  // Every strip is calculated with the border on either side of it included
+  // in its query region, and copied out along with the border around that,
+  // so the strips overlap by twice the border.  Colored light spreads
+  // proportionally, so the dimmer channels of a cell can travel as far as its
+  // brightest channel does from wherever that came from, and the extra overlap
+  // is what keeps that from changing the light at the strip edges.
+  size_t border = arrayMin[0];
+  strips.resize(stripCount);
+
+  auto calculateStrip = [&](size_t i) {
+    size_t stripMin = arrayMin[0] + queryWidth * i / stripCount;
+    size_t stripMax = arrayMin[0] + queryWidth * (i + 1) / stripCount;
+    size_t calculateMin = max<size_t>(stripMin - border, arrayMin[0]);
+    size_t calculateMax = min<size_t>(stripMax + border, arrayMax[0]);
+    size_t columnMin = calculateMin - border;
+    size_t columnMax = calculateMax + border;
+    // Point lights are only limited by their own reach, not by the border.
+    lightArray.pointLightColumns(columnMin, columnMax);
+
+    auto& strip = strips[i];
+    strip.beginColumns(lightArray, columnMin, columnMax);
+    strip.calculate(calculateMin - columnMin, arrayMin[1], calculateMax - columnMin, arrayMax[1]);
+    for (size_t x = stripMin; x < stripMax; ++x) {
+      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y)
+        output(x - arrayMin[0], y - arrayMin[1], strip.getLight(x - columnMin, y));
+    }
+  };
+
+  // Queued strips refer to this stack frame, so they must all be finished
+  // before leaving it, even if calculating a strip throws.
+  List<WorkerPoolHandle> handles;
+  auto finishStrips = finally([&handles]() {
+      for (auto const& handle : handles) {
+        try {
+          handle.finish();
+        } catch (...) {
+        }
+      }
+    });
+
+  for (size_t i = 1; i < stripCount; ++i)
+    handles.append(m_workerPool->addWork([&calculateStrip, i]() { calculateStrip(i); }));
+  calculateStrip(0);
+  for (auto const& handle : handles)
+    handle.finish();
+}
+
 void CellularLightingCalculator::setMonochrome(bool monochrome) {
   if (monochrome == m_monochrome)
     return;
@@ -88,6 +152,25 @@ void CellularLightingCalculator::setParameters(Json const& config) {
       );
 }
 
+void CellularLightingCalculator::setThreadCount(unsigned threadCount) {
+  threadCount = max(threadCount, 1u);
+  if (threadCount == m_threadCount)
+    return;
+
+  m_threadCount = threadCount;
+  // The calling thread always calculates one of the strips itself.
+  if (m_threadCount == 1)
+    m_workerPool.reset();
+  else if (m_workerPool)
+    m_workerPool->start(m_threadCount - 1);
+  else
+    m_workerPool = make_unique<WorkerPool>("CellularLightingCalculator", m_threadCount - 1);
+}
+
+unsigned CellularLightingCalculator::threadCount() const {
+  return m_threadCount;
+}
+
 void CellularLightingCalculator::begin(RectI const& queryRegion) {
   m_queryRegion = queryRegion;
   if (m_monochrome) {
@@ -120,61 +203,37 @@ void CellularLightingCalculator::addPointLight(Vec2F const& position, Vec3F cons
 }
 
 void CellularLightingCalculator::calculate(Image& output) {
-  Vec2S arrayMin = Vec2S(m_queryRegion.min() - m_calculationRegion.min());
-  Vec2S arrayMax = Vec2S(m_queryRegion.max() - m_calculationRegion.min());
-
-  if (m_monochrome)
-    m_lightArray.right().calculate(arrayMin[0], arrayMin[1], arrayMax[0], arrayMax[1]);
-  else
-    m_lightArray.left().calculate(arrayMin[0], arrayMin[1], arrayMax[0], arrayMax[1]);
-
-  output.reset(arrayMax[0] - arrayMin[0], arrayMax[1] - arrayMin[1], PixelFormat::RGB24);
+  setupImage(output, PixelFormat::RGB24);
 
   if (m_monochrome) {
-    for (size_t x = arrayMin[0]; x < arrayMax[0]; ++x) {
-      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y) {
-        output.set24(x - arrayMin[0], y - arrayMin[1], Color::grayf(m_lightArray.right().getLight(x, y)).toRgb());
-      }
-    }
+    calculateStrips(m_lightArray.right(), m_scalarStrips, [&](size_t x, size_t y, float light) {
+        output.set24(x, y, Color::grayf(light).toRgb());
+      });
   } else {
-    for (size_t x = arrayMin[0]; x < arrayMax[0]; ++x) {
-      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y) {
-        output.set24(x - arrayMin[0], y - arrayMin[1], Color::v3fToByte(m_lightArray.left().getLight(x, y)));
-      }
-    }
+    calculateStrips(m_lightArray.left(), m_coloredStrips, [&](size_t x, size_t y, Vec3F const& light) {
+        output.set24(x, y, Color::v3fToByte(light));
+      });
   }
 }
 
 void CellularLightingCalculator::calculate(Lightmap& output) {
   Vec2S arrayMin = Vec2S(m_queryRegion.min() - m_calculationRegion.min());
   Vec2S arrayMax = Vec2S(m_queryRegion.max() - m_calculationRegion.min());
-
-  if (m_monochrome)
-    m_lightArray.right().calculate(arrayMin[0], arrayMin[1], arrayMax[0], arrayMax[1]);
-  else
-    m_lightArray.left().calculate(arrayMin[0], arrayMin[1], arrayMax[0], arrayMax[1]);
-
   output = Lightmap(arrayMax[0] - arrayMin[0], arrayMax[1] - arrayMin[1]);
 
   float brightnessLimit = m_config.getFloat("brightnessLimit");
 
   if (m_monochrome) {
-    for (size_t x = arrayMin[0]; x < arrayMax[0]; ++x) {
-      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y) {
-        auto light = min(m_lightArray.right().getLight(x, y), brightnessLimit);
-        output.set(x - arrayMin[0], y - arrayMin[1], light);
-      }
-    }
+    calculateStrips(m_lightArray.right(), m_scalarStrips, [&](size_t x, size_t y, float light) {
+        output.set(x, y, min(light, brightnessLimit));
+      });
   } else {
-    for (size_t x = arrayMin[0]; x < arrayMax[0]; ++x) {
-      for (size_t y = arrayMin[1]; y < arrayMax[1]; ++y) {
-        auto light = m_lightArray.left().getLight(x, y);
+    calculateStrips(m_lightArray.left(), m_coloredStrips, [&](size_t x, size_t y, Vec3F light) {
         float intensity = ColoredLightTraits::maxIntensity(light);
         if (intensity > brightnessLimit)
           light *= brightnessLimit / intensity;
-        output.set(x - arrayMin[0], y - arrayMin[1], light);
-      }
-    }
+        output.set(x, y, light);
+      });
   }
 }
 
@@ -8,6 +8,7 @@
 #include "StarInterpolation.hpp"
 #include "StarCellularLightArray.hpp"
 #include "StarThread.hpp"
+#include "StarWorkerPool.hpp"
 
 namespace Star {
 
@@ -123,6 +124,12 @@ public:
 
   void setParameters(Json const& config);
 
+  // Sets the number of threads used by 'calculate', including the calling
+  // thread.  With more than one thread, the query region is split into
+  // vertical strips that are calculated in parallel.
+  void setThreadCount(unsigned threadCount);
+  unsigned threadCount() const;
+
   // Call 'begin' to start a calculation for the given region
   void begin(RectI const& queryRegion);
 
@@ -147,11 +154,27 @@ public:
 
   void setupImage(Image& image, PixelFormat format = PixelFormat::RGB24) const;
 private:
+  // Strips narrower than this are not worth the cost of calculating the
+  // border columns on either side of them again.
+  static size_t const MinimumStripWidth = 64;
+
+  // Calculates the query region of the given light array, and calls the
+  // output function with the position relative to the query region and the
+  // final light value of every cell in it.  The output function may be called
+  // from several threads at once, but never twice for the same cell.
+  template <typename LightArray, typename OutputFunction>
+  void calculateStrips(LightArray& lightArray, List<LightArray>& strips, OutputFunction&& output);
+
   Json m_config;
   bool m_monochrome;
   Either<ColoredCellularLightArray, ScalarCellularLightArray> m_lightArray;
   RectI m_queryRegion;
   RectI m_calculationRegion;
+
+  unsigned m_threadCount;
+  unique_ptr<WorkerPool> m_workerPool;
+  List<ColoredCellularLightArray> m_coloredStrips;
+  List<ScalarCellularLightArray> m_scalarStrips;
 };
 
 // Produce light intensity values using the same algorithm as
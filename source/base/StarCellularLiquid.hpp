@@ -7,6 +7,7 @@
 #include "StarOrderedSet.hpp"
 #include "StarRandom.hpp"
 #include "StarBlockAllocator.hpp"
+#include "StarArray.hpp"
 
 namespace Star {
 
@@ -66,6 +67,18 @@ struct LiquidCellEngineParameters {
   float minimumLivenLevelChange;
   float minimumLiquidLevel;
   float interactTransformationLevel;
+
+  // Liquid is put to sleep in square chunks of cells.  A chunk sleeps once
+  // no cell in it has changed level or pressure by more than
+  // maximumSleepingChunkChange for chunkSleepUpdates processed updates in a
+  // row, and the total amount of liquid in it has not changed by more than
+  // that either, so that slowly draining chunks stay awake.  Sleeping chunks
+  // are not processed at all until they are visited from outside of the
+  // engine, neighboring liquid moves any liquid in or out of them, or changes
+  // a cell in them by more than minimumChunkWakeChange in a single update.
+  float maximumSleepingChunkChange;
+  unsigned chunkSleepUpdates;
+  float minimumChunkWakeChange;
 };
 
 template <typename LiquidId>
@@ -92,6 +105,11 @@ public:
   size_t activeCells(LiquidId liquid) const;
   bool isActive(Vec2I const& pos) const;
 
+  // Number of cells that would be active, but are in a sleeping chunk
+  size_t sleepingCells() const;
+  size_t sleepingChunks() const;
+  bool isSleeping(Vec2I const& pos) const;
+
 private:
   enum class Adjacency {
     Left,
@@ -100,6 +118,8 @@ private:
     Top
   };
 
+  static int const ChunkSize = 16;
+
   struct WorkingCell {
     Vec2I position;
     Maybe<LiquidId> liquid;
@@ -107,12 +127,39 @@ private:
     float level;
     float pressure;
 
+    // Level and pressure as they were read from the world
+    float startLevel;
+    float startPressure;
+
     WorkingCell* leftCell;
     WorkingCell* rightCell;
     WorkingCell* topCell;
     WorkingCell* bottomCell;
   };
 
+  enum class WorkingCellState : uint8_t {
+    Unread,
+    Collision,
+    Liquid
+  };
+
+  // Working cells are read from the world into flat per chunk arrays, which
+  // are reused from update to update.
+  struct WorkingChunk {
+    Vec2I chunk;
+    // Whether any active cell in this chunk was processed this update
+    bool processed;
+    Array<WorkingCellState, ChunkSize * ChunkSize> states;
+    Array<WorkingCell, ChunkSize * ChunkSize> cells;
+  };
+
+  struct ChunkActivity {
+    unsigned quietUpdates;
+    // Net change in the amount of liquid over the quiet updates
+    float quietFlow;
+    uint64_t lastStep;
+  };
+
   template <typename Key, typename Value>
   using BAHashMap = StableHashMap<Key, Value, hash<Key>, std::equal_to<Key>, BlockAllocator<pair<Key const, Value>, 4096>>;
 
@@ -122,6 +169,11 @@ private:
   template <typename Value>
   using BAOrderedHashSet = OrderedHashSet<Value, hash<Value>, std::equal_to<Value>, BlockAllocator<Value, 4096>>;
 
+  struct SleepingChunk {
+    // Cells that would otherwise be active
+    BAHashSet<Vec2I> cells;
+  };
+
   void setup();
   void applyPressure();
   void spreadPressure();
@@ -134,6 +186,14 @@ private:
 
   WorkingCell* workingCell(Vec2I p);
   WorkingCell* adjacentCell(WorkingCell* cell, Adjacency adjacency);
+  WorkingChunk* workingChunk(Vec2I const& chunk);
+  void clearWorkingCells();
+
+  // Chunk containing the given unique location
+  static Vec2I chunkFor(Vec2I const& p);
+
+  void updateChunkSleep(WorkingChunk const& workingChunk, float maxChange, float flow);
+  void wakeChunk(Vec2I const& chunk);
 
   void setPressure(float pressure, WorkingCell& cell);
   void transferPressure(float amount, WorkingCell& source, WorkingCell& dest, bool allowReverse);
@@ -150,9 +210,19 @@ private:
   List<RectI> m_noProcessingLimitRegions;
   uint64_t m_step;
 
-  BAHashMap<Vec2I, Maybe<WorkingCell>> m_workingCells;
+  BAHashMap<Vec2I, WorkingChunk*> m_workingChunks;
+  List<unique_ptr<WorkingChunk>> m_workingChunkPool;
+  size_t m_usedWorkingChunks;
+  WorkingChunk* m_lastWorkingChunk;
+
+  BAHashMap<Vec2I, ChunkActivity> m_chunkActivity;
+  BAHashMap<Vec2I, SleepingChunk> m_sleepingChunks;
+
   List<WorkingCell*> m_currentActiveCells;
   BAHashSet<Vec2I> m_nextActiveCells;
+  // Locations visited from outside of the engine, which wake any sleeping
+  // chunk they are in
+  BAHashSet<Vec2I> m_visitedCells;
   BAHashSet<tuple<Vec2I, LiquidId, Vec2I, LiquidId>> m_liquidInteractions;
   BAHashSet<tuple<Vec2I, LiquidId, Vec2I>> m_liquidCollisions;
 };
@@ -178,7 +248,7 @@ void CellularLiquidWorld<LiquidId>::liquidCollision(Vec2I const&, LiquidId, Vec2
 
 template <typename LiquidId>
 LiquidCellEngine<LiquidId>::LiquidCellEngine(LiquidCellEngineParameters parameters, CellularLiquidWorldPtr cellWorld)
-  : m_engineParameters(parameters), m_cellWorld(cellWorld), m_step(0) {}
+  : m_engineParameters(parameters), m_cellWorld(cellWorld), m_step(0), m_usedWorkingChunks(0), m_lastWorkingChunk(nullptr) {}
 
 template <typename LiquidId>
 unsigned LiquidCellEngine<LiquidId>::liquidTickDelta(LiquidId liquid) {
@@ -207,14 +277,14 @@ void LiquidCellEngine<LiquidId>::setNoProcessingLimitRegions(List<RectI> noProce
 
 template <typename LiquidId>
 void LiquidCellEngine<LiquidId>::visitLocation(Vec2I const& p) {
-  m_nextActiveCells.add(p);
+  m_visitedCells.add(p);
 }
 
 template <typename LiquidId>
 void LiquidCellEngine<LiquidId>::visitRegion(RectI const& region) {
   for (int x = region.xMin(); x < region.xMax(); ++x) {
     for (int y = region.yMin(); y < region.yMax(); ++y)
-      m_nextActiveCells.add({x, y});
+      m_visitedCells.add({x, y});
   }
 }
 
@@ -255,11 +325,29 @@ bool LiquidCellEngine<LiquidId>::isActive(Vec2I const& pos) const {
   return false;
 }
 
+template <typename LiquidId>
+size_t LiquidCellEngine<LiquidId>::sleepingCells() const {
+  size_t totalSize = 0;
+  for (auto const& p : m_sleepingChunks)
+    totalSize += p.second.cells.size();
+  return totalSize;
+}
+
+template <typename LiquidId>
+size_t LiquidCellEngine<LiquidId>::sleepingChunks() const {
+  return m_sleepingChunks.size();
+}
+
+template <typename LiquidId>
+bool LiquidCellEngine<LiquidId>::isSleeping(Vec2I const& pos) const {
+  return m_sleepingChunks.contains(chunkFor(m_cellWorld->uniqueLocation(pos)));
+}
+
 template <typename LiquidId>
 void LiquidCellEngine<LiquidId>::setup() {
   // In case an exception occurred during the last update, clear potentially
   // stale data here
-  m_workingCells.clear();
+  clearWorkingCells();
   m_currentActiveCells.clear();
 
   for (auto& activeCellsPair : m_activeCells) {
@@ -269,6 +357,16 @@ void LiquidCellEngine<LiquidId>::setup() {
 
     size_t limitedCellNumber = 0;
     for (auto const& pos : activeCellsPair.second.values()) {
+      // Cells can still be active in a chunk that has gone to sleep if they
+      // were skipped due to the processing limit
+      if (!m_sleepingChunks.empty()) {
+        if (auto sleepingChunk = m_sleepingChunks.ptr(chunkFor(pos))) {
+          sleepingChunk->cells.add(pos);
+          activeCellsPair.second.remove(pos);
+          continue;
+        }
+      }
+
       if (m_processingLimit) {
         bool foundInUnlimitedRegion = false;
         for (auto const& region : m_noProcessingLimitRegions) {
@@ -287,12 +385,11 @@ void LiquidCellEngine<LiquidId>::setup() {
       }
 
       auto cell = workingCell(pos);
-      if (!cell || cell->liquid != activeCellsPair.first) {
-        activeCellsPair.second.remove(pos);
-      } else {
+      if (cell && cell->liquid == activeCellsPair.first) {
         m_currentActiveCells.append(cell);
-        activeCellsPair.second.remove(pos);
+        m_lastWorkingChunk->processed = true;
       }
+      activeCellsPair.second.remove(pos);
     }
   }
 
@@ -480,24 +577,45 @@ template <typename LiquidId>
 void LiquidCellEngine<LiquidId>::finish() {
   m_currentActiveCells.clear();
 
-  for (auto& workingCellPair : take(m_workingCells)) {
-    if (workingCellPair.second && !workingCellPair.second->sourceCell) {
-      if (workingCellPair.second->liquid) {
-        if (workingCellPair.second->level < m_engineParameters.minimumLiquidLevel)
-          workingCellPair.second->level = 0.0f;
+  for (auto const& workingChunkPair : m_workingChunks) {
+    WorkingChunk& workingChunk = *workingChunkPair.second;
+    float maxChange = 0.0f;
+    float flow = 0.0f;
+    for (size_t i = 0; i < workingChunk.cells.size(); ++i) {
+      if (workingChunk.states[i] != WorkingCellState::Liquid)
+        continue;
+
+      WorkingCell& workingCell = workingChunk.cells[i];
+      if (workingCell.sourceCell)
+        continue;
+
+      if (workingCell.liquid) {
+        if (workingCell.level < m_engineParameters.minimumLiquidLevel)
+          workingCell.level = 0.0f;
       } else {
-        workingCellPair.second->level = 0.0f;
+        workingCell.level = 0.0f;
       }
 
-      if (workingCellPair.second->level == 0.0f) {
-        workingCellPair.second->liquid = {};
-        workingCellPair.second->pressure = 0.0f;
+      if (workingCell.level == 0.0f) {
+        workingCell.liquid = {};
+        workingCell.pressure = 0.0f;
       }
 
-      m_cellWorld->setFlow(workingCellPair.second->position, CellularLiquidFlowCell<LiquidId>{
-          workingCellPair.second->liquid, workingCellPair.second->level, workingCellPair.second->pressure});
+      flow += workingCell.level - workingCell.startLevel;
+      maxChange = max(maxChange, fabs(workingCell.level - workingCell.startLevel));
+      maxChange = max(maxChange, fabs(workingCell.pressure - workingCell.startPressure));
+
+      m_cellWorld->setFlow(workingCell.position, CellularLiquidFlowCell<LiquidId>{
+          workingCell.liquid, workingCell.level, workingCell.pressure});
     }
+
+    updateChunkSleep(workingChunk, maxChange, flow);
   }
+  clearWorkingCells();
+
+  eraseWhere(m_chunkActivity, [this](auto const& p) {
+      return p.second.lastStep + m_engineParameters.chunkSleepUpdates < m_step;
+    });
 
   for (auto const& interaction : take(m_liquidInteractions))
     m_cellWorld->liquidInteraction(get<0>(interaction), get<1>(interaction), get<2>(interaction), get<3>(interaction));
@@ -505,12 +623,24 @@ void LiquidCellEngine<LiquidId>::finish() {
   for (auto const& interaction : take(m_liquidCollisions))
     m_cellWorld->liquidCollision(get<0>(interaction), get<1>(interaction), get<2>(interaction));
 
+  for (auto const& c : take(m_visitedCells)) {
+    if (!m_sleepingChunks.empty()) {
+      for (auto p : {c, c + Vec2I(-1, 0), c + Vec2I(1, 0), c + Vec2I(0, -1), c + Vec2I(0, 1)})
+        wakeChunk(chunkFor(m_cellWorld->uniqueLocation(p)));
+    }
+    m_nextActiveCells.add(c);
+  }
+
   for (auto const& c : take(m_nextActiveCells)) {
     auto visit = [this](Vec2I p) {
       p = m_cellWorld->uniqueLocation(p);
       auto cell = workingCell(p);
-      if (cell && cell->liquid)
-        m_activeCells[*cell->liquid].add(p);
+      if (cell && cell->liquid) {
+        if (auto sleepingChunk = m_sleepingChunks.ptr(chunkFor(p)))
+          sleepingChunk->cells.add(p);
+        else
+          m_activeCells[*cell->liquid].add(p);
+      }
     };
 
     visit(c);
@@ -525,19 +655,90 @@ void LiquidCellEngine<LiquidId>::finish() {
     });
 }
 
+template <typename LiquidId>
+void LiquidCellEngine<LiquidId>::updateChunkSleep(WorkingChunk const& workingChunk, float maxChange, float flow) {
+  if (m_sleepingChunks.contains(workingChunk.chunk)) {
+    // Any liquid moving in or out of a sleeping chunk means that it has not
+    // settled after all.
+    if (flow != 0.0f || maxChange > m_engineParameters.minimumChunkWakeChange)
+      wakeChunk(workingChunk.chunk);
+
+  } else if (workingChunk.processed && m_engineParameters.chunkSleepUpdates != 0) {
+    auto& activity = m_chunkActivity[workingChunk.chunk];
+    activity.lastStep = m_step;
+    activity.quietFlow += flow;
+    if (maxChange > m_engineParameters.maximumSleepingChunkChange || fabs(activity.quietFlow) > m_engineParameters.maximumSleepingChunkChange) {
+      activity.quietUpdates = 0;
+      activity.quietFlow = 0.0f;
+    } else if (++activity.quietUpdates >= m_engineParameters.chunkSleepUpdates) {
+      m_chunkActivity.remove(workingChunk.chunk);
+      m_sleepingChunks[workingChunk.chunk];
+    }
+  }
+}
+
+template <typename LiquidId>
+void LiquidCellEngine<LiquidId>::wakeChunk(Vec2I const& chunk) {
+  if (auto sleepingChunk = m_sleepingChunks.maybeTake(chunk)) {
+    for (auto const& p : sleepingChunk->cells)
+      m_nextActiveCells.add(p);
+  }
+}
+
 template <typename LiquidId>
 typename LiquidCellEngine<LiquidId>::WorkingCell* LiquidCellEngine<LiquidId>::workingCell(Vec2I p) {
   p = m_cellWorld->uniqueLocation(p);
 
-  auto res = m_workingCells.insert(make_pair(p, Maybe<WorkingCell>()));
-  if (res.second) {
+  Vec2I chunk = chunkFor(p);
+  WorkingChunk* workingChunk = m_lastWorkingChunk;
+  if (!workingChunk || workingChunk->chunk != chunk)
+    workingChunk = this->workingChunk(chunk);
+
+  size_t index = (p[0] - chunk[0] * ChunkSize) * ChunkSize + p[1] - chunk[1] * ChunkSize;
+  WorkingCell& cell = workingChunk->cells[index];
+  WorkingCellState& state = workingChunk->states[index];
+  if (state == WorkingCellState::Unread) {
     auto cellData = m_cellWorld->cell(p);
-    if (auto flowCell = cellData.template ptr<CellularLiquidFlowCell<LiquidId>>())
-      res.first->second = WorkingCell{p, flowCell->liquid, false, flowCell->level, flowCell->pressure, nullptr, nullptr, nullptr, nullptr};
-    else if (auto sourceCell = cellData.template ptr<CellularLiquidSourceCell<LiquidId>>())
-      res.first->second = WorkingCell{p, sourceCell->liquid, true, 1.0f, sourceCell->pressure, nullptr, nullptr, nullptr, nullptr};
+    if (auto flowCell = cellData.template ptr<CellularLiquidFlowCell<LiquidId>>()) {
+      cell = WorkingCell{p, flowCell->liquid, false, flowCell->level, flowCell->pressure, flowCell->level, flowCell->pressure, nullptr, nullptr, nullptr, nullptr};
+      state = WorkingCellState::Liquid;
+    } else if (auto sourceCell = cellData.template ptr<CellularLiquidSourceCell<LiquidId>>()) {
+      cell = WorkingCell{p, sourceCell->liquid, true, 1.0f, sourceCell->pressure, 1.0f, sourceCell->pressure, nullptr, nullptr, nullptr, nullptr};
+      state = WorkingCellState::Liquid;
+    } else {
+      state = WorkingCellState::Collision;
+    }
   }
-  return res.first->second.ptr();
+
+  return state == WorkingCellState::Liquid ? &cell : nullptr;
+}
+
+template <typename LiquidId>
+typename LiquidCellEngine<LiquidId>::WorkingChunk* LiquidCellEngine<LiquidId>::workingChunk(Vec2I const& chunk) {
+  if (auto workingChunk = m_workingChunks.ptr(chunk)) {
+    m_lastWorkingChunk = *workingChunk;
+  } else {
+    if (m_usedWorkingChunks == m_workingChunkPool.size())
+      m_workingChunkPool.append(make_unique<WorkingChunk>());
+    m_lastWorkingChunk = m_workingChunkPool[m_usedWorkingChunks++].get();
+    m_lastWorkingChunk->chunk = chunk;
+    m_lastWorkingChunk->processed = false;
+    m_lastWorkingChunk->states.fill(WorkingCellState::Unread);
+    m_workingChunks.add(chunk, m_lastWorkingChunk);
+  }
+  return m_lastWorkingChunk;
+}
+
+template <typename LiquidId>
+void LiquidCellEngine<LiquidId>::clearWorkingCells() {
+  m_workingChunks.clear();
+  m_usedWorkingChunks = 0;
+  m_lastWorkingChunk = nullptr;
+}
+
+template <typename LiquidId>
+Vec2I LiquidCellEngine<LiquidId>::chunkFor(Vec2I const& p) {
+  return Vec2I((p[0] - pmod(p[0], ChunkSize)) / ChunkSize, (p[1] - pmod(p[1], ChunkSize)) / ChunkSize);
 }
 
 template <typename LiquidId>
@@ -5,6 +5,7 @@
 #include "StarDataStreamExtra.hpp"
 #include "StarSha256.hpp"
 #include "StarFile.hpp"
+#include "StarLogging.hpp"
 
 namespace Star {
 
@@ -71,7 +72,16 @@ void PackedAssetSource::build(DirectoryAssetSource& directorySource, String cons
 PackedAssetSource::PackedAssetSource(String const& filename) {
   m_packedFile = File::open(filename, IOMode::Read);
 
-  DataStreamIODevice ds(m_packedFile);
+  // Packed files never change once built, so read everything through a
+  // memory mapping when possible, avoiding a system call and an extra copy
+  // per asset read.
+  try {
+    m_mapping = m_packedFile->map();
+  } catch (IOException const& e) {
+    Logger::warn("Could not memory map packed assets file '{}', using regular reads: {}", filename, outputException(e, false));
+  }
+
+  DataStreamIODevice ds(m_mapping ? IODevicePtr(m_mapping) : IODevicePtr(m_packedFile));
   if (ds.readBytes(8) != ByteArray("SBAsset6", 8))
     throw AssetSourceException("Packed assets file format unrecognized!");
 
@@ -95,7 +105,7 @@ StringList PackedAssetSource::assetPaths() const {
 
 IODevicePtr PackedAssetSource::open(String const& path) {
   struct AssetReader : public IODevice {
-    AssetReader(FilePtr file, String path, StreamOffset offset, StreamOffset size)
+    AssetReader(IODevicePtr file, String path, StreamOffset offset, StreamOffset size)
       : file(file), path(path), fileOffset(offset), assetSize(size), assetPos(0) {
       setMode(IOMode::Read);
     }
@@ -142,7 +152,7 @@ IODevicePtr PackedAssetSource::open(String const& path) {
       return cloned;
     }
 
-    FilePtr file;
+    IODevicePtr file;
     String path;
     StreamOffset fileOffset;
     StreamOffset assetSize;
@@ -153,6 +163,8 @@ IODevicePtr PackedAssetSource::open(String const& path) {
   if (!p)
     throw AssetSourceException::format("Requested file '{}' does not exist in the packed assets file", path);
 
+  if (m_mapping)
+    return make_shared<AssetReader>(m_mapping, path, p->first, p->second);
   return make_shared<AssetReader>(m_packedFile, path, p->first, p->second);
 }
 
@@ -161,6 +173,12 @@ ByteArray PackedAssetSource::read(String const& path) {
   if (!p)
     throw AssetSourceException::format("Requested file '{}' does not exist in the packed assets file", path);
 
+  if (m_mapping) {
+    if (p->first + p->second > m_mapping->dataSize())
+      throw AssetSourceException::format("Requested file '{}' extends past the end of the packed assets file", path);
+    return ByteArray(m_mapping->ptr() + p->first, p->second);
+  }
+
   ByteArray data(p->second, 0);
   m_packedFile->readFullAbsolute(p->first, data.ptr(), p->second);
   return data;
@@ -35,6 +35,7 @@ public:
 
 private:
   FilePtr m_packedFile;
+  FileMappingPtr m_mapping;
   JsonObject m_metadata;
   OrderedHashMap<String, pair<uint64_t, uint64_t>> m_index;
 };
@@ -0,0 +1,267 @@
+#include "StarProcessedImageCache.hpp"
+#include "StarDataStreamDevices.hpp"
+#include "StarLogging.hpp"
+
+namespace Star {
+
+static char const ProcessedImageCacheMagic[] = "SBPIC001";
+static size_t const ProcessedImageCacheMagicSize = 8;
+// Magic followed by the current generation
+static size_t const ProcessedImageCacheHeaderSize = ProcessedImageCacheMagicSize + sizeof(uint32_t);
+
+ProcessedImageCache::ProcessedImageCache(String filename, uint64_t maxSize)
+  : m_filename(std::move(filename)), m_maxSize(maxSize), m_fileSize(0), m_generation(0), m_stopWriter(false) {
+  try {
+    open();
+  } catch (std::exception const& e) {
+    disable("open", e);
+  }
+
+  if (m_file)
+    m_writerThread = Thread::invoke("ProcessedImageCache::writerMain", mem_fn(&ProcessedImageCache::writerMain), this);
+}
+
+ProcessedImageCache::~ProcessedImageCache() {
+  {
+    MutexLocker locker(m_mutex);
+    m_stopWriter = true;
+    m_writeCondition.signal();
+  }
+  m_writerThread.finish();
+}
+
+ImageConstPtr ProcessedImageCache::get(String const& key, uint64_t sourceDigest) {
+  MutexLocker locker(m_mutex);
+  if (!m_file)
+    return {};
+
+  auto entry = m_entries.ptr(key);
+  if (!entry || entry->sourceDigest != sourceDigest)
+    return {};
+
+  try {
+    auto image = make_shared<Image>(entry->imageSize, entry->pixelFormat);
+    size_t pixelsSize = entry->imageSize[0] * entry->imageSize[1] * image->bytesPerPixel();
+    if (entry->pendingRecord)
+      std::memcpy(image->data(), entry->pendingRecord->ptr() + (entry->pixelsOffset - entry->offset), pixelsSize);
+    else if (m_mapping && entry->pixelsOffset + pixelsSize <= m_mapping->dataSize())
+      std::memcpy(image->data(), m_mapping->ptr() + entry->pixelsOffset, pixelsSize);
+    else
+      m_file->readFullAbsolute(entry->pixelsOffset, (char*)image->data(), pixelsSize);
+
+    if (entry->lastUsed != m_generation) {
+      entry->lastUsed = m_generation;
+      m_pendingWrites.append({entry->offset, make_shared<ByteArray>(DataStreamBuffer::serialize<uint32_t>(m_generation)), {}});
+      m_writeCondition.signal();
+    }
+    return image;
+  } catch (std::exception const& e) {
+    disable("read", e);
+    return {};
+  }
+}
+
+void ProcessedImageCache::set(String const& key, uint64_t sourceDigest, Image const& image) {
+  if (image.empty())
+    return;
+
+  // The generation never changes after opening
+  DataStreamBuffer ds;
+  ds.write<uint32_t>(m_generation);
+  ds.write(sourceDigest);
+  ds.write(key);
+  ds.write<uint8_t>((uint8_t)image.pixelFormat());
+  ds.writeVlqU(image.width());
+  ds.writeVlqU(image.height());
+  size_t headerSize = ds.size();
+  size_t pixelsSize = image.width() * image.height() * image.bytesPerPixel();
+
+  MutexLocker locker(m_mutex);
+  if (!m_file)
+    return;
+
+  // The file is only shrunk when it is next opened
+  if (m_fileSize + headerSize + pixelsSize > m_maxSize)
+    return;
+
+  locker.unlock();
+  ds.writeData((char const*)image.data(), pixelsSize);
+  auto record = make_shared<ByteArray>(ds.takeData());
+  locker.lock();
+
+  if (!m_file || m_fileSize + record->size() > m_maxSize)
+    return;
+
+  Entry entry;
+  entry.offset = m_fileSize;
+  entry.pixelsOffset = m_fileSize + headerSize;
+  entry.recordSize = record->size();
+  entry.sourceDigest = sourceDigest;
+  entry.pixelFormat = image.pixelFormat();
+  entry.imageSize = image.size();
+  entry.lastUsed = m_generation;
+  entry.pendingRecord = record;
+
+  m_fileSize += entry.recordSize;
+  m_entries[key] = entry;
+  m_pendingWrites.append({entry.offset, std::move(record), key});
+  m_writeCondition.signal();
+}
+
+size_t ProcessedImageCache::count() const {
+  MutexLocker locker(m_mutex);
+  return m_entries.size();
+}
+
+uint64_t ProcessedImageCache::size() const {
+  MutexLocker locker(m_mutex);
+  return m_fileSize;
+}
+
+void ProcessedImageCache::open() {
+  auto load = [this]() {
+    m_file = File::open(m_filename, IOMode::ReadWrite);
+    if (!m_file->tryLock())
+      throw IOException("file is in use by another process");
+    m_mapping.reset();
+    m_entries.clear();
+    StreamOffset fileSize = m_file->size();
+    if (fileSize > 0)
+      m_mapping = m_file->map();
+    m_fileSize = m_mapping ? readEntries(m_mapping->ptr(), m_mapping->dataSize()) : 0;
+
+    // Drop a partially written record from the end of the file, or everything
+    // if the header is not valid.
+    if ((StreamOffset)m_fileSize < fileSize) {
+      m_mapping.reset();
+      m_file->resize(m_fileSize);
+      if (m_fileSize > 0)
+        m_mapping = m_file->map();
+    }
+  };
+
+  File::makeDirectoryRecursive(File::dirName(m_filename));
+  load();
+  if (m_fileSize > m_maxSize) {
+    size_t count = m_entries.size();
+    compact(m_maxSize / 4 * 3);
+    load();
+    Logger::info("Dropped {} least recently used images from processed image cache", count - m_entries.size());
+  }
+
+  ++m_generation;
+  DataStreamBuffer header;
+  header.writeData(ProcessedImageCacheMagic, ProcessedImageCacheMagicSize);
+  header.write<uint32_t>(m_generation);
+  m_file->writeBytesAbsolute(0, header.data());
+  m_fileSize = max<uint64_t>(m_fileSize, ProcessedImageCacheHeaderSize);
+
+  Logger::info("Opened processed image cache with {} images, {} bytes", m_entries.size(), m_fileSize);
+}
+
+StreamOffset ProcessedImageCache::readEntries(char const* data, size_t size) {
+  m_generation = 0;
+  if (size < ProcessedImageCacheHeaderSize || std::memcmp(data, ProcessedImageCacheMagic, ProcessedImageCacheMagicSize) != 0)
+    return 0;
+
+  DataStreamExternalBuffer ds(data, size);
+  ds.seek(ProcessedImageCacheMagicSize);
+  m_generation = ds.read<uint32_t>();
+
+  StreamOffset end = ds.pos();
+  try {
+    while (!ds.atEnd()) {
+      Entry entry;
+      entry.offset = ds.pos();
+      entry.lastUsed = ds.read<uint32_t>();
+      entry.sourceDigest = ds.read<uint64_t>();
+      String key = ds.read<String>();
+      uint8_t pixelFormat = ds.read<uint8_t>();
+      if (pixelFormat > (uint8_t)PixelFormat::RGBA_F)
+        break;
+      entry.pixelFormat = (PixelFormat)pixelFormat;
+      entry.imageSize[0] = ds.readVlqU();
+      entry.imageSize[1] = ds.readVlqU();
+      entry.pixelsOffset = ds.pos();
+      uint64_t pixelsSize = (uint64_t)entry.imageSize[0] * entry.imageSize[1] * bytesPerPixel(entry.pixelFormat);
+      if (pixelsSize > ds.remaining())
+        break;
+      ds.seek(pixelsSize, IOSeek::Relative);
+      entry.recordSize = ds.pos() - entry.offset;
+
+      // Later records for the same key replace earlier ones
+      m_entries[std::move(key)] = entry;
+      end = ds.pos();
+    }
+  } catch (IOException const&) {}
+
+  return end;
+}
+
+void ProcessedImageCache::compact(uint64_t targetSize) {
+  auto entries = m_entries.pairs();
+  sortByComputedValue(entries, [](pair<String, Entry> const& p) {
+      return -(int64_t)p.second.lastUsed;
+    });
+
+  String newFilename = m_filename + ".new";
+  auto newFile = File::open(newFilename, IOMode::Write | IOMode::Truncate);
+  newFile->writeFull(m_mapping->ptr(), ProcessedImageCacheHeaderSize);
+  uint64_t newSize = ProcessedImageCacheHeaderSize;
+  for (auto const& p : entries) {
+    if (newSize + p.second.recordSize > targetSize)
+      continue;
+    newFile->writeFull(m_mapping->ptr() + p.second.offset, p.second.recordSize);
+    newSize += p.second.recordSize;
+  }
+  newFile->close();
+
+  m_mapping.reset();
+  m_file->close();
+  File::rename(newFilename, m_filename);
+}
+
+void ProcessedImageCache::disable(String const& reason, std::exception const& e) {
+  Logger::warn("Could not {} processed image cache '{}', disabling it: {}", reason, m_filename, outputException(e, false));
+  m_mapping.reset();
+  m_file.reset();
+  m_entries.clear();
+  m_pendingWrites.clear();
+}
+
+void ProcessedImageCache::writerMain() {
+  MutexLocker locker(m_mutex);
+  while (true) {
+    if (m_pendingWrites.empty()) {
+      if (m_stopWriter)
+        break;
+      m_writeCondition.wait(m_mutex);
+      continue;
+    }
+
+    auto writes = take(m_pendingWrites);
+    auto file = m_file;
+    locker.unlock();
+    try {
+      for (auto const& write : writes)
+        file->writeFullAbsolute(write.offset, write.data->ptr(), write.data->size());
+    } catch (std::exception const& e) {
+      locker.lock();
+      if (m_file == file)
+        disable("write", e);
+      continue;
+    }
+    locker.lock();
+
+    // Written records are read from the file from now on
+    for (auto const& write : writes) {
+      if (write.key.empty())
+        continue;
+      auto entry = m_entries.ptr(write.key);
+      if (entry && entry->offset == write.offset)
+        entry->pendingRecord.reset();
+    }
+  }
+}
+
+}
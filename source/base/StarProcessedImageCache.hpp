@@ -0,0 +1,87 @@
+#pragma once
+
+#include "StarImage.hpp"
+#include "StarFile.hpp"
+#include "StarThread.hpp"
+
+namespace Star {
+
+STAR_CLASS(ProcessedImageCache);
+
+// Keeps images that were produced by applying directives to asset images in
+// a single file between runs.  Each image is stored along with a digest of
+// every source file it was produced from, and is only returned for that same
+// digest.
+//
+// New images are appended to the end of the file until it reaches its maximum
+// size.  Past that point nothing more is added, and the next time the file is
+// opened it is rewritten with only the most recently used images.  Images
+// that were in the file when it was opened are read straight out of a memory
+// mapping.  Writes happen on a separate thread, and images waiting to be
+// written are returned from memory.
+//
+// The file is locked while open, and if another process already has it open
+// the cache is disabled.  Any error reading or writing the file is logged and
+// disables the cache rather than being thrown.
+class ProcessedImageCache {
+public:
+  ProcessedImageCache(String filename, uint64_t maxSize);
+  // Finishes writing every pending image
+  ~ProcessedImageCache();
+
+  ImageConstPtr get(String const& key, uint64_t sourceDigest);
+  void set(String const& key, uint64_t sourceDigest, Image const& image);
+
+  size_t count() const;
+  // Size of the cache file in bytes
+  uint64_t size() const;
+
+private:
+  struct Entry {
+    // Offset of the record, which starts with the generation it was last used
+    // in
+    StreamOffset offset;
+    StreamOffset pixelsOffset;
+    uint64_t recordSize;
+    uint64_t sourceDigest;
+    PixelFormat pixelFormat;
+    Vec2U imageSize;
+    uint32_t lastUsed;
+    // The whole record, until it has been written
+    shared_ptr<ByteArray const> pendingRecord;
+  };
+
+  struct PendingWrite {
+    StreamOffset offset;
+    shared_ptr<ByteArray const> data;
+    // Set for new records, whose entry should be marked as written
+    String key;
+  };
+
+  void open();
+  // Reads every record in the file, and returns the size of the file up to the
+  // end of the last complete record.
+  StreamOffset readEntries(char const* data, size_t size);
+  // Rewrites the file with as many of the most recently used images as fit in
+  // targetSize.
+  void compact(uint64_t targetSize);
+  void disable(String const& reason, std::exception const& e);
+  void writerMain();
+
+  mutable Mutex m_mutex;
+  String m_filename;
+  uint64_t m_maxSize;
+
+  FilePtr m_file;
+  FileMappingPtr m_mapping;
+  uint64_t m_fileSize;
+  uint32_t m_generation;
+  StringMap<Entry> m_entries;
+
+  ConditionVariable m_writeCondition;
+  List<PendingWrite> m_pendingWrites;
+  bool m_stopWriter;
+  ThreadFunction<void> m_writerThread;
+};
+
+}
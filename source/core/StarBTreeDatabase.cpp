@@ -2,21 +2,31 @@
 #include "StarSha256.hpp"
 #include "StarVlqEncoding.hpp"
 #include "StarLogging.hpp"
+#include "StarCasting.hpp"
 
 namespace Star {
 
 BTreeDatabase::BTreeDatabase() {
   m_impl.parent = this;
+  m_impl.committed = false;
+  m_committedImpl.parent = this;
+  m_committedImpl.committed = true;
   m_open = false;
+  m_memoryMapped = true;
   m_deviceSize = 0;
   m_blockSize = 2048;
   m_headFreeIndexBlock = InvalidBlockIndex;
   m_keySize = 0;
   m_autoCommit = true;
   m_indexCache.setMaxSize(64);
+  m_committedIndexCache.setMaxSize(64);
   m_root = InvalidBlockIndex;
   m_rootIsLeaf = false;
+  m_committedRoot = InvalidBlockIndex;
+  m_committedRootIsLeaf = false;
+  m_committedDeviceSize = 0;
   m_usingAltRoot = false;
+  m_flattening = false;
 }
 
 BTreeDatabase::BTreeDatabase(String const& contentIdentifier, size_t keySize)
@@ -70,6 +80,8 @@ uint32_t BTreeDatabase::indexCacheSize() const {
 void BTreeDatabase::setIndexCacheSize(uint32_t indexCacheSize) {
   SpinLocker lock(m_indexCacheSpinLock);
   m_indexCache.setMaxSize(indexCacheSize);
+  SpinLocker committedLock(m_committedIndexCacheSpinLock);
+  m_committedIndexCache.setMaxSize(indexCacheSize);
 }
 
 bool BTreeDatabase::autoCommit() const {
@@ -95,6 +107,19 @@ void BTreeDatabase::setIODevice(IODevicePtr device) {
   m_device = std::move(device);
 }
 
+bool BTreeDatabase::memoryMapped() const {
+  ReadLocker readLocker(m_lock);
+  return m_memoryMapped;
+}
+
+void BTreeDatabase::setMemoryMapped(bool memoryMapped) {
+  WriteLocker writeLocker(m_lock);
+  WriteLocker commitLocker(m_commitLock);
+  m_memoryMapped = memoryMapped;
+  if (m_open)
+    remapDevice();
+}
+
 bool BTreeDatabase::isOpen() const {
   ReadLocker readLocker(m_lock);
   return m_open;
@@ -133,6 +158,11 @@ bool BTreeDatabase::open() {
     if (m_device->isWritable())
       m_device->resize(m_deviceSize);
 
+    WriteLocker commitLocker(m_commitLock);
+    m_committedIndexCache.clear();
+    remapDevice();
+    publishCommittedRoot();
+
     return false;
 
   } else {
@@ -202,6 +232,42 @@ void BTreeDatabase::recoverAll(function<void(ByteArray, ByteArray)> v, function<
   m_impl.recoverAll(std::move(v), std::move(e));
 }
 
+bool BTreeDatabase::containsCommitted(ByteArray const& k) {
+  ReadLocker commitLocker(m_commitLock);
+  checkIfCommittedOpen("containsCommitted");
+  checkKeySize(k);
+  return m_committedImpl.contains(k);
+}
+
+Maybe<ByteArray> BTreeDatabase::findCommitted(ByteArray const& k) {
+  ReadLocker commitLocker(m_commitLock);
+  checkIfCommittedOpen("findCommitted");
+  checkKeySize(k);
+  return m_committedImpl.find(k);
+}
+
+List<pair<ByteArray, ByteArray>> BTreeDatabase::findCommitted(ByteArray const& lower, ByteArray const& upper) {
+  ReadLocker commitLocker(m_commitLock);
+  checkIfCommittedOpen("findCommitted");
+  checkKeySize(lower);
+  checkKeySize(upper);
+  return m_committedImpl.find(lower, upper);
+}
+
+void BTreeDatabase::forEachCommitted(ByteArray const& lower, ByteArray const& upper, function<void(ByteArray, ByteArray)> v) {
+  ReadLocker commitLocker(m_commitLock);
+  checkIfCommittedOpen("forEachCommitted");
+  checkKeySize(lower);
+  checkKeySize(upper);
+  m_committedImpl.forEach(lower, upper, std::move(v));
+}
+
+void BTreeDatabase::forAllCommitted(function<void(ByteArray, ByteArray)> v) {
+  ReadLocker commitLocker(m_commitLock);
+  checkIfCommittedOpen("forAllCommitted");
+  m_committedImpl.forAll(std::move(v));
+}
+
 bool BTreeDatabase::insert(ByteArray const& k, ByteArray const& data) {
   WriteLocker writeLocker(m_lock);
   checkKeySize(k);
@@ -244,7 +310,7 @@ uint32_t BTreeDatabase::freeBlockCount() {
     indexBlockIndex = indexBlock.nextFreeBlock;
   }
 
-  count += m_availableBlocks.size();
+  count += m_availableBlocks.size() + m_pendingFreeBlocks.size();
 
   // Include untracked blocks at the end of the file in the free count.
   count += (m_device->size() - m_deviceSize) / m_blockSize;
@@ -293,14 +359,22 @@ void BTreeDatabase::rollback() {
   WriteLocker writeLocker(m_lock);
 
   m_availableBlocks.clear();
+  m_pendingFreeBlocks.clear();
   m_indexCache.clear();
   m_uncommittedWrites.clear();
   m_uncommitted.clear();
 
   readRoot();
 
-  if (m_device->isWritable())
+  // Only uncommitted blocks past the end of the committed device size are
+  // truncated here, so snapshot readers are unaffected, but the mapping must
+  // still be dropped before the file can shrink.
+  if (m_device->isWritable() && m_device->size() != m_deviceSize) {
+    WriteLocker commitLocker(m_commitLock);
+    m_mapping.reset();
     m_device->resize(m_deviceSize);
+    remapDevice();
+  }
 }
 
 void BTreeDatabase::close(bool closeDevice) {
@@ -311,6 +385,15 @@ void BTreeDatabase::close(bool closeDevice) {
 
     m_indexCache.clear();
 
+    {
+      WriteLocker commitLocker(m_commitLock);
+      m_committedIndexCache.clear();
+      m_mapping.reset();
+      m_committedRoot = InvalidBlockIndex;
+      m_committedRootIsLeaf = false;
+      m_committedDeviceSize = 0;
+    }
+
     m_open = false;
     if (closeDevice && m_device && m_device->isOpen())
       m_device->close();
@@ -494,11 +577,11 @@ void BTreeDatabase::LeafNode::split(LeafNode& right, size_t i) {
 }
 
 auto BTreeDatabase::BTreeImpl::rootPointer() -> Pointer {
-  return parent->m_root;
+  return committed ? parent->m_committedRoot : parent->m_root;
 }
 
 bool BTreeDatabase::BTreeImpl::rootIsLeaf() {
-  return parent->m_rootIsLeaf;
+  return committed ? parent->m_committedRootIsLeaf : parent->m_rootIsLeaf;
 }
 
 void BTreeDatabase::BTreeImpl::setNewRoot(Pointer pointer, bool isLeaf) {
@@ -518,14 +601,23 @@ auto BTreeDatabase::BTreeImpl::createIndex(Pointer beginPointer) -> Index {
 }
 
 auto BTreeDatabase::BTreeImpl::loadIndex(Pointer pointer) -> Index {
-  SpinLocker lock(parent->m_indexCacheSpinLock);
-  if (auto index = parent->m_indexCache.ptr(pointer))
+  auto& indexCache = committed ? parent->m_committedIndexCache : parent->m_indexCache;
+  SpinLocker lock(committed ? parent->m_committedIndexCacheSpinLock : parent->m_indexCacheSpinLock);
+  if (auto index = indexCache.ptr(pointer))
     return *index;
   lock.unlock();
 
   auto index = make_shared<IndexNode>();
 
-  DataStreamBuffer buffer(parent->readBlock(pointer));
+  ByteArray block;
+  DataStreamExternalBuffer buffer;
+  if (char const* mapped = mappedNode(pointer)) {
+    buffer.reset(mapped, parent->m_blockSize);
+  } else {
+    block.resize(parent->m_blockSize, 0);
+    readNode(pointer, block.ptr());
+    buffer.reset(block.ptr(), block.size());
+  }
 
   if (buffer.readBytes(2) != ByteArray(IndexMagic, 2))
     throw DBException("Error, incorrect index block signature.");
@@ -543,7 +635,7 @@ auto BTreeDatabase::BTreeImpl::loadIndex(Pointer pointer) -> Index {
   }
 
   lock.lock();
-  parent->m_indexCache.set(pointer, index);
+  indexCache.set(pointer, index);
   return index;
 }
 
@@ -626,7 +718,7 @@ auto BTreeDatabase::BTreeImpl::loadLeaf(Pointer pointer) -> Leaf {
   BlockIndex currentLeafBlock = leaf->self;
   DataStreamBuffer leafBuffer;
   leafBuffer.reset(parent->m_blockSize);
-  parent->readBlock(currentLeafBlock, 0, leafBuffer.ptr(), parent->m_blockSize);
+  readNode(currentLeafBlock, leafBuffer.ptr());
 
   if (leafBuffer.readBytes(2) != ByteArray(LeafMagic, 2))
     throw DBException("Error, incorrect leaf block signature.");
@@ -651,7 +743,7 @@ auto BTreeDatabase::BTreeImpl::loadLeaf(Pointer pointer) -> Leaf {
           currentLeafBlock = leafBuffer.read<BlockIndex>();
           if (currentLeafBlock != InvalidBlockIndex) {
             leafBuffer.reset(parent->m_blockSize);
-            parent->readBlock(currentLeafBlock, 0, leafBuffer.ptr(), parent->m_blockSize);
+            readNode(currentLeafBlock, leafBuffer.ptr());
 
             if (leafBuffer.readBytes(2) != ByteArray(LeafMagic, 2))
               throw DBException("Error, incorrect leaf block signature.");
@@ -875,6 +967,24 @@ auto BTreeDatabase::BTreeImpl::nextLeaf(Leaf const&) -> Maybe<Pointer> {
 
 void BTreeDatabase::BTreeImpl::setNextLeaf(Leaf&, Maybe<Pointer>) {}
 
+void BTreeDatabase::BTreeImpl::readNode(Pointer pointer, char* block) {
+  if (committed)
+    parent->readCommittedBlock(pointer, 0, block, parent->m_blockSize);
+  else
+    parent->readBlock(pointer, 0, block, parent->m_blockSize);
+}
+
+char const* BTreeDatabase::BTreeImpl::mappedNode(Pointer pointer) {
+  if (committed) {
+    parent->checkCommittedBlockIndex(pointer);
+  } else {
+    parent->checkBlockIndex(pointer);
+    if (parent->m_uncommittedWrites.contains(pointer))
+      return nullptr;
+  }
+  return parent->mappedBlock(pointer);
+}
+
 void BTreeDatabase::readBlock(BlockIndex blockIndex, size_t blockOffset, char* block, size_t size) const {
   checkBlockIndex(blockIndex);
   rawReadBlock(blockIndex, blockOffset, block, size);
@@ -900,10 +1010,33 @@ void BTreeDatabase::rawReadBlock(BlockIndex blockIndex, size_t blockOffset, char
 
   if (auto buffer = m_uncommittedWrites.ptr(blockIndex))
     buffer->copyTo(block, blockOffset, size);
+  else if (char const* mapped = mappedBlock(blockIndex))
+    memcpy(block, mapped + blockOffset, size);
   else
     m_device->readFullAbsolute(HeaderSize + blockIndex * (StreamOffset)m_blockSize + blockOffset, block, size);
 }
 
+void BTreeDatabase::readCommittedBlock(BlockIndex blockIndex, size_t blockOffset, char* block, size_t size) const {
+  checkCommittedBlockIndex(blockIndex);
+  if (blockOffset > m_blockSize || size > m_blockSize - blockOffset)
+    throw DBException::format("Read past end of block, offset: {} size {}", blockOffset, size);
+
+  if (size <= 0)
+    return;
+
+  if (char const* mapped = mappedBlock(blockIndex))
+    memcpy(block, mapped + blockOffset, size);
+  else
+    m_device->readFullAbsolute(HeaderSize + blockIndex * (StreamOffset)m_blockSize + blockOffset, block, size);
+}
+
+char const* BTreeDatabase::mappedBlock(BlockIndex blockIndex) const {
+  StreamOffset blockStart = HeaderSize + blockIndex * (StreamOffset)m_blockSize;
+  if (!m_mapping || blockStart + m_blockSize > (StreamOffset)m_mapping->dataSize())
+    return nullptr;
+  return m_mapping->ptr() + blockStart;
+}
+
 void BTreeDatabase::rawWriteBlock(BlockIndex blockIndex, size_t blockOffset, char const* block, size_t size) {
   if (blockOffset > m_blockSize || size > m_blockSize - blockOffset)
     throw DBException::format("Write past end of block, offset: {} size {}", blockOffset, size);
@@ -1001,12 +1134,18 @@ auto BTreeDatabase::leafTailBlocks(BlockIndex leafPointer) -> List<BlockIndex> {
 }
 
 void BTreeDatabase::freeBlock(BlockIndex b) {
-  if (m_uncommitted.contains(b))
-    m_uncommitted.remove(b);
   if (m_uncommittedWrites.contains(b))
     m_uncommittedWrites.remove(b);
 
-  m_availableBlocks.add(b);
+  if (m_uncommitted.contains(b)) {
+    m_uncommitted.remove(b);
+    m_availableBlocks.add(b);
+  } else if (m_flattening) {
+    // Flattening overwrites committed blocks under the commit lock anyway.
+    m_availableBlocks.add(b);
+  } else {
+    m_pendingFreeBlocks.add(b);
+  }
 }
 
 auto BTreeDatabase::reserveBlock() -> BlockIndex {
@@ -1075,19 +1214,29 @@ void BTreeDatabase::readRoot() {
 }
 
 void BTreeDatabase::doCommit() {
-  if (m_availableBlocks.empty() && m_uncommitted.empty())
+  if (m_availableBlocks.empty() && m_pendingFreeBlocks.empty() && m_uncommitted.empty())
     return;
 
-  if (!m_availableBlocks.empty()) {
+  if (!m_availableBlocks.empty() || !m_pendingFreeBlocks.empty()) {
     // First, read the existing head FreeIndexBlock, if it exists
     FreeIndexBlock indexBlock = FreeIndexBlock{InvalidBlockIndex, {}};
 
+    // Only blocks that were already free as of the last commit are written to.
     auto newBlock = [&]() -> BlockIndex {
       if (!m_availableBlocks.empty())
         return m_availableBlocks.takeFirst();
       else
         return makeEndBlock();
     };
+    auto freedBlocksLeft = [&]() {
+      return !m_availableBlocks.empty() || !m_pendingFreeBlocks.empty();
+    };
+    auto takeFreedBlock = [&]() -> BlockIndex {
+      if (!m_availableBlocks.empty())
+        return m_availableBlocks.takeFirst();
+      else
+        return m_pendingFreeBlocks.takeFirst();
+    };
 
     if (m_headFreeIndexBlock != InvalidBlockIndex)
       indexBlock = readFreeIndexBlock(m_headFreeIndexBlock);
@@ -1097,15 +1246,15 @@ void BTreeDatabase::doCommit() {
     // Then, we need to write all the available blocks to the FreeIndexBlock chain.
     while (true) {
       // If we have room on our current FreeIndexBlock, just add a block to it.
-      if (!m_availableBlocks.empty() && indexBlock.freeBlocks.size() < maxFreeIndexLength()) {
-        BlockIndex toAdd = m_availableBlocks.takeFirst();
+      if (freedBlocksLeft() && indexBlock.freeBlocks.size() < maxFreeIndexLength()) {
+        BlockIndex toAdd = takeFreedBlock();
         indexBlock.freeBlocks.append(toAdd);
       } else {
         // Update the current head free index block.
         writeFreeIndexBlock(m_headFreeIndexBlock, indexBlock);
 
         // If we're out of blocks to free, then we're done
-        if (m_availableBlocks.empty())
+        if (!freedBlocksLeft())
           break;
 
         // If our head free index block is full, then
@@ -1121,20 +1270,52 @@ void BTreeDatabase::doCommit() {
     }
   }
 
-  
-  commitWrites(); 
+  // None of the written blocks are reachable from the committed root, so
+  // snapshot readers only need to be kept out while it is replaced.
+  commitWrites();
   writeRoot();
+  {
+    WriteLocker commitLocker(m_commitLock);
+    if (!m_mapping || (StreamOffset)m_mapping->dataSize() < m_deviceSize)
+      remapDevice();
+    publishCommittedRoot();
+  }
   m_uncommitted.clear();
 }
 
 void BTreeDatabase::commitWrites() {
-  for (auto& write : m_uncommittedWrites)
+  SpinLocker committedCacheLock(m_committedIndexCacheSpinLock);
+  for (auto& write : m_uncommittedWrites) {
     m_device->writeFullAbsolute(HeaderSize + write.first * (StreamOffset)m_blockSize, write.second.ptr(), m_blockSize);
+    m_committedIndexCache.remove(write.first);
+  }
+  committedCacheLock.unlock();
 
   m_device->sync();
   m_uncommittedWrites.clear();
 }
 
+void BTreeDatabase::publishCommittedRoot() {
+  m_committedRoot = m_root;
+  m_committedRootIsLeaf = m_rootIsLeaf;
+  m_committedDeviceSize = m_deviceSize;
+}
+
+void BTreeDatabase::remapDevice() {
+  m_mapping.reset();
+  if (!m_memoryMapped)
+    return;
+
+  if (auto file = as<File>(m_device)) {
+    try {
+      m_mapping = file->map();
+    } catch (IOException const& e) {
+      Logger::warn("[BTreeDatabase] Could not memory map '{}', using regular reads: {}", file->deviceName(), outputException(e, false));
+      m_memoryMapped = false;
+    }
+  }
+}
+
 bool BTreeDatabase::tryFlatten() {
   if (m_headFreeIndexBlock == InvalidBlockIndex || m_rootIsLeaf || !m_device->isWritable())
     return false;
@@ -1165,6 +1346,10 @@ bool BTreeDatabase::tryFlatten() {
     } while (indexBlockIndex != InvalidBlockIndex);
     m_headFreeIndexBlock = InvalidBlockIndex;
 
+    // Flattening overwrites committed blocks under the commit lock anyway, so
+    // blocks freed since the last commit may be reused straight away.
+    availableBlocksList.appendAll(take(m_pendingFreeBlocks));
+
     sort(availableBlocksList);
     for (auto& availableBlock : availableBlocksList)
       m_availableBlocks.insert(m_availableBlocks.end(), availableBlock);
@@ -1172,6 +1357,9 @@ bool BTreeDatabase::tryFlatten() {
 
   BlockIndex count = 1; // 1 to include root index
 
+  m_flattening = true;
+  auto flatteningGuard = finally([this]() { m_flattening = false; });
+
   double start = Time::monotonicTime();
   auto index = m_impl.loadIndex(m_impl.rootPointer());
   if (flattenVisitor(index, count)) {
@@ -1181,11 +1369,17 @@ bool BTreeDatabase::tryFlatten() {
   }
 
   m_availableBlocks.clear();
-  m_device->resize(m_deviceSize = HeaderSize + (StreamOffset)m_blockSize * count);
-
   m_indexCache.clear();
-  commitWrites();
-  writeRoot();
+
+  {
+    WriteLocker commitLocker(m_commitLock);
+    m_mapping.reset();
+    m_device->resize(m_deviceSize = HeaderSize + (StreamOffset)m_blockSize * count);
+    commitWrites();
+    writeRoot();
+    remapDevice();
+    publishCommittedRoot();
+  }
   m_uncommitted.clear();
 
   Logger::info("[BTreeDatabase] Finished flattening '{}' in {:.2f} milliseconds", m_device->deviceName(), (Time::monotonicTime() - start) * 1000.f);
@@ -1244,12 +1438,23 @@ void BTreeDatabase::checkIfOpen(char const* methodName, bool shouldBeOpen) const
     throw DBException::format("BTreeDatabase method '{}' called when open, cannot call when open.", methodName);
 }
 
+void BTreeDatabase::checkIfCommittedOpen(char const* methodName) const {
+  if (m_committedRoot == InvalidBlockIndex)
+    throw DBException::format("BTreeDatabase method '{}' called when not open, must be open.", methodName);
+}
+
 void BTreeDatabase::checkBlockIndex(size_t blockIndex) const {
   BlockIndex blockCount = (m_deviceSize - HeaderSize) / m_blockSize;
   if (blockIndex >= blockCount)
     throw DBException::format("blockIndex: {} out of block range", blockIndex);
 }
 
+void BTreeDatabase::checkCommittedBlockIndex(size_t blockIndex) const {
+  BlockIndex blockCount = (m_committedDeviceSize - HeaderSize) / m_blockSize;
+  if (blockIndex >= blockCount)
+    throw DBException::format("blockIndex: {} out of committed block range", blockIndex);
+}
+
 void BTreeDatabase::checkKeySize(ByteArray const& k) const {
   if (k.size() != m_keySize)
     throw DBException::format("Wrong key size {}", k.size());
@@ -5,6 +5,7 @@
 #include "StarLruCache.hpp"
 #include "StarDataStreamDevices.hpp"
 #include "StarThread.hpp"
+#include "StarFile.hpp"
 
 namespace Star {
 
@@ -49,6 +50,13 @@ public:
   IODevicePtr ioDevice() const;
   void setIODevice(IODevicePtr device);
 
+  // If true and the IODevice is a File, committed blocks are read from a
+  // read-only memory mapping of the file rather than with a system call per
+  // block, and index nodes are decoded straight from the mapped memory.  Falls
+  // back to regular reads if the file cannot be mapped.  Defaults to true.
+  bool memoryMapped() const;
+  void setMemoryMapped(bool memoryMapped);
+
   // If an existing database is opened, this will update the key size, block
   // size, and content identifier with those from the opened database.
   // Otherwise, it will use the currently set values.  Returns true if a new
@@ -66,6 +74,19 @@ public:
   void forAll(function<void(ByteArray, ByteArray)> v);
   void recoverAll(function<void(ByteArray, ByteArray)> v, function<void(String const&, std::exception const&)> e);
 
+  // Snapshot versions of the read methods, which only see the state of the
+  // database as of the last commit and ignore any uncommitted writes.  These
+  // never wait on writers or on other readers, only on the moment a commit
+  // publishes its new root after it has been written and synced, so long range
+  // scans may run concurrently with inserts, removes and commits on another
+  // thread.  The IODevice must allow reads and writes at different absolute
+  // offsets at the same time, as File does.
+  bool containsCommitted(ByteArray const& k);
+  Maybe<ByteArray> findCommitted(ByteArray const& k);
+  List<pair<ByteArray, ByteArray>> findCommitted(ByteArray const& lower, ByteArray const& upper);
+  void forEachCommitted(ByteArray const& lower, ByteArray const& upper, function<void(ByteArray, ByteArray)> v);
+  void forAllCommitted(function<void(ByteArray, ByteArray)> v);
+
   // Returns true if a value was overwritten
   bool insert(ByteArray const& k, ByteArray const& data);
 
@@ -222,7 +243,15 @@ private:
     Maybe<Pointer> nextLeaf(Leaf const& leaf);
     void setNextLeaf(Leaf& leaf, Maybe<Pointer> n);
 
+    void readNode(Pointer pointer, char* block);
+    // Returns the block in the memory mapped device, or null if the block is
+    // not mapped or has uncommitted changes.
+    char const* mappedNode(Pointer pointer);
+
     BTreeDatabase* parent;
+    // If true, this tree only reads the last committed root directly from the
+    // device, and must never be written to.
+    bool committed;
   };
 
   void readBlock(BlockIndex blockIndex, size_t blockOffset, char* block, size_t size) const;
@@ -230,6 +259,8 @@ private:
   void updateBlock(BlockIndex blockIndex, ByteArray const& block);
 
   void rawReadBlock(BlockIndex blockIndex, size_t blockOffset, char* block, size_t size) const;
+  void readCommittedBlock(BlockIndex blockIndex, size_t blockOffset, char* block, size_t size) const;
+  char const* mappedBlock(BlockIndex blockIndex) const;
   void rawWriteBlock(BlockIndex blockIndex, size_t blockOffset, char const* block, size_t size);
 
   void updateHeadFreeIndexBlock(BlockIndex newHead);
@@ -252,11 +283,17 @@ private:
   void readRoot();
   void doCommit();
   void commitWrites();
+  // Must be called with m_commitLock held for writing.
+  void publishCommittedRoot();
+  // Must be called with both m_lock and m_commitLock held for writing.
+  void remapDevice();
   bool tryFlatten();
   bool flattenVisitor(BTreeImpl::Index& index, BlockIndex& count);
 
   void checkIfOpen(char const* methodName, bool shouldBeOpen) const;
+  void checkIfCommittedOpen(char const* methodName) const;
   void checkBlockIndex(size_t blockIndex) const;
+  void checkCommittedBlockIndex(size_t blockIndex) const;
   void checkKeySize(ByteArray const& k) const;
   uint32_t maxFreeIndexLength() const;
 
@@ -264,9 +301,20 @@ private:
 
   BTreeMixin<BTreeImpl> m_impl;
 
+  // Held for reading by the snapshot read methods, and for writing only while
+  // the committed root or the mapping is being replaced, or while flattening
+  // moves committed blocks.  Always acquired after m_lock, never before.
+  mutable ReadersWriterMutex m_commitLock;
+  BTreeMixin<BTreeImpl> m_committedImpl;
+
   IODevicePtr m_device;
   bool m_open;
 
+  // Only replaced while holding both m_lock and m_commitLock for writing, so
+  // holding either one for reading is enough to read through it.
+  bool m_memoryMapped;
+  FileMappingPtr m_mapping;
+
   uint32_t m_blockSize;
   String m_contentIdentifier;
   uint32_t m_keySize;
@@ -280,17 +328,31 @@ private:
   mutable SpinLock m_indexCacheSpinLock;
   LruCache<BlockIndex, shared_ptr<IndexNode>> m_indexCache;
 
+  // Index nodes read by the snapshot read methods are never shared with the
+  // writer, which modifies its cached nodes in place.
+  mutable SpinLock m_committedIndexCacheSpinLock;
+  LruCache<BlockIndex, shared_ptr<IndexNode>> m_committedIndexCache;
+
   BlockIndex m_headFreeIndexBlock;
   StreamOffset m_deviceSize;
   BlockIndex m_root;
   bool m_rootIsLeaf;
+  BlockIndex m_committedRoot;
+  bool m_committedRootIsLeaf;
+  StreamOffset m_committedDeviceSize;
   bool m_usingAltRoot;
   bool m_dirty;
+  bool m_flattening;
 
   // Blocks that can be freely allocated and written to without violating
   // atomic consistency.
   Set<BlockIndex> m_availableBlocks;
 
+  // Blocks freed from the committed tree since the last commit.  They are
+  // still read by snapshot readers, so they are only recorded as free by the
+  // next commit and never written to before it.
+  Set<BlockIndex> m_pendingFreeBlocks;
+
   // Blocks that have been written in uncommitted portions of the tree.
   Set<BlockIndex> m_uncommitted;
 
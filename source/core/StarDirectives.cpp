@@ -3,9 +3,46 @@
 #include "StarImageProcessing.hpp"
 #include "StarXXHash.hpp"
 #include "StarLogging.hpp"
+#include "StarLruCache.hpp"
 
 namespace Star {
 
+namespace {
+  size_t const PipelineCacheSize = 1024;
+  size_t const PipelineCacheStripeCount = 16;
+
+  // Compiled pipelines are keyed by DirectivesGroup::hash(), and keep the
+  // directives they were compiled from so that a hash collision is never
+  // taken for a hit.
+  struct CachedPipeline {
+    List<Directives> source;
+    shared_ptr<ImageOperationPipeline const> pipeline;
+  };
+
+  // Split into separately locked stripes, so that threads applying different
+  // directives do not wait on each other.
+  struct PipelineCacheStripe {
+    PipelineCacheStripe() : cache(PipelineCacheSize / PipelineCacheStripeCount) {}
+
+    Mutex mutex;
+    HashLruCache<size_t, CachedPipeline> cache;
+  };
+
+  bool sameDirectives(List<Directives> const& a, List<Directives> const& b) {
+    if (a.size() != b.size())
+      return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+      if (a[i].m_shared == b[i].m_shared)
+        continue;
+      String const* aString = a[i].stringPtr();
+      String const* bString = b[i].stringPtr();
+      if (!aString || !bString || *aString != *bString)
+        return false;
+    }
+    return true;
+  }
+}
+
 Directives::Entry::Entry(ImageOperation&& newOperation, size_t strBegin, size_t strLength) {
   operation = std::move(newOperation);
   begin = strBegin;
@@ -376,20 +413,48 @@ Image DirectivesGroup::applyNewImage(Image const& image, ImageReferenceCallback
 }
 
 void DirectivesGroup::applyExistingImage(Image& image, ImageReferenceCallback refCallback) const {
-  bool first = true;
-  forEach([&](Directives::Entry const& entry, Directives const& directives) {
-    ImageOperation const& operation = entry.loadOperation(*directives);
-    if (auto error = operation.ptr<ErrorImageOperation>())
-      if (auto string = error->cause.ptr<std::string>())
-        throw DirectivesException::format("ImageOperation parse error: {}", *string);
+  if (empty())
+    return;
+
+  // The same directives are usually applied to many different images (every
+  // frame sheet of a dyed piece of armor, say), so compiled pipelines are
+  // shared between all of them.
+  static Array<PipelineCacheStripe, PipelineCacheStripeCount> s_pipelineCache;
+
+  size_t directivesHash = hash();
+  auto& stripe = s_pipelineCache[directivesHash % PipelineCacheStripeCount];
+  shared_ptr<ImageOperationPipeline const> pipeline;
+  {
+    MutexLocker locker(stripe.mutex);
+    if (auto cached = stripe.cache.ptr(directivesHash)) {
+      if (sameDirectives(cached->source, m_directives))
+        pipeline = cached->pipeline;
+    }
+  }
+
+  if (!pipeline) {
+    auto newPipeline = make_shared<ImageOperationPipeline>();
+    bool first = true;
+    forEach([&](Directives::Entry const& entry, Directives const& directives) {
+      ImageOperation const& operation = entry.loadOperation(*directives);
+      if (auto error = operation.ptr<ErrorImageOperation>())
+        if (auto string = error->cause.ptr<std::string>())
+          throw DirectivesException::format("ImageOperation parse error: {}", *string);
+        else
+          std::rethrow_exception(error->cause.get<std::exception_ptr>());
+      else if (!first && entry.begin != 0 && operation.is<NullImageOperation>())
+        throw DirectivesException::format("Invalid image operation: {}", entry.string(*directives));
       else
-        std::rethrow_exception(error->cause.get<std::exception_ptr>());
-    else if (!first && entry.begin != 0 && operation.is<NullImageOperation>())
-      throw DirectivesException::format("Invalid image operation: {}", entry.string(*directives));
-    else
-      processImageOperation(operation, image, refCallback);
-    first = false;
-  });
+        newPipeline->append(operation);
+      first = false;
+    });
+
+    pipeline = newPipeline;
+    MutexLocker locker(stripe.mutex);
+    stripe.cache.set(directivesHash, CachedPipeline{m_directives, pipeline});
+  }
+
+  pipeline->process(image, refCallback);
 }
 
 size_t DirectivesGroup::hash() const {
@@ -1,5 +1,6 @@
 #include "StarFile.hpp"
 #include "StarFormat.hpp"
+#include "StarMathCommon.hpp"
 
 #include <fstream>
 
@@ -254,4 +255,103 @@ IODevicePtr File::clone() {
   return cloned;
 }
 
+FileMappingPtr File::map() {
+  if (!m_file)
+    throw IOException("map called on closed File");
+
+  if (!isReadable())
+    throw IOException("map called on non-readable File");
+
+  StreamOffset fileSize = fsize(m_file);
+  if (fileSize <= 0)
+    throw IOException::format("Cannot map empty file '{}'", deviceName());
+  if ((StreamOffset)(size_t)fileSize != fileSize)
+    throw IOException::format("File '{}' is too large to map", deviceName());
+
+  auto region = make_shared<FileMapping::Region>();
+  region->size = fileSize;
+  region->handle = nullptr;
+  region->data = mmap(m_file, region->size, region->handle);
+  region->name = deviceName();
+  return FileMappingPtr(new FileMapping(std::move(region)));
+}
+
+bool File::tryLock() {
+  if (!m_file)
+    throw IOException("tryLock called on closed File");
+
+  return flock(m_file);
+}
+
+FileMapping::Region::~Region() {
+  File::munmap(data, size, handle);
+}
+
+FileMapping::FileMapping(shared_ptr<Region const> region)
+  : m_region(std::move(region)), m_pos(0) {
+  setMode(IOMode::Read);
+}
+
+StreamOffset FileMapping::pos() {
+  return m_pos;
+}
+
+void FileMapping::seek(StreamOffset pos, IOSeek mode) {
+  if (mode == IOSeek::Absolute)
+    m_pos = pos;
+  else if (mode == IOSeek::Relative)
+    m_pos = clamp<StreamOffset>(m_pos + pos, 0, m_region->size);
+  else
+    m_pos = clamp<StreamOffset>(m_region->size - pos, 0, m_region->size);
+}
+
+bool FileMapping::atEnd() {
+  return m_pos >= m_region->size;
+}
+
+size_t FileMapping::read(char* data, size_t len) {
+  size_t l = readAbsolute(m_pos, data, len);
+  m_pos += l;
+  return l;
+}
+
+size_t FileMapping::write(char const*, size_t) {
+  throw IOException("Error, FileMapping is not writable");
+}
+
+size_t FileMapping::readAbsolute(StreamOffset readPosition, char* data, size_t len) {
+  if (readPosition < 0 || (StreamOffset)m_region->size <= readPosition)
+    return 0;
+
+  size_t l = min<size_t>(m_region->size - readPosition, len);
+  memcpy(data, m_region->data + readPosition, l);
+  return l;
+}
+
+size_t FileMapping::writeAbsolute(StreamOffset, char const*, size_t) {
+  throw IOException("Error, FileMapping is not writable");
+}
+
+String FileMapping::deviceName() const {
+  return m_region->name;
+}
+
+StreamOffset FileMapping::size() {
+  return m_region->size;
+}
+
+IODevicePtr FileMapping::clone() {
+  auto cloned = make_shared<FileMapping>(*this);
+  cloned->m_pos = 0;
+  return cloned;
+}
+
+char const* FileMapping::ptr() const {
+  return m_region->data;
+}
+
+size_t FileMapping::dataSize() const {
+  return m_region->size;
+}
+
 }
@@ -6,6 +6,7 @@
 namespace Star {
 
 STAR_CLASS(File);
+STAR_CLASS(FileMapping);
 
 // All file methods are thread safe.
 class File : public IODevice {
@@ -129,7 +130,21 @@ public:
 
   IODevicePtr clone() override;
 
+  // Maps the current contents of the file read-only into memory.  The File
+  // must be open and readable and not empty.  Writes made through the File
+  // after mapping are visible through the mapping, but the mapping does not
+  // grow with the file, and the file must not be truncated below the mapped
+  // size while the mapping is being read.
+  FileMappingPtr map();
+
+  // Takes an advisory lock on the file that excludes every other process
+  // trying to lock it, and is held until the file is closed.  Returns false
+  // if another process holds the lock.
+  bool tryLock();
+
 private:
+  friend class FileMapping;
+
   static void* fopen(char const* filename, IOMode mode);
   static void fseek(void* file, StreamOffset offset, IOSeek seek);
   static StreamOffset ftell(void* file);
@@ -141,9 +156,59 @@ private:
   static size_t pread(void* file, char* data, size_t len, StreamOffset absPosition);
   static size_t pwrite(void* file, char const* data, size_t len, StreamOffset absPosition);
   static void resize(void* file, StreamOffset size);
+  static char const* mmap(void* file, size_t size, void*& mappingHandle);
+  static void munmap(char const* data, size_t size, void* mappingHandle);
+  static bool flock(void* file);
 
   String m_filename;
   void* m_file;
 };
 
+// Read-only IODevice over a memory mapping created by File::map.  Reads are
+// plain memory copies and never make a system call, and ptr() allows decoding
+// directly from the mapped memory.  The mapping stays valid for as long as any
+// FileMapping sharing it exists, even if the File it came from is closed.
+class FileMapping : public IODevice {
+public:
+  FileMapping(FileMapping const& mapping) = default;
+
+  StreamOffset pos() override;
+  void seek(StreamOffset pos, IOSeek mode = IOSeek::Absolute) override;
+  bool atEnd() override;
+
+  size_t read(char* data, size_t len) override;
+  size_t write(char const* data, size_t len) override;
+
+  size_t readAbsolute(StreamOffset readPosition, char* data, size_t len) override;
+  size_t writeAbsolute(StreamOffset writePosition, char const* data, size_t len) override;
+
+  String deviceName() const override;
+
+  StreamOffset size() override;
+
+  IODevicePtr clone() override;
+
+  // Pointer to the start of the mapped file contents.
+  char const* ptr() const;
+  // Same thing as size(), just size_t type (since this is in-memory)
+  size_t dataSize() const;
+
+private:
+  friend class File;
+
+  struct Region {
+    ~Region();
+
+    char const* data;
+    size_t size;
+    void* handle;
+    String name;
+  };
+
+  FileMapping(shared_ptr<Region const> region);
+
+  shared_ptr<Region const> m_region;
+  size_t m_pos;
+};
+
 }
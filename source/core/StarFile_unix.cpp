@@ -12,6 +12,8 @@
 #include <libgen.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 
 #ifdef STAR_SYSTEM_MACOSX
 #include <mach-o/dyld.h>
@@ -291,9 +293,28 @@ size_t File::pwrite(void* file, char const* data, size_t len, StreamOffset posit
   return ::pwrite(fdFromHandle(file), data, len, position);
 }
 
+bool File::flock(void* file) {
+  if (::flock(fdFromHandle(file), LOCK_EX | LOCK_NB) == 0)
+    return true;
+  if (errno == EWOULDBLOCK)
+    return false;
+  throw IOException::format("flock error: {}", strerror(errno));
+}
+
 void File::resize(void* f, StreamOffset size) {
   if (::ftruncate(fdFromHandle(f), size) < 0)
     throw IOException::format("resize error: {}", strerror(errno));
 }
 
+char const* File::mmap(void* f, size_t size, void*&) {
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fdFromHandle(f), 0);
+  if (data == MAP_FAILED)
+    throw IOException::format("mmap error: {}", strerror(errno));
+  return (char const*)data;
+}
+
+void File::munmap(char const* data, size_t size, void*) {
+  ::munmap((void*)data, size);
+}
+
 }
@@ -401,6 +401,19 @@ size_t File::pwrite(void* f, char const* data, size_t len, StreamOffset position
   return numWritten;
 }
 
+bool File::flock(void* f) {
+  HANDLE file = (HANDLE)f;
+  // Windows file locks are mandatory, so lock a byte far past the end of any
+  // real file so that it only excludes other locks.
+  OVERLAPPED overlapped = makeOverlapped(std::numeric_limits<int64_t>::max() - 1);
+  if (LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped))
+    return true;
+  auto err = GetLastError();
+  if (err == ERROR_LOCK_VIOLATION || err == ERROR_IO_PENDING)
+    return false;
+  throw IOException::format("LockFileEx error {}", err);
+}
+
 void File::resize(void* f, StreamOffset size) {
   HANDLE file = (HANDLE)f;
   LARGE_INTEGER s;
@@ -409,4 +422,26 @@ void File::resize(void* f, StreamOffset size) {
   SetEndOfFile(file);
 }
 
+char const* File::mmap(void* f, size_t size, void*& mappingHandle) {
+  HANDLE file = (HANDLE)f;
+  HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL)
+    throw IOException::format("CreateFileMapping error {}", GetLastError());
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+  if (data == NULL) {
+    auto err = GetLastError();
+    CloseHandle(mapping);
+    throw IOException::format("MapViewOfFile error {}", err);
+  }
+
+  mappingHandle = mapping;
+  return (char const*)data;
+}
+
+void File::munmap(char const* data, size_t, void* mappingHandle) {
+  UnmapViewOfFile(data);
+  CloseHandle((HANDLE)mappingHandle);
+}
+
 }
@@ -358,20 +358,27 @@ StringList imageOperationReferences(List<ImageOperation> const& operations) {
 #pragma GCC push_options
 #pragma GCC optimize("-fno-fast-math", "-fassociative-math", "-freciprocal-math")
 #endif
+static Vec4B saturationShiftPixel(Vec4B pixel, float saturationShiftAmount) {
+  Color color = Color::rgba(pixel);
+  color.setSaturation(clamp(color.saturation() + saturationShiftAmount, 0.0f, 1.0f));
+  return color.toRgba();
+}
+
 static void processSaturationShift(Image& image, SaturationShiftImageOperation const* op) {
   image.forEachPixel([&op](unsigned, unsigned, Vec4B& pixel) {
-    if (pixel[3] != 0) {
-      Color color = Color::rgba(pixel);
-      color.setSaturation(clamp(color.saturation() + op->saturationShiftAmount, 0.0f, 1.0f));
-      pixel = color.toRgba();
-    }
+    if (pixel[3] != 0)
+      pixel = saturationShiftPixel(pixel, op->saturationShiftAmount);
   });
 }
 #ifdef STAR_COMPILER_GNU
 #pragma GCC pop_options
 #endif
 
-
+static Vec4B brightnessMultiplyPixel(Vec4B pixel, float brightnessMultiply) {
+  Color color = Color::rgba(pixel);
+  color.setValue(clamp(color.value() * brightnessMultiply, 0.0f, 1.0f));
+  return color.toRgba();
+}
 
 void processImageOperation(ImageOperation const& operation, Image& image, ImageReferenceCallback refCallback) {
   if (image.bytesPerPixel() == 3) {
@@ -387,11 +394,8 @@ void processImageOperation(ImageOperation const& operation, Image& image, ImageR
     processSaturationShift(image, op);
   } else if (auto op = operation.ptr<BrightnessMultiplyImageOperation>()) {
     image.forEachPixel([&op](unsigned, unsigned, Vec4B& pixel) {
-      if (pixel[3] != 0) {
-        Color color = Color::rgba(pixel);
-        color.setValue(clamp(color.value() * op->brightnessMultiply, 0.0f, 1.0f));
-        pixel = color.toRgba();
-      }
+      if (pixel[3] != 0)
+        pixel = brightnessMultiplyPixel(pixel, op->brightnessMultiply);
     });
   } else if (auto op = operation.ptr<FadeToColorImageOperation>()) {
     image.forEachPixel([&op](unsigned, unsigned, Vec4B& pixel) {
@@ -588,10 +592,209 @@ void processImageOperation(ImageOperation const& operation, Image& image, ImageR
   }
 }
 
-Image processImageOperations(List<ImageOperation> const& operations, Image image, ImageReferenceCallback refCallback) {
+static uint32_t packPixel(Vec4B const& pixel) {
+  return (uint32_t)pixel[0] | (uint32_t)pixel[1] << 8 | (uint32_t)pixel[2] << 16 | (uint32_t)pixel[3] << 24;
+}
+
+static Vec4B unpackPixel(uint32_t pixel) {
+  return Vec4B(pixel, pixel >> 8, pixel >> 16, pixel >> 24);
+}
+
+PixelOperationKernel::ChannelTables::ChannelTables() {
+  for (auto& table : tables) {
+    for (size_t i = 0; i < 256; ++i)
+      table[i] = i;
+  }
+}
+
+PixelOperationKernel::ColorReplaceTable::ColorReplaceTable(ColorReplaceMap const& colorReplaceMap)
+  : ColorReplaceTable(colorReplaceMap.pairs().transformed([](pair<Vec4B, Vec4B> const& p) {
+      return make_pair(packPixel(p.first), packPixel(p.second));
+    })) {}
+
+PixelOperationKernel::ColorReplaceTable::ColorReplaceTable(List<pair<uint32_t, uint32_t>> entries) {
+  entries.sort();
+  for (auto const& entry : entries) {
+    if (entry.first != entry.second) {
+      from.append(entry.first);
+      to.append(entry.second);
+    }
+  }
+}
+
+auto PixelOperationKernel::ColorReplaceTable::compose(ColorReplaceTable const& next) const -> ColorReplaceTable {
+  List<pair<uint32_t, uint32_t>> entries;
+  for (size_t i = 0; i < from.size(); ++i)
+    entries.append({from[i], next.lookup(to[i]).value(to[i])});
+  for (size_t i = 0; i < next.from.size(); ++i) {
+    if (!lookup(next.from[i]))
+      entries.append({next.from[i], next.to[i]});
+  }
+  return ColorReplaceTable(std::move(entries));
+}
+
+Maybe<uint32_t> PixelOperationKernel::ColorReplaceTable::lookup(uint32_t pixel) const {
+  auto i = std::lower_bound(from.begin(), from.end(), pixel);
+  if (i == from.end() || *i != pixel)
+    return {};
+  return to[i - from.begin()];
+}
+
+bool PixelOperationKernel::fusable(ImageOperation const& operation) {
+  return operation.is<HueShiftImageOperation>() || operation.is<SaturationShiftImageOperation>()
+    || operation.is<BrightnessMultiplyImageOperation>() || operation.is<FadeToColorImageOperation>()
+    || operation.is<ScanLinesImageOperation>() || operation.is<SetColorImageOperation>()
+    || operation.is<ColorReplaceImageOperation>() || operation.is<MultiplyImageOperation>();
+}
+
+bool PixelOperationKernel::empty() const {
+  return m_steps.empty();
+}
+
+void PixelOperationKernel::append(ImageOperation const& operation) {
+  if (auto op = operation.ptr<FadeToColorImageOperation>()) {
+    auto& tables = channelTables().tables;
+    for (size_t i = 0; i < 256; ++i) {
+      tables[0][i] = op->rTable[tables[0][i]];
+      tables[1][i] = op->gTable[tables[1][i]];
+      tables[2][i] = op->bTable[tables[2][i]];
+    }
+  } else if (auto op = operation.ptr<SetColorImageOperation>()) {
+    auto& tables = channelTables().tables;
+    for (size_t c = 0; c < 3; ++c)
+      tables[c].fill(op->color[c]);
+  } else if (auto op = operation.ptr<MultiplyImageOperation>()) {
+    auto& tables = channelTables().tables;
+    for (size_t c = 0; c < 4; ++c) {
+      for (auto& value : tables[c])
+        value = (uint8_t)(((int)value * (int)op->color[c]) / 255);
+    }
+  } else if (auto op = operation.ptr<ColorReplaceImageOperation>()) {
+    ColorReplaceTable table(op->colorReplaceMap);
+    if (!m_steps.empty()) {
+      if (auto last = m_steps.last().ptr<ColorReplaceTable>()) {
+        *last = last->compose(table);
+        return;
+      }
+    }
+    m_steps.append(std::move(table));
+  } else if (auto op = operation.ptr<HueShiftImageOperation>()) {
+    m_steps.append(*op);
+  } else if (auto op = operation.ptr<SaturationShiftImageOperation>()) {
+    m_steps.append(*op);
+  } else if (auto op = operation.ptr<BrightnessMultiplyImageOperation>()) {
+    m_steps.append(*op);
+  } else if (auto op = operation.ptr<ScanLinesImageOperation>()) {
+    m_steps.append(*op);
+  } else {
+    throw ImageOperationException::format("Cannot add '{}' to a PixelOperationKernel", imageOperationToString(operation));
+  }
+}
+
+Vec4B PixelOperationKernel::apply(Vec4B pixel, unsigned y) const {
+  for (auto const& step : m_steps) {
+    if (auto channelTables = step.ptr<ChannelTables>()) {
+      for (size_t c = 0; c < 4; ++c)
+        pixel[c] = channelTables->tables[c][pixel[c]];
+    } else if (auto table = step.ptr<ColorReplaceTable>()) {
+      if (auto replacement = table->lookup(packPixel(pixel)))
+        pixel = unpackPixel(*replacement);
+    } else if (auto op = step.ptr<HueShiftImageOperation>()) {
+      if (pixel[3] != 0)
+        pixel = Color::hueShiftVec4B(pixel, op->hueShiftAmount);
+    } else if (auto op = step.ptr<SaturationShiftImageOperation>()) {
+      if (pixel[3] != 0)
+        pixel = saturationShiftPixel(pixel, op->saturationShiftAmount);
+    } else if (auto op = step.ptr<BrightnessMultiplyImageOperation>()) {
+      if (pixel[3] != 0)
+        pixel = brightnessMultiplyPixel(pixel, op->brightnessMultiply);
+    } else if (auto op = step.ptr<ScanLinesImageOperation>()) {
+      auto const& fade = y % 2 == 0 ? op->fade1 : op->fade2;
+      pixel[0] = fade.rTable[pixel[0]];
+      pixel[1] = fade.gTable[pixel[1]];
+      pixel[2] = fade.bTable[pixel[2]];
+    }
+  }
+  return pixel;
+}
+
+void PixelOperationKernel::process(Image& image) const {
+  if (image.bytesPerPixel() != 4)
+    throw ImageOperationException("PixelOperationKernel requires a 32 bit image");
+
+  uint8_t* data = image.data();
+  size_t width = image.width();
+  for (unsigned y = 0; y < image.height(); ++y) {
+    // Sprites are mostly made up of runs of the same color, so the result for
+    // the last pixel is very often the result for the next one.
+    uint8_t* row = data + y * width * 4;
+    Maybe<pair<uint32_t, Vec4B>> last;
+    for (size_t x = 0; x < width; ++x) {
+      uint8_t* p = row + x * 4;
+      Vec4B pixel(p[0], p[1], p[2], p[3]);
+      uint32_t packed = packPixel(pixel);
+      if (!last || last->first != packed)
+        last = make_pair(packed, apply(pixel, y));
+      p[0] = last->second[0];
+      p[1] = last->second[1];
+      p[2] = last->second[2];
+      p[3] = last->second[3];
+    }
+  }
+}
+
+auto PixelOperationKernel::channelTables() -> ChannelTables& {
+  if (m_steps.empty() || !m_steps.last().is<ChannelTables>())
+    m_steps.append(ChannelTables());
+  return m_steps.last().get<ChannelTables>();
+}
+
+ImageOperationPipeline::ImageOperationPipeline() : m_operationCount(0) {}
+
+ImageOperationPipeline::ImageOperationPipeline(List<ImageOperation> const& operations) : ImageOperationPipeline() {
   for (auto const& operation : operations)
-    processImageOperation(operation, image, refCallback);
+    append(operation);
+}
+
+void ImageOperationPipeline::append(ImageOperation const& operation) {
+  ++m_operationCount;
+  if (operation.is<NullImageOperation>() || operation.is<ErrorImageOperation>())
+    return;
+
+  if (PixelOperationKernel::fusable(operation)) {
+    if (m_passes.empty() || !m_passes.last().is<PixelOperationKernel>())
+      m_passes.append(PixelOperationKernel());
+    m_passes.last().get<PixelOperationKernel>().append(operation);
+  } else {
+    m_passes.append(operation);
+  }
+}
+
+bool ImageOperationPipeline::empty() const {
+  return m_operationCount == 0;
+}
+
+size_t ImageOperationPipeline::passes() const {
+  return m_passes.size();
+}
+
+void ImageOperationPipeline::process(Image& image, ImageReferenceCallback refCallback) const {
+  if (m_operationCount == 0)
+    return;
 
+  if (image.bytesPerPixel() == 3)
+    image = image.convert(image.pixelFormat() == PixelFormat::BGR24 ? PixelFormat::BGRA32 : PixelFormat::RGBA32);
+
+  for (auto const& pass : m_passes) {
+    if (auto kernel = pass.ptr<PixelOperationKernel>())
+      kernel->process(image);
+    else
+      processImageOperation(pass.get<ImageOperation>(), image, refCallback);
+  }
+}
+
+Image processImageOperations(List<ImageOperation> const& operations, Image image, ImageReferenceCallback refCallback) {
+  ImageOperationPipeline(operations).process(image, refCallback);
   return image;
 }
 
@@ -156,6 +156,75 @@ typedef function<Image const*(String const& refName)> ImageReferenceCallback;
 
 void processImageOperation(ImageOperation const& operation, Image& input, ImageReferenceCallback refCallback = {});
 
+// A run of operations that only depend on the value of each pixel (and its
+// row, for scan lines), applied together in a single pass over the image.
+// Operations that work on each channel separately are folded into one set of
+// lookup tables, and consecutive color replacements into one sorted table.
+// The HSV operations are left scalar rather than done four pixels at a time
+// with SSE2 like CellularLightArray: they branch per pixel on the hue sector,
+// and must keep the exact float math of the unfused operations, while runs of
+// identical pixels already skip them entirely.
+class PixelOperationKernel {
+public:
+  static bool fusable(ImageOperation const& operation);
+
+  bool empty() const;
+  // Operation must be fusable
+  void append(ImageOperation const& operation);
+
+  Vec4B apply(Vec4B pixel, unsigned y) const;
+  // Image must be 32 bits per pixel
+  void process(Image& image) const;
+
+private:
+  struct ChannelTables {
+    ChannelTables();
+
+    Array<Array<uint8_t, 256>, 4> tables;
+  };
+
+  struct ColorReplaceTable {
+    ColorReplaceTable(ColorReplaceMap const& colorReplaceMap);
+    ColorReplaceTable(List<pair<uint32_t, uint32_t>> entries);
+
+    // The table that has the same effect as this table followed by next
+    ColorReplaceTable compose(ColorReplaceTable const& next) const;
+    Maybe<uint32_t> lookup(uint32_t pixel) const;
+
+    // Sorted
+    List<uint32_t> from;
+    List<uint32_t> to;
+  };
+
+  typedef Variant<ChannelTables, ColorReplaceTable, HueShiftImageOperation, SaturationShiftImageOperation,
+    BrightnessMultiplyImageOperation, ScanLinesImageOperation> Step;
+
+  ChannelTables& channelTables();
+
+  List<Step> m_steps;
+};
+
+// A list of image operations, with each run of fusable operations compiled
+// into a PixelOperationKernel.  Produces the same result as applying every
+// operation in turn.
+class ImageOperationPipeline {
+public:
+  ImageOperationPipeline();
+  ImageOperationPipeline(List<ImageOperation> const& operations);
+
+  void append(ImageOperation const& operation);
+
+  bool empty() const;
+  // The number of passes made over the image by process
+  size_t passes() const;
+
+  void process(Image& image, ImageReferenceCallback refCallback = {}) const;
+
+private:
+  List<Variant<PixelOperationKernel, ImageOperation>> m_passes;
+  size_t m_operationCount;
+};
+
 Image processImageOperations(List<ImageOperation> const& operations, Image input, ImageReferenceCallback refCallback = {});
 
 }
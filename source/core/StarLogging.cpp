@@ -107,6 +107,11 @@ Map<String, String> LogMap::getValues() {
   return Map<String, String>::from(s_logMap);
 }
 
+void LogMap::remove(String const& key) {
+  MutexLocker locker(s_logMapMutex);
+  s_logMap.remove(key);
+}
+
 void LogMap::clear() {
   MutexLocker locker(s_logMapMutex);
   s_logMap.clear();
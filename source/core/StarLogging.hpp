@@ -102,6 +102,7 @@ public:
   static void set(String const& key, T const& t);
 
   static Map<String, String> getValues();
+  static void remove(String const& key);
   static void clear();
 
 private:
@@ -146,7 +146,7 @@ LuaValue LuaConverter<Json>::from(LuaEngine& engine, Json const& v) {
   } else if (v.isType(Json::Type::String)) {
     return engine.createString(*v.stringPtr());
   } else {
-    return LuaDetail::jsonContainerToTable(engine, v);
+    return engine.createJsonContainer(v);
   }
 }
 
@@ -166,8 +166,8 @@ Maybe<Json> LuaConverter<Json>::to(LuaEngine&, LuaValue const& v) {
   if (auto s = v.ptr<LuaString>())
     return Json(s->toString());
 
-  if (v.is<LuaTable>())
-    return LuaDetail::tableToJsonContainer(v.get<LuaTable>());
+  if (auto t = v.ptr<LuaTable>())
+    return t->engine().jsonContainerFromTable(*t);
 
   return {};
 }
@@ -209,16 +209,19 @@ Maybe<JsonArray> LuaConverter<JsonArray>::to(LuaEngine& engine, LuaValue v) {
 LuaEnginePtr LuaEngine::create(bool safe) {
   LuaEnginePtr self(new LuaEngine);
 
-  self->m_state = lua_newstate(allocate, nullptr);
+  self->m_allocatedBytes = 0;
+  self->m_state = lua_newstate(allocate, self.get());
 
   self->m_scriptDefaultEnvRegistryId = LUA_NOREF;
   self->m_wrappedFunctionMetatableRegistryId = LUA_NOREF;
   self->m_requireFunctionMetatableRegistryId = LUA_NOREF;
+  self->m_jsonNewIndexRegistryId = LUA_NOREF;
 
   self->m_instructionLimit = 0;
   self->m_profilingEnabled = false;
   self->m_instructionMeasureInterval = 1000;
   self->m_instructionCount = 0;
+  self->m_totalInstructionCount = 0;
   self->m_recursionLevel = 0;
   self->m_recursionLimit = 0;
   self->m_nullTerminated = 0;
@@ -282,6 +285,27 @@ LuaEnginePtr LuaEngine::create(bool safe) {
   LuaDetail::rawSetField(self->m_state, -2, "__metatable");
   self->m_requireFunctionMetatableRegistryId = luaL_ref(self->m_state, LUA_REGISTRYINDEX);
 
+  // Create the common __newindex function for json container tables, which
+  // keeps track of nil entries in the __nils table of the metatable
+  lua_pushcfunction(self->m_state, [](lua_State* state) {
+      lua_settop(state, 3);
+      if (lua_getmetatable(state, 1)) {
+        LuaDetail::rawGetField(state, -1, "__nils");
+        if (lua_istable(state, -1)) {
+          lua_pushvalue(state, 2);
+          if (lua_isnil(state, 3))
+            lua_pushinteger(state, 0);
+          else
+            lua_pushnil(state);
+          lua_rawset(state, -3);
+        }
+        lua_settop(state, 3);
+      }
+      lua_rawset(state, 1);
+      return 0;
+    });
+  self->m_jsonNewIndexRegistryId = luaL_ref(self->m_state, LUA_REGISTRYINDEX);
+
   // Load all base libraries and prune them of unsafe functions
 
   luaL_requiref(self->m_state, "_ENV", luaopen_base, true);
@@ -440,6 +464,10 @@ unsigned LuaEngine::instructionMeasureInterval() const {
   return m_instructionMeasureInterval;
 }
 
+uint64_t LuaEngine::instructionCount() const {
+  return m_totalInstructionCount;
+}
+
 void LuaEngine::setRecursionLimit(unsigned recursionLimit) {
   m_recursionLimit = recursionLimit;
 }
@@ -507,6 +535,23 @@ LuaTable LuaEngine::createTable(int narr, int nrec) {
   return LuaTable(LuaDetail::LuaHandle(RefPtr<LuaEngine>(this), popHandle(m_state)));
 }
 
+LuaTable LuaEngine::createJsonContainer(Json const& container) {
+  if (!container.isType(Json::Type::Array) && !container.isType(Json::Type::Object))
+    throw LuaException("createJsonContainer called on improper json type");
+
+  pushJson(m_state, container);
+  return LuaTable(LuaDetail::LuaHandle(RefPtr<LuaEngine>(this), popHandle(m_state)));
+}
+
+Maybe<Json> LuaEngine::jsonContainerFromTable(LuaTable const& table) {
+  lua_checkstack(m_state, 1);
+
+  pushHandle(m_state, table.handleIndex());
+  auto json = tableToJson(m_state, -1);
+  lua_pop(m_state, 1);
+  return json;
+}
+
 LuaThread LuaEngine::createThread() {
   lua_checkstack(m_state, 1);
 
@@ -585,6 +630,10 @@ size_t LuaEngine::memoryUsage() const {
   return (size_t)lua_gc(m_state, LUA_GCCOUNT, 0) * 1024 + lua_gc(m_state, LUA_GCCOUNTB, 0);
 }
 
+uint64_t LuaEngine::allocatedBytes() const {
+  return m_allocatedBytes;
+}
+
 LuaNullEnforcer LuaEngine::nullTerminate() {
   return LuaNullEnforcer(*this);
 }
@@ -618,10 +667,13 @@ void LuaEngine::countHook(lua_State* state, lua_Debug* ar) {
   // the internal lua instruction counter at the start, we don't know how
   // many instructions have been executed, only that it is >= 1 and <=
   // m_instructionMeasureInterval, so we pick the low estimate.
-  if (self->m_instructionCount == 0)
+  if (self->m_instructionCount == 0) {
     self->m_instructionCount = 1;
-  else
+    self->m_totalInstructionCount += 1;
+  } else {
     self->m_instructionCount += self->m_instructionMeasureInterval;
+    self->m_totalInstructionCount += self->m_instructionMeasureInterval;
+  }
 
   if (self->m_instructionLimit != 0 && self->m_instructionCount > self->m_instructionLimit) {
     lua_pushlightuserdata(state, &s_luaInstructionLimitExceptionKey);
@@ -673,11 +725,15 @@ void LuaEngine::countHook(lua_State* state, lua_Debug* ar) {
   }
 }
 
-void* LuaEngine::allocate(void*, void* ptr, size_t oldSize, size_t newSize) {
+void* LuaEngine::allocate(void* userdata, void* ptr, size_t oldSize, size_t newSize) {
   if (newSize == 0) {
     Star::free(ptr, oldSize);
     return nullptr;
   } else {
+    // For new objects oldSize is the type of the object rather than a size
+    size_t previousSize = ptr ? oldSize : 0;
+    if (newSize > previousSize)
+      static_cast<LuaEngine*>(userdata)->m_allocatedBytes += newSize - previousSize;
     return Star::realloc(ptr, newSize);
   }
 }
@@ -1223,6 +1279,212 @@ void LuaEngine::pushLuaValue(lua_State* state, LuaValue const& luaValue) {
   luaValue.call(Pusher{this, state});
 }
 
+void LuaEngine::pushJson(lua_State* state, Json const& json) {
+  // A container, its __nils table, and a key and value being set
+  if (!lua_checkstack(state, 4))
+    throw LuaException("Exhausted the lua stack converting Json");
+
+  auto pushString = [&](String const& string) {
+    if (m_nullTerminated > 0)
+      lua_pushstring(state, string.utf8Ptr());
+    else
+      lua_pushlstring(state, string.utf8Ptr(), string.utf8Size());
+  };
+
+  switch (json.type()) {
+    case Json::Type::Null:
+      lua_pushnil(state);
+      return;
+    case Json::Type::Float:
+      lua_pushnumber(state, json.toDouble());
+      return;
+    case Json::Type::Bool:
+      lua_pushboolean(state, json.toBool());
+      return;
+    case Json::Type::Int:
+      lua_pushinteger(state, json.toInt());
+      return;
+    case Json::Type::String:
+      pushString(*json.stringPtr());
+      return;
+    default:
+      break;
+  }
+
+  bool isArray = json.isType(Json::Type::Array);
+  size_t nilCount = 0;
+  if (isArray) {
+    for (auto const& value : *json.arrayPtr())
+      nilCount += value.isNull();
+  } else {
+    for (auto const& pair : *json.objectPtr())
+      nilCount += pair.second.isNull();
+  }
+
+  size_t size = json.size();
+  lua_createtable(state, isArray ? size - nilCount : 0, isArray ? 0 : size - nilCount);
+
+  // The same metatable as LuaDetail::insertJsonMetatable creates
+  lua_createtable(state, 0, 3);
+  lua_createtable(state, isArray ? nilCount : 0, isArray ? 0 : nilCount);
+  lua_pushvalue(state, -1);
+  LuaDetail::rawSetField(state, -3, "__nils");
+  lua_rawgeti(state, LUA_REGISTRYINDEX, m_jsonNewIndexRegistryId);
+  LuaDetail::rawSetField(state, -3, "__newindex");
+  lua_pushinteger(state, isArray ? 1 : 2);
+  LuaDetail::rawSetField(state, -3, "__typehint");
+  lua_insert(state, -2);
+  lua_setmetatable(state, -3);
+
+  // The container table is now at -2 and its __nils table at -1
+  if (isArray) {
+    auto const& array = *json.arrayPtr();
+    for (size_t i = 0; i < array.size(); ++i) {
+      if (array[i]) {
+        pushJson(state, array[i]);
+        lua_rawseti(state, -3, i + 1);
+      } else {
+        lua_pushinteger(state, 0);
+        lua_rawseti(state, -2, i + 1);
+      }
+    }
+  } else {
+    for (auto const& pair : *json.objectPtr()) {
+      pushString(pair.first);
+      if (pair.second) {
+        pushJson(state, pair.second);
+        lua_rawset(state, -4);
+      } else {
+        lua_pushinteger(state, 0);
+        lua_rawset(state, -3);
+      }
+    }
+  }
+
+  lua_pop(state, 1);
+}
+
+Maybe<Json> LuaEngine::toJson(lua_State* state, int index) {
+  switch (lua_type(state, index)) {
+    case LUA_TNIL:
+      return Json();
+    case LUA_TBOOLEAN:
+      return Json((bool)lua_toboolean(state, index));
+    case LUA_TNUMBER:
+      if (lua_isinteger(state, index))
+        return Json(lua_tointeger(state, index));
+      else
+        return Json(lua_tonumber(state, index));
+    case LUA_TSTRING: {
+      if (m_nullTerminated > 0)
+        return Json(String(lua_tostring(state, index)));
+      size_t len = 0;
+      char const* data = lua_tolstring(state, index, &len);
+      return Json(String(data, len));
+    }
+    case LUA_TTABLE:
+      return tableToJson(state, index);
+    default:
+      return {};
+  }
+}
+
+Maybe<Json> LuaEngine::tableToJson(lua_State* state, int index) {
+  // The metatable, its __nils table, and a key and value being read
+  if (!lua_checkstack(state, 4))
+    throw LuaException("Exhausted the lua stack converting Json");
+  index = lua_absindex(state, index);
+
+  JsonObject stringEntries;
+  // Collected unsorted, with the nil entries first so that entries from the
+  // table itself take priority
+  List<pair<unsigned, Json>> intEntries;
+  int typeHint = 0;
+
+  // The same key conversion as LuaDetail::asInteger and LuaConverter<String>,
+  // but without converting the key in place, which would confuse lua_next
+  auto addEntry = [&](int keyIndex, Json value) {
+    if (lua_type(state, keyIndex) == LUA_TNUMBER) {
+      if (lua_isinteger(state, keyIndex)) {
+        intEntries.append({(unsigned)lua_tointeger(state, keyIndex), std::move(value)});
+      } else {
+        LuaFloat f = lua_tonumber(state, keyIndex);
+        if ((LuaFloat)(LuaInt)f == f)
+          intEntries.append({(unsigned)(LuaInt)f, std::move(value)});
+        else
+          stringEntries[String(toString(f))] = std::move(value);
+      }
+      return true;
+    } else if (lua_type(state, keyIndex) == LUA_TSTRING) {
+      if (m_nullTerminated > 0) {
+        stringEntries[String(lua_tostring(state, keyIndex))] = std::move(value);
+      } else {
+        size_t len = 0;
+        char const* data = lua_tolstring(state, keyIndex, &len);
+        stringEntries[String(data, len)] = std::move(value);
+      }
+      return true;
+    }
+    return false;
+  };
+
+  if (lua_getmetatable(state, index)) {
+    lua_getfield(state, -1, "__typehint");
+    typeHint = lua_tointeger(state, -1);
+    lua_pop(state, 1);
+
+    lua_getfield(state, -1, "__nils");
+    if (lua_istable(state, -1)) {
+      // Nil entries just have a garbage integer as their value
+      lua_pushnil(state);
+      while (lua_next(state, -2) != 0) {
+        lua_pop(state, 1);
+        if (!addEntry(-1, Json())) {
+          lua_pop(state, 3);
+          return {};
+        }
+      }
+    }
+    lua_pop(state, 2);
+  }
+
+  lua_pushnil(state);
+  while (lua_next(state, index) != 0) {
+    auto value = toJson(state, -1);
+    if (!value || !addEntry(-2, value.take())) {
+      lua_pop(state, 2);
+      return {};
+    }
+    lua_pop(state, 1);
+  }
+
+  // Stable, so that of any duplicate keys the last one added is kept
+  std::stable_sort(intEntries.begin(), intEntries.end(), [](auto const& a, auto const& b) {
+      return a.first < b.first;
+    });
+  size_t uniqueCount = 0;
+  for (size_t i = 0; i < intEntries.size(); ++i) {
+    if (uniqueCount != 0 && intEntries[uniqueCount - 1].first == intEntries[i].first)
+      intEntries[uniqueCount - 1].second = std::move(intEntries[i].second);
+    else if (uniqueCount++ != i)
+      intEntries[uniqueCount - 1] = std::move(intEntries[i]);
+  }
+  intEntries.resize(uniqueCount);
+
+  bool interpretAsList = stringEntries.empty()
+      && (typeHint == 1 || (typeHint != 2 && !intEntries.empty() && intEntries.last().first == intEntries.size()));
+  if (interpretAsList) {
+    JsonArray list;
+    for (auto& p : intEntries)
+      list.set(p.first - 1, std::move(p.second));
+    return Json(std::move(list));
+  } else {
+    for (auto& p : intEntries)
+      stringEntries[toString(p.first)] = std::move(p.second);
+    return Json(std::move(stringEntries));
+  }
+}
+
 LuaValue LuaEngine::popLuaValue(lua_State* state) {
   lua_checkstack(state, 1);
 
@@ -1373,101 +1635,11 @@ LuaTable LuaDetail::insertJsonMetatable(LuaEngine& engine, LuaTable const& table
 }
 
 LuaTable LuaDetail::jsonContainerToTable(LuaEngine& engine, Json const& container) {
-  if (!container.isType(Json::Type::Array) && !container.isType(Json::Type::Object))
-    throw LuaException("jsonContainerToTable called on improper json type");
-
-  auto table = engine.createTable();
-  auto nils = insertJsonMetatable(engine, table, container.type());
-
-  if (container.isType(Json::Type::Array)) {
-    auto vlist = container.arrayPtr();
-    for (size_t i = 0; i < vlist->size(); ++i) {
-      auto const& val = (*vlist)[i];
-      if (val)
-        table.rawSet(i + 1, val);
-      else
-        nils.rawSet(i + 1, 0);
-    }
-  } else {
-    for (auto const& pair : *container.objectPtr()) {
-      if (pair.second)
-        table.rawSet(pair.first, pair.second);
-      else
-        nils.rawSet(pair.first, 0);
-    }
-  }
-
-  return table;
+  return engine.createJsonContainer(container);
 }
 
 Maybe<Json> LuaDetail::tableToJsonContainer(LuaTable const& table) {
-  JsonObject stringEntries;
-  Map<unsigned, Json> intEntries;
-  int typeHint = 0;
-
-  if (auto mt = table.getMetatable()) {
-    if (auto th = mt->get<Maybe<int>>("__typehint"))
-      typeHint = *th;
-
-    if (auto nils = mt->get<Maybe<LuaTable>>("__nils")) {
-      bool failedConversion = false;
-      // Nil entries just have a garbage integer as their value
-      nils->iterate([&](LuaValue const& key, LuaValue const&) {
-        if (auto i = asInteger(key)) {
-          intEntries[*i] = Json();
-        } else {
-          if (auto str = table.engine().luaMaybeTo<String>(key)) {
-            stringEntries[str.take()] = Json();
-          } else {
-            failedConversion = true;
-            return false;
-          }
-        }
-        return true;
-      });
-      if (failedConversion)
-        return {};
-    }
-  }
-
-  bool failedConversion = false;
-  table.iterate([&](LuaValue key, LuaValue value) {
-      auto jsonValue = table.engine().luaMaybeTo<Json>(value);
-      if (!jsonValue) {
-        failedConversion = true;
-        return false;
-      }
-
-      if (auto i = asInteger(key)) {
-        intEntries[*i] = jsonValue.take();
-      } else {
-        auto stringKey = table.engine().luaMaybeTo<String>(std::move(key));
-        if (!stringKey) {
-          failedConversion = true;
-          return false;
-        }
-
-        stringEntries[stringKey.take()] = jsonValue.take();
-      }
-
-      return true;
-    });
-
-  if (failedConversion)
-    return {};
-
-  bool interpretAsList = stringEntries.empty()
-      && (typeHint == 1 || (typeHint != 2 && !intEntries.empty() && prev(intEntries.end())->first == intEntries.size()));
-  if (interpretAsList) {
-    JsonArray list;
-    for (auto& p : intEntries)
-      list.set(p.first - 1, std::move(p.second));
-    return Json(std::move(list));
-  } else {
-    for (auto& p : intEntries)
-      stringEntries[toString(p.first)] = std::move(p.second);
-    return Json(std::move(stringEntries));
-  }
+  return table.engine().jsonContainerFromTable(table);
 }
 
 Json LuaDetail::jarrayCreate() {
@@ -509,6 +509,11 @@ public:
   void setInstructionMeasureInterval(unsigned measureInterval = 1000);
   unsigned instructionMeasureInterval() const;
 
+  // Estimated total number of instructions the engine has executed, counted
+  // at the measure interval while an instruction limit is set or profiling is
+  // enabled.  Unlike the instruction limit count, this is never reset.
+  uint64_t instructionCount() const;
+
   // Sets the LuaEngine recursion limit, limiting the number of times a
   // LuaEngine call may directly or inderectly trigger a call back into the
   // LuaEngine, preventing a C++ stack overflow.  0 disables the limit.
@@ -558,6 +563,14 @@ public:
   template <typename Container>
   LuaTable createArrayTable(Container const& array);
 
+  // Creates a json container table from a JsonArray or JsonObject, as
+  // described in LuaDetail::jsonContainerToTable.  The whole tree is built
+  // directly on the lua stack with every table allocated at its final size.
+  LuaTable createJsonContainer(Json const& container);
+  // Converts a table back into Json, as described in
+  // LuaDetail::tableToJsonContainer.
+  Maybe<Json> jsonContainerFromTable(LuaTable const& table);
+
   // Creates a function and deduces the signature of the function using
   // FunctionTraits.  As a convenience, the given function may optionally take
   // a LuaEngine& parameter as the first parameter, and if it does, when called
@@ -608,6 +621,8 @@ public:
 
   // Bytes in use by lua
   size_t memoryUsage() const;
+  // Total bytes lua has ever allocated, including everything since collected
+  uint64_t allocatedBytes() const;
 
   // Enforce null-terminated string conversion as long as the returned enforcer object is in scope.
   LuaNullEnforcer nullTerminate();
@@ -701,6 +716,13 @@ private:
   void pushLuaValue(lua_State* state, LuaValue const& luaValue);
   LuaValue popLuaValue(lua_State* state);
 
+  // Json conversion that works on the stack, without creating a handle for
+  // every nested value.  toJson returns nothing if the value contains
+  // anything that has no Json equivalent.
+  void pushJson(lua_State* state, Json const& json);
+  Maybe<Json> toJson(lua_State* state, int index);
+  Maybe<Json> tableToJson(lua_State* state, int index);
+
   template <typename T>
   size_t pushArgument(lua_State* state, T const& arg);
 
@@ -729,6 +751,7 @@ private:
   int m_scriptDefaultEnvRegistryId;
   int m_wrappedFunctionMetatableRegistryId;
   int m_requireFunctionMetatableRegistryId;
+  int m_jsonNewIndexRegistryId;
   HashMap<std::type_index, int> m_registeredUserDataTypes;
 
   lua_State* m_handleThread;
@@ -740,6 +763,8 @@ private:
   bool m_profilingEnabled;
   unsigned m_instructionMeasureInterval;
   uint64_t m_instructionCount;
+  uint64_t m_totalInstructionCount;
+  uint64_t m_allocatedBytes;
   unsigned m_recursionLevel;
   unsigned m_recursionLimit;
   int m_nullTerminated;
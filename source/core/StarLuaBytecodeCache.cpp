@@ -0,0 +1,143 @@
+#include "StarLuaBytecodeCache.hpp"
+#include "StarDataStreamDevices.hpp"
+#include "StarFile.hpp"
+#include "StarLogging.hpp"
+#include "StarXXHash.hpp"
+
+namespace Star {
+
+ByteArray LuaBytecodeCache::engineSignature(LuaEngine& engine) {
+  return engine.compile(ByteArray(), "LuaBytecodeCache");
+}
+
+LuaBytecodeCache::LuaBytecodeCache(ByteArray assetsDigest, ByteArray engineSignature, Maybe<String> storageFile)
+  : m_assetsDigest(std::move(assetsDigest)),
+    m_engineSignature(std::move(engineSignature)),
+    m_storageFile(std::move(storageFile)),
+    m_dirty(false),
+    m_saving(false) {
+  load();
+}
+
+LuaBytecodeCache::~LuaBytecodeCache() {
+  finishSaving();
+}
+
+ByteArrayConstPtr LuaBytecodeCache::find(String const& assetPath, ByteArray const& source) const {
+  uint64_t sourceHash = xxHash3(source);
+  MutexLocker locker(m_mutex);
+  if (auto script = m_scripts.ptr(assetPath)) {
+    if (script->first == sourceHash)
+      return script->second;
+  }
+  return {};
+}
+
+ByteArrayConstPtr LuaBytecodeCache::compile(LuaEngine& engine, String const& assetPath, ByteArray const& source) {
+  if (auto bytecode = find(assetPath, source))
+    return bytecode;
+
+  auto bytecode = make_shared<ByteArray const>(engine.compile(source, assetPath));
+
+  MutexLocker locker(m_mutex);
+  m_scripts[assetPath] = {xxHash3(source), bytecode};
+  m_dirty = true;
+  return bytecode;
+}
+
+void LuaBytecodeCache::save() {
+  MutexLocker locker(m_mutex);
+  if (!m_dirty || !m_storageFile)
+    return;
+  // Copying the map only copies pointers to the compiled scripts, the
+  // serialization happens on the save thread.
+  ScriptMap scripts = m_scripts;
+  m_dirty = false;
+  locker.unlock();
+
+  MutexLocker saveLocker(m_saveMutex);
+  m_pendingSave = std::move(scripts);
+  if (m_saving)
+    return;
+
+  m_saving = true;
+  // The previous save thread, if any, has already given up the save mutex
+  // for good.
+  m_saveThread.finish();
+  m_saveThread = Thread::invoke("LuaBytecodeCache::save", [this]() { writeSaves(); });
+}
+
+void LuaBytecodeCache::finishSaving() {
+  MutexLocker saveLocker(m_saveMutex);
+  while (m_saving)
+    m_saveCondition.wait(m_saveMutex);
+  m_saveThread.finish();
+}
+
+void LuaBytecodeCache::load() {
+  if (!m_storageFile || !File::isFile(*m_storageFile))
+    return;
+
+  try {
+    // The contents are preceded by a hash of themselves, so that a damaged
+    // file is never parsed.
+    DataStreamBuffer ds(File::readFile(*m_storageFile));
+    uint64_t contentsHash = ds.read<uint64_t>();
+    if (xxHash3(ds.ptr() + ds.pos(), ds.size() - ds.pos()) != contentsHash) {
+      Logger::warn("Lua bytecode cache is corrupt, recompiling scripts");
+      return;
+    }
+
+    if (ds.read<ByteArray>() != m_assetsDigest || ds.read<ByteArray>() != m_engineSignature) {
+      Logger::info("Lua bytecode cache is out of date, recompiling scripts");
+      return;
+    }
+
+    size_t count = ds.readVlqU();
+    for (size_t i = 0; i < count; ++i) {
+      String assetPath = ds.read<String>();
+      uint64_t sourceHash = ds.read<uint64_t>();
+      m_scripts[assetPath] = {sourceHash, make_shared<ByteArray const>(ds.read<ByteArray>())};
+    }
+    Logger::info("Loaded {} compiled scripts from Lua bytecode cache", count);
+  } catch (IOException const& e) {
+    Logger::warn("Could not read Lua bytecode cache, recompiling scripts: {}", outputException(e, false));
+    m_scripts.clear();
+  }
+}
+
+void LuaBytecodeCache::writeSaves() {
+  while (true) {
+    MutexLocker saveLocker(m_saveMutex);
+    if (!m_pendingSave) {
+      m_saving = false;
+      m_saveCondition.broadcast();
+      return;
+    }
+    ScriptMap scripts = m_pendingSave.take();
+    saveLocker.unlock();
+
+    DataStreamBuffer contents;
+    contents.write(m_assetsDigest);
+    contents.write(m_engineSignature);
+    contents.writeVlqU(scripts.size());
+    for (auto const& pair : scripts) {
+      contents.write(pair.first);
+      contents.write(pair.second.first);
+      contents.write(*pair.second.second);
+    }
+
+    DataStreamBuffer ds;
+    ds.write<uint64_t>(xxHash3(contents.data()));
+    ds.writeData(contents.ptr(), contents.size());
+
+    try {
+      File::makeDirectoryRecursive(File::dirName(*m_storageFile));
+      File::overwriteFileWithRename(ds.data(), *m_storageFile);
+    } catch (IOException const& e) {
+      Logger::warn("Could not write Lua bytecode cache: {}", outputException(e, false));
+    }
+  }
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "StarLua.hpp"
+#include "StarThread.hpp"
+
+namespace Star {
+
+STAR_CLASS(LuaBytecodeCache);
+
+// Compiled scripts, optionally saved to a file so that they don't have to be
+// compiled again on the next run.  Each script is kept along with a hash of
+// the source it was compiled from, and is only used for exactly the same
+// source.  The file as a whole is only used for the same assets digest and
+// engine signature it was saved with.
+class LuaBytecodeCache {
+public:
+  // Bytecode is only valid for the Lua build that compiled it, which is
+  // identified by the bytecode of an empty script.
+  static ByteArray engineSignature(LuaEngine& engine);
+
+  // Loads the scripts previously saved to 'storageFile', if there are any.
+  // Without a storage file, scripts are only kept in memory.
+  LuaBytecodeCache(ByteArray assetsDigest, ByteArray engineSignature, Maybe<String> storageFile = {});
+  // Waits for any write started by save() to finish.
+  ~LuaBytecodeCache();
+
+  // Returns null unless the script has been compiled from the same source.
+  ByteArrayConstPtr find(String const& assetPath, ByteArray const& source) const;
+  ByteArrayConstPtr compile(LuaEngine& engine, String const& assetPath, ByteArray const& source);
+
+  // If any scripts have been compiled since the cache was last saved, writes
+  // it out on a background thread, without waiting for the write.  The file
+  // is replaced by renaming over it, so it is never left partly written.
+  void save();
+  // Waits for every write started by save() so far to finish.
+  void finishSaving();
+
+private:
+  typedef StringMap<pair<uint64_t, ByteArrayConstPtr>> ScriptMap;
+
+  void load();
+  void writeSaves();
+
+  ByteArray m_assetsDigest;
+  ByteArray m_engineSignature;
+  Maybe<String> m_storageFile;
+
+  mutable Mutex m_mutex;
+  ScriptMap m_scripts;
+  bool m_dirty;
+
+  // Only the most recent snapshot waiting to be written is kept, a write in
+  // progress picks it up once it is done.
+  Mutex m_saveMutex;
+  ConditionVariable m_saveCondition;
+  Maybe<ScriptMap> m_pendingSave;
+  bool m_saving;
+  ThreadFunction<void> m_saveThread;
+};
+
+}
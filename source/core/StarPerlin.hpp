@@ -5,6 +5,11 @@
 #include "StarInterpolation.hpp"
 #include "StarRandom.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_PERLIN_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Star {
 
 STAR_EXCEPTION(PerlinException, StarException);
@@ -40,6 +45,13 @@ public:
   Float get(Float x, Float y) const;
   Float get(Float x, Float y, Float z) const;
 
+  // Batch version of get for samples that all share the same y coordinate,
+  // writing the value for each of count samples to out.  Results are
+  // identical to calling get for every sample, the work is just done an
+  // octave at a time across the batch, and the y part of each lattice lookup
+  // is only calculated once per octave.
+  void getRow(Float const* x, Float y, Float* out, size_t count) const;
+
   PerlinType type() const;
 
   unsigned octaves() const;
@@ -52,8 +64,21 @@ public:
   Json toJson() const;
 
 private:
+  // Samples are evaluated in batches of this size by getRow
+  static size_t const BatchSize = 64;
+
+  // The lattice cell and s-curve weight along one axis
+  struct Axis {
+    int b0;
+    int b1;
+    Float r0;
+    Float r1;
+    Float s;
+  };
+
   static Float s_curve(Float t);
   static void setup(Float v, int& b0, int& b1, Float& r0, Float& r1);
+  static Axis axis(Float v);
 
   static Float at2(Float* q, Float rx, Float ry);
   static Float at3(Float* q, Float rx, Float ry, Float rz);
@@ -62,6 +87,11 @@ private:
   Float noise2(Float vec[2]) const;
   Float noise3(Float vec[3]) const;
 
+  Float noise2(Axis const& x, Axis const& y) const;
+  Float noise3(Axis const& x, Axis const& y, Axis const& z) const;
+  // Writes noise2(axis(x[i]), y) to values[i] for each of count samples.
+  void noise2Row(Float const* x, Axis const& y, Float* values, size_t count) const;
+
   void normalize2(Float v[2]) const;
   void normalize3(Float v[3]) const;
 
@@ -79,6 +109,13 @@ private:
   Float billow(Float x, Float y) const;
   Float billow(Float x, Float y, Float z) const;
 
+  // Calls octaveNoise(Float* values) once per octave to fill values with the
+  // noise for each sample at that octave, and combines them in the same way as
+  // get does for the perlin type.  octaveNoise is responsible for scaling its
+  // sample coordinates by beta after each octave.
+  template <typename OctaveNoise>
+  void evaluate(Float* out, size_t count, OctaveNoise&& octaveNoise) const;
+
   PerlinType m_type;
   uint64_t m_seed;
 
@@ -118,6 +155,14 @@ void Perlin<Float>::setup(Float v, int& b0, int& b1, Float& r0, Float& r1) {
   r1 = fv - 1.0;
 }
 
+template <typename Float>
+auto Perlin<Float>::axis(Float v) -> Axis {
+  Axis axis;
+  setup(v, axis.b0, axis.b1, axis.r0, axis.r1);
+  axis.s = s_curve(axis.r0);
+  return axis;
+}
+
 template <typename Float>
 Float Perlin<Float>::at2(Float* q, Float rx, Float ry) {
   return rx * q[0] + ry * q[1];
@@ -310,6 +355,24 @@ Float Perlin<Float>::get(Float x, Float y, Float z) const {
   }
 }
 
+template <typename Float>
+void Perlin<Float>::getRow(Float const* x, Float y, Float* out, size_t count) const {
+  for (size_t start = 0; start < count; start += BatchSize) {
+    size_t batchCount = min(BatchSize, count - start);
+    Float px[BatchSize];
+    for (size_t i = 0; i < batchCount; ++i)
+      px[i] = x[start + i] * m_frequency;
+    Float py = y * m_frequency;
+
+    evaluate(out + start, batchCount, [&](Float* values) {
+        noise2Row(px, axis(py), values, batchCount);
+        for (size_t i = 0; i < batchCount; ++i)
+          px[i] *= m_beta;
+        py *= m_beta;
+      });
+  }
+}
+
 template <typename Float>
 PerlinType Perlin<Float>::type() const {
   return m_type;
@@ -377,79 +440,157 @@ inline Float Perlin<Float>::noise1(Float arg) const {
 
 template <typename Float>
 inline Float Perlin<Float>::noise2(Float vec[2]) const {
-  int bx0, bx1, by0, by1, b00, b10, b01, b11;
-  Float rx0, rx1, ry0, ry1, sx, sy, a, b, u, v;
-  int i, j;
-
-  setup(vec[0], bx0, bx1, rx0, rx1);
-  setup(vec[1], by0, by1, ry0, ry1);
-
-  i = p[bx0];
-  j = p[bx1];
-
-  b00 = p[i + by0];
-  b10 = p[j + by0];
-  b01 = p[i + by1];
-  b11 = p[j + by1];
-
-  sx = s_curve(rx0);
-  sy = s_curve(ry0);
-
-  u = at2(g2[b00], rx0, ry0);
-  v = at2(g2[b10], rx1, ry0);
-  a = lerp(sx, u, v);
-
-  u = at2(g2[b01], rx0, ry1);
-  v = at2(g2[b11], rx1, ry1);
-  b = lerp(sx, u, v);
-
-  return lerp(sy, a, b);
+  return noise2(axis(vec[0]), axis(vec[1]));
 }
 
 template <typename Float>
 inline Float Perlin<Float>::noise3(Float vec[3]) const {
-  int bx0, bx1, by0, by1, bz0, bz1, b00, b10, b01, b11;
-  Float rx0, rx1, ry0, ry1, rz0, rz1, sx, sy, sz, a, b, c, d, u, v;
-  int i, j;
-
-  setup(vec[0], bx0, bx1, rx0, rx1);
-  setup(vec[1], by0, by1, ry0, ry1);
-  setup(vec[2], bz0, bz1, rz0, rz1);
-
-  i = p[bx0];
-  j = p[bx1];
+  return noise3(axis(vec[0]), axis(vec[1]), axis(vec[2]));
+}
 
-  b00 = p[i + by0];
-  b10 = p[j + by0];
-  b01 = p[i + by1];
-  b11 = p[j + by1];
+template <typename Float>
+inline Float Perlin<Float>::noise2(Axis const& x, Axis const& y) const {
+  int b00, b10, b01, b11;
+  Float a, b, u, v;
+  int i, j;
 
-  sx = s_curve(rx0);
-  sy = s_curve(ry0);
-  sz = s_curve(rz0);
+  i = p[x.b0];
+  j = p[x.b1];
 
-  u = at3(g3[b00 + bz0], rx0, ry0, rz0);
-  v = at3(g3[b10 + bz0], rx1, ry0, rz0);
-  a = lerp(sx, u, v);
+  b00 = p[i + y.b0];
+  b10 = p[j + y.b0];
+  b01 = p[i + y.b1];
+  b11 = p[j + y.b1];
 
-  u = at3(g3[b01 + bz0], rx0, ry1, rz0);
-  v = at3(g3[b11 + bz0], rx1, ry1, rz0);
-  b = lerp(sx, u, v);
+  u = at2(g2[b00], x.r0, y.r0);
+  v = at2(g2[b10], x.r1, y.r0);
+  a = lerp(x.s, u, v);
 
-  c = lerp(sy, a, b);
+  u = at2(g2[b01], x.r0, y.r1);
+  v = at2(g2[b11], x.r1, y.r1);
+  b = lerp(x.s, u, v);
 
-  u = at3(g3[b00 + bz1], rx0, ry0, rz1);
-  v = at3(g3[b10 + bz1], rx1, ry0, rz1);
-  a = lerp(sx, u, v);
+  return lerp(y.s, a, b);
+}
 
-  u = at3(g3[b01 + bz1], rx0, ry1, rz1);
-  v = at3(g3[b11 + bz1], rx1, ry1, rz1);
-  b = lerp(sx, u, v);
+template <typename Float>
+inline Float Perlin<Float>::noise3(Axis const& x, Axis const& y, Axis const& z) const {
+  int b00, b10, b01, b11;
+  Float a, b, c, d, u, v;
+  int i, j;
 
-  d = lerp(sy, a, b);
+  i = p[x.b0];
+  j = p[x.b1];
+
+  b00 = p[i + y.b0];
+  b10 = p[j + y.b0];
+  b01 = p[i + y.b1];
+  b11 = p[j + y.b1];
+
+  u = at3(g3[b00 + z.b0], x.r0, y.r0, z.r0);
+  v = at3(g3[b10 + z.b0], x.r1, y.r0, z.r0);
+  a = lerp(x.s, u, v);
+
+  u = at3(g3[b01 + z.b0], x.r0, y.r1, z.r0);
+  v = at3(g3[b11 + z.b0], x.r1, y.r1, z.r0);
+  b = lerp(x.s, u, v);
+
+  c = lerp(y.s, a, b);
+
+  u = at3(g3[b00 + z.b1], x.r0, y.r0, z.r1);
+  v = at3(g3[b10 + z.b1], x.r1, y.r0, z.r1);
+  a = lerp(x.s, u, v);
+
+  u = at3(g3[b01 + z.b1], x.r0, y.r1, z.r1);
+  v = at3(g3[b11 + z.b1], x.r1, y.r1, z.r1);
+  b = lerp(x.s, u, v);
+
+  d = lerp(y.s, a, b);
+
+  return lerp(z.s, c, d);
+}
+
+template <typename Float>
+inline void Perlin<Float>::noise2Row(Float const* x, Axis const& y, Float* values, size_t count) const {
+  for (size_t i = 0; i < count; ++i)
+    values[i] = noise2(axis(x[i]), y);
+}
+
+#ifdef STAR_PERLIN_SSE2
+// Four samples at a time, with every operation of axis and noise2 done in the
+// same order and at the same precision as the scalar code, including the
+// round trip through double in s_curve, so that results are bit identical.
+template <>
+inline void Perlin<float>::noise2Row(float const* x, Axis const& y, float* values, size_t count) const {
+  __m128 const signMask = _mm_set1_ps(-0.0f);
+  __m128 const intLimit = _mm_set1_ps(1 << 30);
+  __m128 const one = _mm_set1_ps(1.0f);
+  __m128d const twoD = _mm_set1_pd(2.0);
+  __m128d const threeD = _mm_set1_pd(3.0);
+  __m128i const sampleMask = _mm_set1_epi32(PerlinSampleSize - 1);
+  __m128i const oneI = _mm_set1_epi32(1);
+  __m128 const yr0 = _mm_set1_ps(y.r0);
+  __m128 const yr1 = _mm_set1_ps(y.r1);
+  __m128 const ys = _mm_set1_ps(y.s);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 v = _mm_loadu_ps(x + i);
+    // Leave values that floor cannot convert to int (and NaN) to the scalar
+    // code.
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_andnot_ps(signMask, v), intLimit)) != 0xf) {
+      for (size_t j = i; j < i + 4; ++j)
+        values[j] = noise2(axis(x[j]), y);
+      continue;
+    }
+
+    // setup
+    __m128i iv = _mm_cvttps_epi32(v);
+    iv = _mm_add_epi32(iv, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(iv), v)));
+    __m128 r0 = _mm_sub_ps(v, _mm_cvtepi32_ps(iv));
+    __m128 r1 = _mm_sub_ps(r0, one);
+
+    // s_curve
+    __m128 rr = _mm_mul_ps(r0, r0);
+    __m128d sLow = _mm_mul_pd(_mm_cvtps_pd(rr), _mm_sub_pd(threeD, _mm_mul_pd(twoD, _mm_cvtps_pd(r0))));
+    __m128d sHigh = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(rr, rr)),
+        _mm_sub_pd(threeD, _mm_mul_pd(twoD, _mm_cvtps_pd(_mm_movehl_ps(r0, r0)))));
+    __m128 s = _mm_movelh_ps(_mm_cvtpd_ps(sLow), _mm_cvtpd_ps(sHigh));
+
+    alignas(16) int b0[4];
+    alignas(16) int b1[4];
+    _mm_store_si128((__m128i*)b0, _mm_and_si128(iv, sampleMask));
+    _mm_store_si128((__m128i*)b1, _mm_and_si128(_mm_add_epi32(iv, oneI), sampleMask));
+
+    // Gradients for the b00, b10, b01 and b11 corners
+    alignas(16) float gx[4][4];
+    alignas(16) float gy[4][4];
+    for (size_t k = 0; k < 4; ++k) {
+      int pi = p[b0[k]];
+      int pj = p[b1[k]];
+      int corners[4] = {p[pi + y.b0], p[pj + y.b0], p[pi + y.b1], p[pj + y.b1]};
+      for (size_t c = 0; c < 4; ++c) {
+        gx[c][k] = g2[corners[c]][0];
+        gy[c][k] = g2[corners[c]][1];
+      }
+    }
+
+    auto at2 = [&](size_t c, __m128 rx, __m128 ry) {
+      return _mm_add_ps(_mm_mul_ps(rx, _mm_load_ps(gx[c])), _mm_mul_ps(ry, _mm_load_ps(gy[c])));
+    };
+    auto lerp = [one](__m128 offset, __m128 f0, __m128 f1) {
+      return _mm_add_ps(_mm_mul_ps(f0, _mm_sub_ps(one, offset)), _mm_mul_ps(f1, offset));
+    };
+
+    __m128 a = lerp(s, at2(0, r0, yr0), at2(1, r1, yr0));
+    __m128 b = lerp(s, at2(2, r0, yr1), at2(3, r1, yr1));
+    _mm_storeu_ps(values + i, lerp(ys, a, b));
+  }
 
-  return lerp(sz, c, d);
+  for (; i < count; ++i)
+    values[i] = noise2(axis(x[i]), y);
 }
+#endif
 
 template <typename Float>
 void Perlin<Float>::normalize2(Float v[2]) const {
@@ -712,4 +853,54 @@ inline Float Perlin<Float>::billow(Float x, Float y, Float z) const {
   return (sum + 0.5) * m_amplitude + m_bias;
 }
 
+template <typename Float>
+template <typename OctaveNoise>
+void Perlin<Float>::evaluate(Float* out, size_t count, OctaveNoise&& octaveNoise) const {
+  if (m_type != PerlinType::Perlin && m_type != PerlinType::Billow && m_type != PerlinType::RidgedMulti)
+    throw PerlinException("::get called on uninitialized Perlin");
+
+  Float values[BatchSize];
+  Float weights[BatchSize];
+  Float scale = 1;
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = 0;
+    weights[i] = 1.0;
+  }
+
+  for (int octave = 0; octave < m_octaves; ++octave) {
+    octaveNoise(values);
+
+    if (m_type == PerlinType::Perlin) {
+      for (size_t i = 0; i < count; ++i)
+        out[i] += values[i] / scale;
+    } else if (m_type == PerlinType::Billow) {
+      for (size_t i = 0; i < count; ++i) {
+        Float val = 2.0 * fabs(values[i]) - 1.0;
+        out[i] += val / scale;
+      }
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        Float val = m_offset - fabs(values[i]);
+        val *= val;
+        val *= weights[i];
+
+        weights[i] = clamp<Float>(val * m_gain, 0.0, 1.0);
+
+        out[i] += val / scale;
+      }
+    }
+
+    scale *= m_alpha;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (m_type == PerlinType::Perlin)
+      out[i] = out[i] * m_amplitude + m_bias;
+    else if (m_type == PerlinType::Billow)
+      out[i] = (out[i] + 0.5) * m_amplitude + m_bias;
+    else
+      out[i] = ((out[i] * 1.25) - 1.0) * m_amplitude + m_bias;
+  }
+}
+
 }
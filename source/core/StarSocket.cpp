@@ -1,6 +1,11 @@
 #include "StarSocket.hpp"
 #include "StarLogging.hpp"
 #include "StarNetImpl.hpp"
+#include "StarTime.hpp"
+
+#ifdef STAR_SYSTEM_LINUX
+#include <sys/epoll.h>
+#endif
 
 namespace Star {
 
@@ -269,4 +274,150 @@ void Socket::doClose() {
   }
 }
 
+SocketPoller::SocketPoller() {
+#ifdef STAR_SYSTEM_LINUX
+  m_epollDesc = ::epoll_create1(EPOLL_CLOEXEC);
+  if (m_epollDesc < 0)
+    throw NetworkException::format("Cannot create epoll instance: {}", netErrorString());
+#endif
+}
+
+SocketPoller::~SocketPoller() {
+#ifdef STAR_SYSTEM_LINUX
+  ::close(m_epollDesc);
+#endif
+}
+
+void SocketPoller::set(SocketPtr socket, SocketPollQueryEntry query) {
+  auto existing = m_query.ptr(socket);
+  if (existing && existing->readable == query.readable && existing->writable == query.writable)
+    return;
+
+#ifdef STAR_SYSTEM_LINUX
+  ReadLocker locker(socket->m_mutex);
+  // Once a socket is closed its descriptor has already left the epoll set, and
+  // may even have been reused, so it must not be touched.  wait reports closed
+  // sockets without asking epoll.
+  if (socket->isOpen()) {
+    epoll_event event = {};
+    event.data.ptr = socket.get();
+    if (query.readable)
+      event.events |= EPOLLIN;
+    if (query.writable)
+      event.events |= EPOLLOUT;
+    if (::epoll_ctl(m_epollDesc, existing ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, socket->m_impl->socketDesc, &event) != 0)
+      throw NetworkException::format("Cannot add socket to epoll set: {}", netErrorString());
+  }
+  locker.unlock();
+  m_sockets[socket.get()] = socket;
+#endif
+
+  m_query[std::move(socket)] = query;
+}
+
+void SocketPoller::remove(SocketPtr const& socket) {
+  if (!m_query.contains(socket))
+    return;
+
+#ifdef STAR_SYSTEM_LINUX
+  ReadLocker locker(socket->m_mutex);
+  if (socket->isOpen())
+    ::epoll_ctl(m_epollDesc, EPOLL_CTL_DEL, socket->m_impl->socketDesc, nullptr);
+  locker.unlock();
+  m_sockets.remove(socket.get());
+#endif
+
+  m_query.remove(socket);
+}
+
+bool SocketPoller::contains(SocketPtr const& socket) const {
+  return m_query.contains(socket);
+}
+
+size_t SocketPoller::size() const {
+  return m_query.size();
+}
+
+bool SocketPoller::empty() const {
+  return m_query.empty();
+}
+
+Maybe<SocketPollResult> SocketPoller::wait(unsigned timeout) {
+#ifdef STAR_SYSTEM_LINUX
+  if (m_query.empty())
+    return {};
+
+  // Same as Socket::poll, closed sockets are an event.
+  SocketPollResult result;
+  for (auto const& p : m_query) {
+    if (!p.first->isOpen()) {
+      result[p.first].exception = true;
+      timeout = 0;
+    }
+  }
+
+  // Any more ready sockets are returned by the next wait.
+  static int const MaxEvents = 256;
+  epoll_event events[MaxEvents];
+  int ret = ::epoll_wait(m_epollDesc, events, MaxEvents, timeout);
+  if (ret < 0)
+    throw NetworkException::format("Error during call to epoll_wait, '{}'", netErrorString());
+
+  for (int i = 0; i < ret; ++i) {
+    auto const& socket = m_sockets.get((Socket*)events[i].data.ptr);
+    ReadLocker locker(socket->m_mutex);
+    auto& r = result[socket];
+    if (socket->isOpen()) {
+      r.readable = events[i].events & EPOLLIN;
+      r.writable = events[i].events & EPOLLOUT;
+      r.exception = events[i].events & (EPOLLHUP | EPOLLERR);
+      if (events[i].events & EPOLLHUP)
+        socket->doShutdown();
+    } else {
+      r.exception = true;
+    }
+  }
+
+  if (result.empty())
+    return {};
+  return result;
+
+#elif defined STAR_SYSTEM_FAMILY_WINDOWS
+  // select silently ignores every socket past FD_SETSIZE, so with more sockets
+  // than that, check each group of them without waiting until the timeout is
+  // up.
+  if (m_query.size() <= (size_t)FD_SETSIZE)
+    return Socket::poll(m_query, timeout);
+
+  auto timer = Timer::withMilliseconds(timeout);
+  while (true) {
+    SocketPollResult result;
+    SocketPollQuery chunk;
+    auto pollChunk = [&]() {
+      if (auto chunkResult = Socket::poll(chunk, 0)) {
+        for (auto& p : *chunkResult)
+          result.add(p.first, p.second);
+      }
+      chunk.clear();
+    };
+
+    for (auto const& p : m_query) {
+      chunk.add(p.first, p.second);
+      if (chunk.size() == (size_t)FD_SETSIZE)
+        pollChunk();
+    }
+    pollChunk();
+
+    if (!result.empty())
+      return result;
+    if (timer.timeUp())
+      return {};
+    Thread::sleep(1);
+  }
+
+#else
+  return Socket::poll(m_query, timeout);
+#endif
+}
+
 }
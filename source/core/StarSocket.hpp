@@ -11,6 +11,7 @@ STAR_EXCEPTION(SocketClosedException, NetworkException);
 
 STAR_STRUCT(SocketImpl);
 STAR_CLASS(Socket);
+STAR_CLASS(SocketPoller);
 
 enum class SocketMode {
   Closed,
@@ -73,6 +74,8 @@ public:
   void close();
 
 protected:
+  friend class SocketPoller;
+
   enum class SocketType {
     Tcp,
     Udp
@@ -92,4 +95,37 @@ protected:
   HostAddressWithPort m_localAddress;
 };
 
+// Waits on the same set of sockets again and again, without building the set
+// anew for every wait.  On Linux sockets are registered with epoll once, so a
+// wait costs nothing for each idle socket, elsewhere the query is kept and
+// passed to Socket::poll.  Not thread safe, but the added sockets may be
+// closed from any thread.
+class SocketPoller {
+public:
+  SocketPoller();
+  ~SocketPoller();
+
+  SocketPoller(SocketPoller const&) = delete;
+  SocketPoller& operator=(SocketPoller const&) = delete;
+
+  // Adds the socket, or changes what it is waited on for if it was already
+  // added.
+  void set(SocketPtr socket, SocketPollQueryEntry query);
+  void remove(SocketPtr const& socket);
+  bool contains(SocketPtr const& socket) const;
+
+  size_t size() const;
+  bool empty() const;
+
+  // Same as Socket::poll on every added socket.
+  Maybe<SocketPollResult> wait(unsigned timeout);
+
+private:
+  SocketPollQuery m_query;
+#ifdef STAR_SYSTEM_LINUX
+  int m_epollDesc;
+  HashMap<Socket*, SocketPtr> m_sockets;
+#endif
+};
+
 }
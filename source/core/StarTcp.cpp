@@ -120,6 +120,60 @@ size_t TcpSocket::send(char const* data, size_t size) {
   return w;
 }
 
+size_t TcpSocket::send(List<pair<char const*, size_t>> const& buffers) {
+  ReadLocker locker(m_mutex);
+  checkOpen("TcpSocket::send");
+
+  if (m_socketMode == SocketMode::Closed)
+    throw SocketClosedException("TcpSocket not open in TcpSocket::send");
+
+  size_t count = min(buffers.size(), MaxSendBuffers);
+
+#ifdef STAR_SYSTEM_FAMILY_WINDOWS
+  WSABUF wsaBuffers[MaxSendBuffers];
+  for (size_t i = 0; i < count; ++i) {
+    wsaBuffers[i].len = (ULONG)buffers[i].second;
+    wsaBuffers[i].buf = (CHAR*)buffers[i].first;
+  }
+
+  DWORD sent = 0;
+  int64_t w = ::WSASend(m_impl->socketDesc, wsaBuffers, (DWORD)count, &sent, 0, nullptr, nullptr) == 0 ? (int64_t)sent : -1;
+#else
+  iovec ioBuffers[MaxSendBuffers];
+  for (size_t i = 0; i < count; ++i) {
+    ioBuffers[i].iov_base = (void*)buffers[i].first;
+    ioBuffers[i].iov_len = buffers[i].second;
+  }
+
+  msghdr message = {};
+  message.msg_iov = ioBuffers;
+  message.msg_iovlen = count;
+
+  int flags = 0;
+#ifdef STAR_SYSTEM_LINUX
+  // Don't generate sigpipe
+  flags |= MSG_NOSIGNAL;
+#endif
+
+  auto w = ::sendmsg(m_impl->socketDesc, &message, flags);
+#endif
+
+  if (w < 0) {
+    if (m_socketMode == SocketMode::Shutdown) {
+      throw SocketClosedException("Connection closed");
+    } else if (netErrorConnectionReset()) {
+      doShutdown();
+      throw SocketClosedException("Connection reset");
+    } else if (netErrorInterrupt()) {
+      w = 0;
+    } else {
+      throw NetworkException(strf("tcp send error: {}", netErrorString()));
+    }
+  }
+
+  return w;
+}
+
 HostAddressWithPort TcpSocket::localAddress() const {
   ReadLocker locker(m_mutex);
   return m_localAddress;
@@ -22,6 +22,12 @@ public:
   size_t receive(char* data, size_t len);
   size_t send(char const* data, size_t len);
 
+  // Sends the given buffers in order with a single gather write, up to
+  // MaxSendBuffers of them at a time.  Returns the total number of bytes sent,
+  // which may end part way through any buffer.
+  static size_t const MaxSendBuffers = 64;
+  size_t send(List<pair<char const*, size_t>> const& buffers);
+
   HostAddressWithPort localAddress() const;
   HostAddressWithPort remoteAddress() const;
 
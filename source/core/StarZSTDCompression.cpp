@@ -1,5 +1,6 @@
 #include "StarZSTDCompression.hpp"
 #include <zstd.h>
+#include <zdict.h>
 
 namespace Star {
 
@@ -11,6 +12,12 @@ CompressionStream::CompressionStream() : m_cStream(ZSTD_createCStream()) {
 
 CompressionStream::~CompressionStream() { ZSTD_freeCStream(m_cStream); }
 
+void CompressionStream::setDictionary(ByteArray const& dictionary) {
+  size_t ret = ZSTD_CCtx_loadDictionary(m_cStream, dictionary.ptr(), dictionary.size());
+  if (ZSTD_isError(ret))
+    throw IOException(strf("ZSTD dictionary error {}", ZSTD_getErrorName(ret)));
+}
+
 void CompressionStream::compress(const char* in, size_t inLen, ByteArray& out) {
   size_t const cOutSize = ZSTD_CStreamOutSize();
   ZSTD_inBuffer inBuffer = {in, inLen, 0};
@@ -54,14 +61,48 @@ ByteArray CompressionStream::compress(ByteArray const& in) {
   return out;
 }
 
-DecompressionStream::DecompressionStream() : m_dStream(ZSTD_createDStream()) {
+DecompressionStream::DecompressionStream() : m_dStream(ZSTD_createDStream()), m_frameStarted(false) {
   ZSTD_DCtx_setParameter(m_dStream, ZSTD_d_windowLogMax, 25);
   ZSTD_initDStream(m_dStream);
 }
 
 DecompressionStream::~DecompressionStream() { ZSTD_freeDStream(m_dStream); }
 
+void DecompressionStream::addDictionary(ByteArray const& dictionary) {
+  if (m_frameStarted)
+    throw IOException("Cannot add ZSTD dictionary after the stream has started");
+  unsigned id = ZstdCompression::dictionaryId(dictionary);
+  if (id == 0)
+    throw IOException("ZSTD dictionary error, not a trained dictionary");
+  m_dictionaries[id] = dictionary;
+}
+
 void DecompressionStream::decompress(const char* in, size_t inLen, ByteArray& out) {
+  if (!m_frameStarted && !m_dictionaries.empty()) {
+    // The frame header descriptor follows the 4 byte magic number, and its
+    // lowest 2 bits give the size of the dictionary id field.  Hold on to the
+    // start of the stream until it's known which dictionary it needs.
+    m_frameHeader.append(in, inLen);
+    if (m_frameHeader.size() < 5)
+      return;
+    if (m_frameHeader[4] & 3) {
+      unsigned id = ZSTD_getDictID_fromFrame(m_frameHeader.ptr(), m_frameHeader.size());
+      if (id == 0)
+        return;
+      auto dictionary = m_dictionaries.ptr(id);
+      if (!dictionary)
+        throw IOException(strf("ZSTD decompression error, unknown dictionary {}", id));
+      size_t ret = ZSTD_DCtx_loadDictionary(m_dStream, dictionary->ptr(), dictionary->size());
+      if (ZSTD_isError(ret))
+        throw IOException(strf("ZSTD dictionary error {}", ZSTD_getErrorName(ret)));
+    }
+    m_frameStarted = true;
+    m_dictionaries.clear();
+    ByteArray frameHeader = take(m_frameHeader);
+    return decompress(frameHeader.ptr(), frameHeader.size(), out);
+  }
+  m_frameStarted = true;
+
   size_t const dOutSize = ZSTD_DStreamOutSize();
   ZSTD_inBuffer inBuffer = {in, inLen, 0};
   size_t written = out.size();
@@ -161,4 +202,25 @@ void ZstdCompression::decompress(ByteArray const& in, ByteArray& out) {
   out = decompress(in);
 }
 
+ByteArray ZstdCompression::trainDictionary(List<ByteArray> const& samples, size_t maxSize) {
+  ByteArray sampleBuffer;
+  List<size_t> sampleSizes;
+  for (auto const& sample : samples) {
+    sampleBuffer.append(sample);
+    sampleSizes.append(sample.size());
+  }
+
+  ByteArray dictionary(maxSize, 0);
+  size_t size = ZDICT_trainFromBuffer(dictionary.ptr(), maxSize, sampleBuffer.ptr(), sampleSizes.ptr(), sampleSizes.size());
+  if (ZDICT_isError(size))
+    throw IOException(strf("ZSTD dictionary training error {}", ZDICT_getErrorName(size)));
+
+  dictionary.resize(size);
+  return dictionary;
+}
+
+unsigned ZstdCompression::dictionaryId(ByteArray const& dictionary) {
+  return ZSTD_getDictID_fromDict(dictionary.ptr(), dictionary.size());
+}
+
 }
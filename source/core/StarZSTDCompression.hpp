@@ -1,6 +1,7 @@
 #pragma once
 #include "StarByteArray.hpp"
 #include "StarDataStreamDevices.hpp"
+#include "StarMap.hpp"
 
 typedef struct ZSTD_CCtx_s ZSTD_CCtx;
 typedef struct ZSTD_DCtx_s ZSTD_DCtx;
@@ -14,6 +15,11 @@ public:
   CompressionStream();
   ~CompressionStream();
 
+  // Compresses the stream with a trained dictionary, which must be done
+  // before anything is compressed.  The dictionary id is written into the
+  // frame header so that the other end can pick the same one.
+  void setDictionary(ByteArray const& dictionary);
+
   void compress(const char* in, size_t inLen, ByteArray& out);
   void compress(ByteArray const& in, ByteArray& out);
   ByteArray compress(const char* in, size_t inLen);
@@ -28,6 +34,10 @@ public:
   DecompressionStream();
   ~DecompressionStream();
 
+  // Adds a dictionary the stream may have been compressed with.  The one to
+  // use is picked from the frame header at the start of the stream.
+  void addDictionary(ByteArray const& dictionary);
+
   void decompress(const char* in, size_t inLen, ByteArray& out);
   void decompress(ByteArray const& in, ByteArray& out);
   ByteArray decompress(const char* in, size_t inLen);
@@ -35,6 +45,9 @@ public:
 
 private:
   ZSTD_DStream* m_dStream;
+  HashMap<unsigned, ByteArray> m_dictionaries;
+  bool m_frameStarted;
+  ByteArray m_frameHeader;
 };
 
 class ZstdCompression {
@@ -48,6 +61,12 @@ public:
   static void decompress(ByteArray const& in, ByteArray& out);
   static ByteArray decompress(const char* in, size_t inLen);
   static ByteArray decompress(ByteArray const& in);
+
+  // Trains a dictionary of at most maxSize bytes on samples of the data that
+  // is going to be compressed.
+  static ByteArray trainDictionary(List<ByteArray> const& samples, size_t maxSize);
+  // Returns the id of a trained dictionary, or 0 if it is not one.
+  static unsigned dictionaryId(ByteArray const& dictionary);
 };
 
 }
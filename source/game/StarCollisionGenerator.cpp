@@ -2,25 +2,7 @@
 
 namespace Star {
 
-void CollisionGenerator::init(CollisionKindAccessor accessor) {
-  m_accessor = accessor;
-}
-
-List<CollisionBlock> CollisionGenerator::getBlocks(RectI const& region) const {
-  if (region.isNull())
-    return {};
-
-  List<CollisionBlock> list;
-
-  populateCollisionBuffer(region);
-
-  getBlocksMarchingSquares(list, region, CollisionKind::Dynamic);
-  getBlocksPlatforms(list, region, CollisionKind::Platform);
-
-  return list;
-}
-
-void CollisionGenerator::getBlocksPlatforms(List<CollisionBlock>& list, RectI const& region, CollisionKind kind) const {
+void CollisionGenerator::getBlocksPlatforms(RectI const& region, CollisionKind kind) {
   int xMin = region.xMin();
   int xMax = region.xMax();
   int yMin = region.yMin();
@@ -35,7 +17,7 @@ void CollisionGenerator::getBlocksPlatforms(List<CollisionBlock>& list, RectI co
           block.kind = kind;
           block.poly = PolyF(std::move(vertices));
           block.polyBounds = block.poly.boundBox();
-          list.append(std::move(block));
+          m_blocks.append(std::move(block));
         };
 
         // This was once simple and elegant and made sense but then I made it
@@ -93,7 +75,7 @@ void CollisionGenerator::getBlocksPlatforms(List<CollisionBlock>& list, RectI co
   }
 }
 
-void CollisionGenerator::getBlocksMarchingSquares(List<CollisionBlock>& list, RectI const& region, CollisionKind kind) const {
+void CollisionGenerator::getBlocksMarchingSquares(RectI const& region, CollisionKind kind) {
 
   // uses binary masking to assign each group of 4 tiles a value between 0 and 15
   // with corners ul = 1, ur = 2, lr = 4, ll = 8
@@ -151,7 +133,7 @@ void CollisionGenerator::getBlocksMarchingSquares(List<CollisionBlock>& list, Re
     }
     block.polyBounds = block.poly.boundBox();
     block.kind = std::max({collisionKind(x, y), collisionKind(x + 1, y), collisionKind(x, y + 1), collisionKind(x + 1, y + 1)});
-    list.append(std::move(block));
+    m_blocks.append(std::move(block));
   };
 
   int xMin = region.xMin();
@@ -213,19 +195,6 @@ void CollisionGenerator::getBlocksMarchingSquares(List<CollisionBlock>& list, Re
   }
 }
 
-void CollisionGenerator::populateCollisionBuffer(RectI const& region) const {
-  int xmin = region.xMin() - BlockInfluenceRadius;
-  int ymin = region.yMin() - BlockInfluenceRadius;
-  int xmax = region.xMax() + BlockInfluenceRadius;
-  int ymax = region.yMax() + BlockInfluenceRadius;
-
-  m_collisionBufferCorner = {xmin, ymin};
-  m_collisionBuffer.resize(xmax - xmin, ymax - ymin);
-  for (int x = xmin; x < xmax; ++x)
-    for (int y = ymin; y < ymax; ++y)
-      m_collisionBuffer(x - xmin, y - ymin) = m_accessor(x, y);
-}
-
 CollisionKind CollisionGenerator::collisionKind(int x, int y) const {
   return m_collisionBuffer(x - m_collisionBufferCorner[0], y - m_collisionBufferCorner[1]);
 }
@@ -3,8 +3,6 @@
 #include "StarCollisionBlock.hpp"
 #include "StarMultiArray.hpp"
 
-#include <functional>
-
 namespace Star {
 
 STAR_CLASS(CollisionGenerator);
@@ -21,27 +19,48 @@ public:
   // space.
   static size_t const MaximumCollisionsPerSpace = 4;
 
-  // Callback function to tell what kind of collision geometry is in a cell.
-  // Will be called up to BlockInfluenceRadius outside of the given query
-  // region.
-  typedef std::function<CollisionKind(int, int)> CollisionKindAccessor;
-
-  void init(CollisionKindAccessor accessor);
-
-  // Get collision geometry for the given block region.
-  List<CollisionBlock> getBlocks(RectI const& region) const;
+  // Get collision geometry for the given block region.  The accessor is
+  // called as accessor(int x, int y) -> CollisionKind to tell what kind of
+  // collision geometry is in a cell, and will be called up to
+  // BlockInfluenceRadius outside of the given query region.
+  //
+  // The returned blocks are kept in the generator, and are only valid until
+  // the next call to getBlocks.  They may be moved from.
+  template <typename CollisionKindAccessor>
+  List<CollisionBlock>& getBlocks(RectI const& region, CollisionKindAccessor&& accessor);
 
 private:
-  void getBlocksPlatforms(List<CollisionBlock>& output, RectI const& region, CollisionKind kind) const;
-  void getBlocksMarchingSquares(List<CollisionBlock>& output, RectI const& region, CollisionKind kind) const;
+  void getBlocksPlatforms(RectI const& region, CollisionKind kind);
+  void getBlocksMarchingSquares(RectI const& region, CollisionKind kind);
 
-  void populateCollisionBuffer(RectI const& region) const;
   CollisionKind collisionKind(int x, int y) const;
 
-  CollisionKindAccessor m_accessor;
-
-  mutable Vec2I m_collisionBufferCorner;
-  mutable MultiArray<CollisionKind, 2> m_collisionBuffer;
+  Vec2I m_collisionBufferCorner;
+  MultiArray<CollisionKind, 2> m_collisionBuffer;
+  List<CollisionBlock> m_blocks;
 };
 
+template <typename CollisionKindAccessor>
+List<CollisionBlock>& CollisionGenerator::getBlocks(RectI const& region, CollisionKindAccessor&& accessor) {
+  m_blocks.clear();
+  if (region.isNull())
+    return m_blocks;
+
+  int xmin = region.xMin() - BlockInfluenceRadius;
+  int ymin = region.yMin() - BlockInfluenceRadius;
+  int xmax = region.xMax() + BlockInfluenceRadius;
+  int ymax = region.yMax() + BlockInfluenceRadius;
+
+  m_collisionBufferCorner = {xmin, ymin};
+  m_collisionBuffer.resize(xmax - xmin, ymax - ymin);
+  for (int x = xmin; x < xmax; ++x)
+    for (int y = ymin; y < ymax; ++y)
+      m_collisionBuffer(x - xmin, y - ymin) = accessor(x, y);
+
+  getBlocksMarchingSquares(region, CollisionKind::Dynamic);
+  getBlocksPlatforms(region, CollisionKind::Platform);
+
+  return m_blocks;
+}
+
 }
@@ -795,6 +795,45 @@ String CommandProcessor::entityEval(ConnectionId connectionId, String const& lua
   return done ? message : "failed to do entity eval";
 }
 
+String CommandProcessor::luaProfile(ConnectionId connectionId, String const& argumentString) {
+  if (auto errorMsg = adminCheck(connectionId, "profile world scripts"))
+    return *errorMsg;
+
+  auto arguments = m_parser.tokenizeToStringList(argumentString);
+  if (!arguments.empty() && arguments[0] == "interval") {
+    unsigned sampleInterval = lexicalCast<unsigned>(arguments.at(1));
+    size_t worldCount = 0;
+    m_universe->executeForWorlds([sampleInterval, &worldCount](WorldServer* world) {
+        world->luaRoot()->setProfileSampleInterval(sampleInterval);
+        ++worldCount;
+      });
+    return strf("Set script profile sample interval to {} on {} worlds", sampleInterval, worldCount);
+  }
+
+  if (!arguments.empty() && arguments[0] == "reset") {
+    m_universe->executeForWorlds([](WorldServer* world) {
+        world->luaRoot()->clearSampledProfile();
+      });
+    return "Cleared script profiles";
+  }
+
+  size_t count = arguments.empty() ? 10 : lexicalCast<size_t>(arguments[0]);
+  StringList report;
+  m_universe->executeForWorlds([count, &report](WorldServer* world) {
+      auto luaRoot = world->luaRoot();
+      if (luaRoot->profileSampleInterval() == 0)
+        return;
+      report.append(strf("{}:", world->worldId()));
+      for (auto const& line : luaRoot->sampledProfileReport(count))
+        report.append(strf("  {}", line));
+    });
+
+  if (report.empty())
+    return "Script profiling is not enabled on any world, use 'luaprofile interval <sampleInterval>' to enable it";
+  report.append(strf("Instructions are counted in steps of {}, shorter calls may show as 0 or 1", LuaRoot::ProfileInstructionMeasureInterval));
+  return report.join("\n");
+}
+
 String CommandProcessor::enableSpawning(ConnectionId connectionId, String const&) {
   if (auto errorMsg = adminCheck(connectionId, "enable world spawning"))
     return *errorMsg;
@@ -1020,6 +1059,7 @@ const CaseInsensitiveStringMap<std::function<String(CommandProcessor*, Connectio
   add("serverreload", &CommandProcessor::serverReload);
   add("eval", &CommandProcessor::eval);
   add("entityeval", &CommandProcessor::entityEval);
+  add("luaprofile", &CommandProcessor::luaProfile);
   add("enablespawning", &CommandProcessor::enableSpawning);
   add("disablespawning", &CommandProcessor::disableSpawning);
   add("placedungeon", &CommandProcessor::placeDungeon);
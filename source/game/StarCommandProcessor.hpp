@@ -50,6 +50,7 @@ private:
   String serverReload(ConnectionId connectionId, String const& argumentString);
   String eval(ConnectionId connectionId, String const& lua);
   String entityEval(ConnectionId connectionId, String const& lua);
+  String luaProfile(ConnectionId connectionId, String const& argumentString);
   String enableSpawning(ConnectionId connectionId, String const& argumentString);
   String disableSpawning(ConnectionId connectionId, String const& argumentString);
   String placeDungeon(ConnectionId connectionId, String const& argumentString);
@@ -565,6 +565,133 @@ namespace Dungeon {
     return false;
   }
 
+  TileFootprint::TileFootprint() : m_bounds(RectI::null()), m_rowWords(0) {}
+
+  TileFootprint::TileFootprint(List<Vec2I> const& positions) : TileFootprint() {
+    if (positions.empty())
+      return;
+
+    m_bounds = RectI::boundBoxOfPoints(positions);
+    m_bounds.setMax(m_bounds.max() + Vec2I(1, 1));
+    m_rowWords = (m_bounds.width() + 63) / 64;
+    m_bits.resize(m_rowWords * m_bounds.height(), 0);
+    for (auto const& pos : positions) {
+      Vec2I offset = pos - m_bounds.min();
+      m_bits[offset[1] * m_rowWords + offset[0] / 64] |= (uint64_t)1 << (offset[0] % 64);
+    }
+
+    for (int y = 0; y < m_bounds.height(); ++y) {
+      for (int x = 0; x < m_bounds.width(); ++x) {
+        if (m_bits[y * m_rowWords + x / 64] & ((uint64_t)1 << (x % 64)))
+          m_tiles.append(m_bounds.min() + Vec2I(x, y));
+      }
+    }
+  }
+
+  bool TileFootprint::empty() const {
+    return m_tiles.empty();
+  }
+
+  RectI TileFootprint::bounds() const {
+    return m_bounds;
+  }
+
+  List<Vec2I> const& TileFootprint::tiles() const {
+    return m_tiles;
+  }
+
+  size_t TileFootprint::rowWords() const {
+    return m_rowWords;
+  }
+
+  uint64_t const* TileFootprint::row(int row) const {
+    return m_bits.ptr() + row * m_rowWords;
+  }
+
+  bool TileBitmapSet::contains(Vec2I const& pos) const {
+    Vec2I offset(pmod(pos[0], ChunkSize), pmod(pos[1], ChunkSize));
+    if (auto chunk = m_chunks.ptr((pos - offset) / ChunkSize))
+      return (*chunk)[offset[1]] & ((uint64_t)1 << offset[0]);
+    return false;
+  }
+
+  void TileBitmapSet::add(Vec2I const& pos, TileFootprint const& footprint) {
+    forEachChunkWord(pos, footprint, [this](Vec2I const& chunkPos, int chunkRow, uint64_t mask) {
+        if (mask)
+          m_chunks.insert(chunkPos, Chunk::filled(0)).first->second[chunkRow] |= mask;
+        return false;
+      });
+  }
+
+  Maybe<Vec2I> TileBitmapSet::findIntersection(Vec2I const& pos, TileFootprint const& footprint) const {
+    Maybe<Vec2I> result;
+    forEachChunkWord(pos, footprint, [this, &result](Vec2I const& chunkPos, int chunkRow, uint64_t mask) {
+        auto chunk = m_chunks.ptr(chunkPos);
+        uint64_t bits = chunk ? (*chunk)[chunkRow] & mask : 0;
+        if (!bits)
+          return false;
+
+        int x = 0;
+        while (!(bits & ((uint64_t)1 << x)))
+          ++x;
+        result = chunkPos * ChunkSize + Vec2I(x, chunkRow);
+        return true;
+      });
+    return result;
+  }
+
+  template <typename Function>
+  void TileBitmapSet::forEachChunkWord(Vec2I const& pos, TileFootprint const& footprint, Function&& function) {
+    if (footprint.empty())
+      return;
+
+    // Each word of the footprint covers the end of one chunk row and the start
+    // of the next, unless it happens to line up with the chunk exactly.
+    Vec2I origin = pos + footprint.bounds().min();
+    for (int y = 0; y < footprint.bounds().height(); ++y) {
+      int chunkRow = pmod(origin[1] + y, ChunkSize);
+      int chunkY = (origin[1] + y - chunkRow) / ChunkSize;
+      uint64_t const* row = footprint.row(y);
+      for (size_t w = 0; w < footprint.rowWords(); ++w) {
+        if (!row[w])
+          continue;
+
+        int wordX = origin[0] + (int)w * 64;
+        int shift = pmod(wordX, ChunkSize);
+        int chunkX = (wordX - shift) / ChunkSize;
+        if (function(Vec2I(chunkX, chunkY), chunkRow, row[w] << shift))
+          return;
+        if (shift != 0 && function(Vec2I(chunkX + 1, chunkY), chunkRow, row[w] >> (ChunkSize - shift)))
+          return;
+      }
+    }
+  }
+
+  template <typename Function>
+  void TileBitmapSet::addChecked(Vec2I const& pos, TileFootprint const& footprint, TileBitmapSet& checked, Function&& check) {
+    forEachChunkWord(pos, footprint, [this, &checked, &check](Vec2I const& chunkPos, int chunkRow, uint64_t mask) {
+        if (!mask)
+          return false;
+
+        auto checkedChunk = checked.m_chunks.ptr(chunkPos);
+        if (!checkedChunk)
+          checkedChunk = &checked.m_chunks.insert(chunkPos, Chunk::filled(0)).first->second;
+        uint64_t unchecked = mask & ~(*checkedChunk)[chunkRow];
+        if (!unchecked)
+          return false;
+        (*checkedChunk)[chunkRow] |= unchecked;
+
+        uint64_t found = 0;
+        for (int x = 0; unchecked; ++x, unchecked >>= 1) {
+          if ((unchecked & 1) && check(chunkPos * ChunkSize + Vec2I(x, chunkRow)))
+            found |= (uint64_t)1 << x;
+        }
+        if (found)
+          m_chunks.insert(chunkPos, Chunk::filled(0)).first->second[chunkRow] |= found;
+        return false;
+      });
+  }
+
   PartConstPtr parsePart(DungeonDefinition* dungeon, Json const& definition, Maybe<ImageTilesetConstPtr> tileset) {
     String kind = definition.get("def").getString(0);
     if (kind == "image") {
@@ -600,6 +727,7 @@ namespace Dungeon {
     m_size = m_reader->size();
     scanConnectors();
     scanAnchor();
+    scanFootprints();
   }
 
   String const& Part::name() const {
@@ -696,44 +824,41 @@ namespace Dungeon {
     return true;
   }
 
-  bool Part::collidesWithPlaces(Vec2I pos, Set<Vec2I>& places) const {
+  bool Part::collidesWithPlaces(Vec2I pos, TileBitmapSet const& places) const {
     if (m_overrideAllowAlways)
       return true;
 
-    bool result = false;
-    m_reader->forEachTile([&result, pos, &places](Vec2I tilePos, Tile const& tile) -> bool {
-      if (tile.collidesWithPlaces())
-        if (places.contains(pos + tilePos)) {
-          Logger::debug("Tile collided with place at {}", pos + tilePos);
-          result = true;
-          return true;
-        }
-      return false;
-    });
+    if (auto collision = places.findIntersection(pos, m_placesFootprint)) {
+      Logger::debug("Tile collided with place at {}", *collision);
+      return true;
+    }
 
-    return result;
+    return false;
   }
 
   bool Part::canPlace(Vec2I pos, DungeonGeneratorWriter* writer) const {
-    if (m_overrideAllowAlways)
+    if (m_overrideAllowAlways || m_footprint.empty())
       return true;
 
-    // Speed up repeated failing calls by first checking the tile that failed
-    // last time (if it did).
-    bool result = true;
-    m_reader->forEachTile([&result, pos, writer](Vec2I tilePos, Tile const& tile) -> bool {
-      Vec2I position = pos + tilePos;
-      if (!tile.canPlace(position, writer)) {
-        result = false;
-        return true;
-      }
+    // Same as Tile::canPlace for every tile, but only checking each position
+    // once no matter how many layers it is in.
+    if (pos[1] + m_footprint.bounds().yMin() < 0)
       return false;
-    });
 
-    return result;
+    if (writer->findOtherDungeon(pos, m_footprint))
+      return false;
+
+    for (auto const& ruleTile : m_ruleTiles) {
+      for (auto const& rule : ruleTile.second->rules) {
+        if (!rule->checkTileCanPlace(pos + ruleTile.first, writer))
+          return false;
+      }
+    }
+
+    return true;
   }
 
-  void Part::place(Vec2I pos, Set<Vec2I> const& places, DungeonGeneratorWriter* writer) const {
+  void Part::place(Vec2I pos, TileBitmapSet const& places, DungeonGeneratorWriter* writer) const {
     placePhase(pos, Phase::ClearPhase, places, writer);
     placePhase(pos, Phase::WallPhase, places, writer);
     placePhase(pos, Phase::ModsPhase, places, writer);
@@ -750,7 +875,15 @@ namespace Dungeon {
     m_reader->forEachTile(callback);
   }
 
-  void Part::placePhase(Vec2I pos, Phase phase, Set<Vec2I> const& places, DungeonGeneratorWriter* writer) const {
+  TileFootprint const& Part::placesFootprint() const {
+    return m_placesFootprint;
+  }
+
+  TileFootprint const& Part::modifiesFootprint() const {
+    return m_modifiesFootprint;
+  }
+
+  void Part::placePhase(Vec2I pos, Phase phase, TileBitmapSet const& places, DungeonGeneratorWriter* writer) const {
     m_reader->forEachTile([&places, pos, phase, writer](Vec2I tilePos, Tile const& tile) -> bool {
       Vec2I position = pos + tilePos;
       if (tile.collidesWithPlaces() || !places.contains(position)) {
@@ -901,6 +1034,26 @@ namespace Dungeon {
     m_anchorPoint = {cx, cy};
   }
 
+  void Part::scanFootprints() {
+    List<Vec2I> footprint;
+    List<Vec2I> placesFootprint;
+    List<Vec2I> modifiesFootprint;
+    m_reader->forEachTile([&](Vec2I pos, Tile const& tile) -> bool {
+        footprint.append(pos);
+        if (tile.usesPlaces())
+          placesFootprint.append(pos);
+        if (tile.modifiesPlaces())
+          modifiesFootprint.append(pos);
+        if (!tile.rules.empty())
+          m_ruleTiles.append({pos, &tile});
+        return false;
+      });
+
+    m_footprint = TileFootprint(footprint);
+    m_placesFootprint = TileFootprint(placesFootprint);
+    m_modifiesFootprint = TileFootprint(modifiesFootprint);
+  }
+
   bool WorldGenMustContainSolidRule::checkTileCanPlace(Vec2I position, DungeonGeneratorWriter* writer) const {
     return writer->checkSolid(position, layer);
   }
@@ -1093,6 +1246,13 @@ namespace Dungeon {
     return m_facade->getDungeonIdAt(position) != NoDungeonId;
   }
 
+  Maybe<Vec2I> DungeonGeneratorWriter::findOtherDungeon(Vec2I const& pos, TileFootprint const& footprint) {
+    m_otherDungeonTiles.addChecked(pos, footprint, m_checkedDungeonTiles, [this](Vec2I const& tilePos) {
+        return otherDungeonPresent(tilePos);
+      });
+    return m_otherDungeonTiles.findIntersection(pos, footprint);
+  }
+
   void DungeonGeneratorWriter::setDungeonId(Vec2I const& pos, DungeonId dungeonId) {
     m_dungeonIds[pos] = dungeonId;
   }
@@ -1275,6 +1435,9 @@ namespace Dungeon {
 
     for (auto const& dungeonId : m_dungeonIds)
       m_facade->setDungeonIdAt(dungeonId.first, dungeonId.second);
+
+    m_otherDungeonTiles = {};
+    m_checkedDungeonTiles = {};
   }
 
   List<RectI> DungeonGeneratorWriter::boundingBoxes() const {
@@ -1301,6 +1464,8 @@ namespace Dungeon {
     m_localWires.clear();
     m_openLocalWires.clear();
     m_boundingBoxes.clear();
+    m_otherDungeonTiles = {};
+    m_checkedDungeonTiles = {};
   }
 }
 
@@ -1364,6 +1529,23 @@ DungeonDefinition::DungeonDefinition(JsonObject const& definition, String const&
     m_parts.insert(part->name(), part);
   }
 
+  // Connectors can only connect to others with the same value, so only those
+  // need to be checked.
+  StringMap<List<Dungeon::ConnectorConstPtr>> connectorsByValue;
+  for (auto const& partPair : m_parts) {
+    for (auto const& connection : partPair.second->connections())
+      connectorsByValue[connection->value()].append(connection);
+  }
+  for (auto const& partPair : m_parts) {
+    for (auto const& connector : partPair.second->connections()) {
+      auto& connectable = m_connectableParts[connector.get()];
+      for (auto const& connection : connectorsByValue.get(connector->value())) {
+        if (!connection->part()->doesNotConnectTo(connector->part()) && connection->connectsTo(connector))
+          connectable.append(connection);
+      }
+    }
+  }
+
   if (m_metadata.contains("gravity"))
     m_gravity = m_metadata.get("gravity").toFloat();
 
@@ -1403,6 +1585,10 @@ StringMap<Dungeon::PartConstPtr> const& DungeonDefinition::parts() const {
   return m_parts;
 }
 
+List<Dungeon::ConnectorConstPtr> const& DungeonDefinition::connectableParts(Dungeon::Connector const* connector) const {
+  return m_connectableParts.get(connector);
+}
+
 List<String> const& DungeonDefinition::anchors() const {
   return m_anchors;
 }
@@ -1460,18 +1646,15 @@ pair<List<RectI>, Set<Vec2I>> DungeonGenerator::buildDungeon(Dungeon::PartConstP
   Deque<std::pair<Dungeon::Part const*, Vec2I>> openSet;
   StringMap<int> placementCounter;
   Set<Vec2I> modifiedTiles;
-  Set<Vec2I> preserveTiles;
+  Dungeon::TileBitmapSet preserveTiles;
   int piecesPlaced = 0;
 
   Logger::debug("Placing dungeon entrance at {}", basePos);
 
   auto placePart = [&](Dungeon::Part const* part, Vec2I const& placePos) {
       Set<Vec2I> clearTileEntityPositions;
-      part->forEachTile([&](Vec2I tilePos, Dungeon::Tile const& tile) -> bool {
-          if (tile.modifiesPlaces())
-            clearTileEntityPositions.insert(writer->wrapPosition(placePos + tilePos));
-          return false;
-        });
+      for (auto const& tilePos : part->modifiesFootprint().tiles())
+        clearTileEntityPositions.insert(writer->wrapPosition(placePos + tilePos));
       auto partBounds = RectI::withSize(placePos, Vec2I(part->size()));
       writer->clearTileEntities(partBounds, clearTileEntityPositions, part->clearAnchoredObjects());
 
@@ -1483,13 +1666,9 @@ pair<List<RectI>, Set<Vec2I>> DungeonGenerator::buildDungeon(Dungeon::PartConstP
       part->place(placePos, preserveTiles, writer);
       writer->finishPart();
 
-      part->forEachTile([&](Vec2I tilePos, Dungeon::Tile const& tile) -> bool {
-          if (tile.usesPlaces())
-            preserveTiles.insert(placePos + tilePos);
-          if (tile.modifiesPlaces())
-            modifiedTiles.insert(placePos + tilePos);
-          return false;
-        });
+      preserveTiles.add(placePos, part->placesFootprint());
+      for (auto const& tilePos : part->modifiesFootprint().tiles())
+        modifiedTiles.insert(placePos + tilePos);
 
       openSet.append({part, placePos});
 
@@ -1582,16 +1761,7 @@ Dungeon::PartConstPtr DungeonGenerator::pickAnchor() {
 }
 
 List<Dungeon::ConnectorConstPtr> DungeonGenerator::findConnectablePart(Dungeon::ConnectorConstPtr connector) const {
-  List<Dungeon::ConnectorConstPtr> result;
-  for (auto const& partPair : m_def->parts()) {
-    if (partPair.second->doesNotConnectTo(connector->part()))
-      continue;
-    for (auto const& connection : partPair.second->connections()) {
-      if (connection->connectsTo(connector))
-        result.append(connection);
-    }
-  }
-  return result;
+  return m_def->connectableParts(connector.get());
 }
 
 DungeonDefinitionConstPtr DungeonGenerator::definition() const {
@@ -64,6 +64,60 @@ namespace Dungeon {
   STAR_STRUCT(Tile);
   STAR_CLASS(Connector);
 
+  // A set of tile positions within a part, stored as a bitmap over the region
+  // the tiles cover, one row of 64 bit words after another.
+  class TileFootprint {
+  public:
+    TileFootprint();
+    TileFootprint(List<Vec2I> const& positions);
+
+    bool empty() const;
+    // Region containing every tile, may extend outside of the part itself
+    RectI bounds() const;
+    // Every tile position exactly once, from the bottom row up
+    List<Vec2I> const& tiles() const;
+
+    size_t rowWords() const;
+    // Bits for the given row, counted from the bottom of the bounds.  Bit i of
+    // word w is the tile at bounds().xMin() + w * 64 + i.
+    uint64_t const* row(int row) const;
+
+  private:
+    RectI m_bounds;
+    size_t m_rowWords;
+    List<uint64_t> m_bits;
+    List<Vec2I> m_tiles;
+  };
+
+  // Set of world tile positions kept as 64x64 tile bitmaps, so that a whole
+  // part footprint can be tested against or added to it a word at a time.
+  class TileBitmapSet {
+  public:
+    bool contains(Vec2I const& pos) const;
+    void add(Vec2I const& pos, TileFootprint const& footprint);
+    // Returns the first tile of the footprint placed at pos that is already in
+    // the set, if any.
+    Maybe<Vec2I> findIntersection(Vec2I const& pos, TileFootprint const& footprint) const;
+    // Calls 'check' on every tile of the footprint placed at pos that is not
+    // yet in 'checked', and adds the tiles it returns true for to this set.
+    // Every tile of the footprint is then in 'checked', so a set mirroring
+    // some property of the world only looks up each tile once.
+    template <typename Function>
+    void addChecked(Vec2I const& pos, TileFootprint const& footprint, TileBitmapSet& checked, Function&& check);
+
+  private:
+    static int const ChunkSize = 64;
+    typedef Array<uint64_t, ChunkSize> Chunk;
+
+    // Calls the function with the chunk position, row within the chunk, and
+    // bits within the chunk row for every part of every row of the footprint
+    // placed at pos.  The function can return true to stop early.
+    template <typename Function>
+    static void forEachChunkWord(Vec2I const& pos, TileFootprint const& footprint, Function&& function);
+
+    HashMap<Vec2I, Chunk> m_chunks;
+  };
+
   class DungeonGeneratorWriter {
   public:
     DungeonGeneratorWriter(DungeonGeneratorWorldFacadePtr facade, Maybe<int> terrainMarkingSurfaceLevel, Maybe<int> terrainSurfaceSpaceExtends);
@@ -93,6 +147,9 @@ namespace Dungeon {
     bool checkOpen(Vec2I position, TileLayer layer);
     bool checkLiquid(Vec2I const& position);
     bool otherDungeonPresent(Vec2I position);
+    // Returns the first tile of the footprint placed at pos that belongs to a
+    // dungeon already in the world, if any.
+    Maybe<Vec2I> findOtherDungeon(Vec2I const& pos, TileFootprint const& footprint);
     void setDungeonId(Vec2I const& pos, DungeonId dungeonId);
     void markPosition(Vec2F const& pos);
     void markPosition(Vec2I const& pos);
@@ -155,6 +212,11 @@ namespace Dungeon {
     List<Set<Vec2I>> m_localWires;
     StringMap<Set<Vec2I>> m_openLocalWires;
 
+    // Dungeon ids in the world only change on flush, so every tile that has
+    // been checked for another dungeon is remembered until then.
+    TileBitmapSet m_otherDungeonTiles;
+    TileBitmapSet m_checkedDungeonTiles;
+
     Maybe<DungeonId> m_markDungeonId;
     RectI m_currentBounds;
     List<RectI> m_boundingBoxes;
@@ -577,22 +639,29 @@ namespace Dungeon {
     List<ConnectorConstPtr> const& connections() const;
     bool doesNotConnectTo(Part* part) const;
     bool checkPartCombinationsAllowed(StringMap<int> const& placementCounts) const;
-    bool collidesWithPlaces(Vec2I pos, Set<Vec2I>& places) const;
+    bool collidesWithPlaces(Vec2I pos, TileBitmapSet const& places) const;
 
     bool canPlace(Vec2I pos, DungeonGeneratorWriter* writer) const;
 
-    void place(Vec2I pos, Set<Vec2I> const& places, DungeonGeneratorWriter* writer) const;
+    void place(Vec2I pos, TileBitmapSet const& places, DungeonGeneratorWriter* writer) const;
 
     void forEachTile(TileCallback const& callback) const;
 
+    // Tiles that use places, and so are preserved from being drawn over by
+    // later parts
+    TileFootprint const& placesFootprint() const;
+    // Tiles that draw anything at all
+    TileFootprint const& modifiesFootprint() const;
+
   private:
-    void placePhase(Vec2I pos, Phase phase, Set<Vec2I> const& places, DungeonGeneratorWriter* writer) const;
+    void placePhase(Vec2I pos, Phase phase, TileBitmapSet const& places, DungeonGeneratorWriter* writer) const;
 
     bool tileUsesPlaces(Vec2I pos) const;
     Direction pickByEdge(Vec2I position, Vec2U size) const;
     Direction pickByNeighbours(Vec2I pos) const;
     void scanConnectors();
     void scanAnchor();
+    void scanFootprints();
 
     PartReaderConstPtr m_reader;
 
@@ -608,6 +677,13 @@ namespace Dungeon {
     Vec2U m_size;
     float m_chance;
     bool m_markDungeonId;
+
+    // Scanned once from the reader so that placement tests do not need to go
+    // through every layer of the part again.
+    TileFootprint m_footprint;
+    TileFootprint m_placesFootprint;
+    TileFootprint m_modifiesFootprint;
+    List<pair<Vec2I, Tile const*>> m_ruleTiles;
   };
 
   struct TileConnector {
@@ -644,6 +720,9 @@ public:
   Maybe<float> gravity() const;
   Maybe<bool> breathable() const;
   StringMap<Dungeon::PartConstPtr> const& parts() const;
+  // Every connector of every part that the given connector can connect to, in
+  // the order of parts()
+  List<Dungeon::ConnectorConstPtr> const& connectableParts(Dungeon::Connector const* connector) const;
 
   List<String> const& anchors() const;
   Maybe<Json> const& optTileset() const;
@@ -662,6 +741,7 @@ private:
   bool m_isProtected;
   List<Dungeon::RuleConstPtr> m_rules;
   StringMap<Dungeon::PartConstPtr> m_parts;
+  HashMap<Dungeon::Connector const*, List<Dungeon::ConnectorConstPtr>> m_connectableParts;
   List<String> m_anchors;
   Maybe<Json> m_tileset;
 
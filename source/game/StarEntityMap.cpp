@@ -89,40 +89,40 @@ List<EntityId> EntityMap::entityIds() const {
   return m_spatialMap.keys();
 }
 
-void EntityMap::updateAllEntities(EntityCallback const& callback, function<bool(EntityPtr const&, EntityPtr const&)> sortOrder) {
-  auto updateEntityInfo = [&](SpatialMap::Entry const& entry) {
-    auto const& entity = entry.value;
+void EntityMap::updateEntityInfo(SpatialMap::Entry const& entry) {
+  auto const& entity = entry.value;
 
-    auto position = entity->position();
-    auto boundBox = entity->metaBoundBox();
+  auto position = entity->position();
+  auto boundBox = entity->metaBoundBox();
 
-    if (boundBox.isNegative() || boundBox.width() > MaximumEntityBoundBox || boundBox.height() > MaximumEntityBoundBox) {
-      throw EntityMapException::format("Entity id: {} type: {} bound box is negative or beyond the maximum entity bound box size in EntityMap::addEntity",
-          entity->entityId(), (int)entity->entityType());
-    }
+  if (boundBox.isNegative() || boundBox.width() > MaximumEntityBoundBox || boundBox.height() > MaximumEntityBoundBox) {
+    throw EntityMapException::format("Entity id: {} type: {} bound box is negative or beyond the maximum entity bound box size in EntityMap::addEntity",
+        entity->entityId(), (int)entity->entityType());
+  }
 
-    auto entityId = entity->entityId();
-    if (entityId == NullEntityId)
-      throw EntityMapException::format("Null entity id in EntityMap::setEntityInfo");
-
-    auto rects = m_geometry.splitRect(boundBox, position);
-    if (!containersEqual(rects, entry.rects))
-      m_spatialMap.set(entityId, rects);
-
-    auto uniqueId = entity->uniqueId();
-    if (uniqueId) {
-      if (auto existingEntityId = m_uniqueMap.maybeRight(*uniqueId)) {
-        if (entityId != *existingEntityId)
-          throw EntityMapException::format("Duplicate entity unique id on entity ids ({}) and ({})", *existingEntityId, entityId);
-      } else {
-        m_uniqueMap.removeRight(entityId);
-        m_uniqueMap.add(*uniqueId, entityId);
-      }
+  auto entityId = entity->entityId();
+  if (entityId == NullEntityId)
+    throw EntityMapException::format("Null entity id in EntityMap::setEntityInfo");
+
+  auto rects = m_geometry.splitRect(boundBox, position);
+  if (!containersEqual(rects, entry.rects))
+    m_spatialMap.set(entityId, rects);
+
+  auto uniqueId = entity->uniqueId();
+  if (uniqueId) {
+    if (auto existingEntityId = m_uniqueMap.maybeRight(*uniqueId)) {
+      if (entityId != *existingEntityId)
+        throw EntityMapException::format("Duplicate entity unique id on entity ids ({}) and ({})", *existingEntityId, entityId);
     } else {
       m_uniqueMap.removeRight(entityId);
+      m_uniqueMap.add(*uniqueId, entityId);
     }
-  };
+  } else {
+    m_uniqueMap.removeRight(entityId);
+  }
+}
 
+void EntityMap::updateAllEntities(EntityCallback const& callback, function<bool(EntityPtr const&, EntityPtr const&)> sortOrder) {
   // Even if there is no sort order, we still copy pointers to a temporary
   // list, so that it is safe to call addEntity from the callback.
   m_entrySortBuffer.clear();
@@ -142,6 +142,36 @@ void EntityMap::updateAllEntities(EntityCallback const& callback, function<bool(
   }
 }
 
+void EntityMap::updateAllEntitiesByType(EntityCallback const& callback) {
+  // Group entities by type with a single counting pass rather than a
+  // comparison sort, entities of the same type keep their relative order so
+  // the update order is stable from tick to tick.
+  m_entryTypeCounts.fill(0);
+  m_entryTypeBuffer.clear();
+  for (auto const& entry : m_spatialMap.entries()) {
+    uint8_t type = (uint8_t)entry.second.value->entityType();
+    m_entryTypeBuffer.append({type, &entry.second});
+    ++m_entryTypeCounts[type];
+  }
+
+  size_t offset = 0;
+  for (size_t i = 0; i < m_entryTypeCounts.size(); ++i) {
+    size_t count = m_entryTypeCounts[i];
+    m_entryTypeCounts[i] = offset;
+    offset += count;
+  }
+
+  m_entrySortBuffer.resize(m_entryTypeBuffer.size());
+  for (auto const& p : m_entryTypeBuffer)
+    m_entrySortBuffer[m_entryTypeCounts[p.first]++] = p.second;
+
+  for (auto entry : m_entrySortBuffer) {
+    if (callback)
+      callback(entry->value);
+    updateEntityInfo(*entry);
+  }
+}
+
 EntityId EntityMap::uniqueEntityId(String const& uniqueId) const {
   return m_uniqueMap.maybeRight(uniqueId).value(NullEntityId);
 }
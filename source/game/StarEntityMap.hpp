@@ -45,6 +45,12 @@ public:
   // Iterates through the entity map optionally in the given order, updating
   // the spatial information for each entity along the way.
   void updateAllEntities(EntityCallback const& callback = {}, function<bool(EntityPtr const&, EntityPtr const&)> sortOrder = {});
+  // Same as updateAllEntities, but iterates entities grouped by ascending
+  // EntityType without going through a comparison sort every call.  Entities
+  // are always updated one at a time, as even entities without scripts such
+  // as item drops and projectiles modify other entities and the world's
+  // collision caches from their updates.
+  void updateAllEntitiesByType(EntityCallback const& callback = {});
 
   // If the given unique entity is in this map, then return its entity id
   EntityId uniqueEntityId(String const& uniqueId) const;
@@ -127,7 +133,11 @@ private:
   EntityId m_beginIdSpace;
   EntityId m_endIdSpace;
 
+  void updateEntityInfo(SpatialMap::Entry const& entry);
+
   List<SpatialMap::Entry const*> m_entrySortBuffer;
+  List<pair<uint8_t, SpatialMap::Entry const*>> m_entryTypeBuffer;
+  Array<size_t, 256> m_entryTypeCounts;
 };
 
 template <typename EntityT>
@@ -27,6 +27,9 @@ LiquidsDatabase::LiquidsDatabase() {
   m_liquidEngineParameters.minimumLivenLevelChange = liquidEngineParameters.getFloat("minimumLivenLevelChange");
   m_liquidEngineParameters.minimumLiquidLevel = liquidEngineParameters.getFloat("minimumLiquidLevel");
   m_liquidEngineParameters.interactTransformationLevel = liquidEngineParameters.getFloat("interactTransformationLevel");
+  m_liquidEngineParameters.maximumSleepingChunkChange = liquidEngineParameters.getFloat("maximumSleepingChunkChange", 0.0f);
+  m_liquidEngineParameters.chunkSleepUpdates = liquidEngineParameters.getUInt("chunkSleepUpdates", 0);
+  m_liquidEngineParameters.minimumChunkWakeChange = liquidEngineParameters.getFloat("minimumChunkWakeChange", 0.0f);
 
   m_backgroundDrain = config.getFloat("backgroundDrain");
 
@@ -2,9 +2,23 @@
 #include "StarIterator.hpp"
 #include "StarCompression.hpp"
 #include "StarLogging.hpp"
+#include "StarVlqEncoding.hpp"
 
 namespace Star {
 
+// Outgoing TcpPacketSocket data is collected in buffers of about this size,
+// and packet data larger than this is sent from its own buffer without being
+// copied.
+static size_t const SendBufferSize = 64 * 1024;
+
+// A packet type followed by a VLQ encoded signed size
+static size_t const MaxPacketHeaderSize = 11;
+
+static size_t writePacketHeader(char* header, PacketType type, int64_t size) {
+  header[0] = (char)type;
+  return 1 + writeVlqI(size, header + 1);
+}
+
 PacketStatCollector::PacketStatCollector(float calculationWindow)
   : m_calculationWindow(calculationWindow), m_stats(), m_totalBytes(0), m_lastMixTime(0) {}
 
@@ -62,12 +76,41 @@ Maybe<PacketStats> PacketSocket::incomingStats() const {
 Maybe<PacketStats> PacketSocket::outgoingStats() const {
   return {};
 }
+
+SocketPtr PacketSocket::pollSocket() const {
+  return {};
+}
+
 void PacketSocket::setNetRules(NetCompatibilityRules netRules) { m_netRules = netRules; }
 NetCompatibilityRules PacketSocket::netRules() const { return m_netRules; }
 
 void CompressedPacketSocket::setCompressionStreamEnabled(bool enabled) { m_useCompressionStream = enabled; }
 bool CompressedPacketSocket::compressionStreamEnabled() const { return m_useCompressionStream; }
 
+void CompressedPacketSocket::setCompressionStreamDictionary(ByteArray const& dictionary) {
+  m_compressionStream.setDictionary(dictionary);
+}
+
+void CompressedPacketSocket::addDecompressionStreamDictionary(ByteArray const& dictionary) {
+  m_decompressionStream.addDictionary(dictionary);
+}
+
+void CompressedPacketSocket::setCompressionStreamCapture(IODevicePtr device) {
+  m_compressionStreamCapture = std::move(device);
+}
+
+void CompressedPacketSocket::captureCompressionStream(ByteArray const& data) {
+  if (!m_compressionStreamCapture)
+    return;
+
+  try {
+    DataStreamIODevice(m_compressionStreamCapture).write(data);
+  } catch (IOException const& e) {
+    Logger::warn("Error writing compression stream capture, stopping capture: {}", outputException(e, false));
+    m_compressionStreamCapture.reset();
+  }
+}
+
 pair<LocalPacketSocketUPtr, LocalPacketSocketUPtr> LocalPacketSocket::openPair() {
   auto lhsIncomingPipe = make_shared<Pipe>();
   auto rhsIncomingPipe = make_shared<Pipe>();
@@ -148,56 +191,58 @@ void TcpPacketSocket::close() {
 
 void TcpPacketSocket::sendPackets(List<PacketPtr> packets) {
   auto it = makeSMutableIterator(packets);
+  m_packetBuffer.setStreamCompatibilityVersion(netRules());
   if (compressionStreamEnabled()) {
-    DataStreamBuffer outBuffer;
     while (it.hasNext()) {
       PacketPtr& packet = it.next();
       auto packetType = packet->type();
-      DataStreamBuffer packetBuffer;
-      packetBuffer.setStreamCompatibilityVersion(netRules());
-      packet->write(packetBuffer, netRules());
-      outBuffer.write(packetType);
-      outBuffer.writeVlqI((int)packetBuffer.size());
-      outBuffer.writeData(packetBuffer.ptr(), packetBuffer.size());
-      m_outgoingStats.mix(packetType, packetBuffer.size(), false);
+      m_packetBuffer.clear();
+      packet->write(m_packetBuffer, netRules());
+      char header[MaxPacketHeaderSize];
+      m_outputBuffer.append(header, writePacketHeader(header, packetType, m_packetBuffer.size()));
+      m_outputBuffer.append(m_packetBuffer.ptr(), m_packetBuffer.size());
+      m_outgoingStats.mix(packetType, m_packetBuffer.size(), false);
     }
-    m_outputBuffer.append(outBuffer.ptr(), outBuffer.size());
   } else {
     while (it.hasNext()) {
       PacketType currentType = it.peekNext()->type();
       PacketCompressionMode currentCompressionMode = it.peekNext()->compressionMode();
 
-      DataStreamBuffer packetBuffer;
-      packetBuffer.setStreamCompatibilityVersion(netRules());
+      m_packetBuffer.clear();
       while (it.hasNext()
              && it.peekNext()->type() == currentType
              && it.peekNext()->compressionMode() == currentCompressionMode) {
-          it.next()->write(packetBuffer, netRules());
+          it.next()->write(m_packetBuffer, netRules());
       }
 
       // Packets must read and write actual data, because this is used to
       // determine packet count
-      starAssert(!packetBuffer.empty());
+      starAssert(!m_packetBuffer.empty());
 
       ByteArray compressedPackets;
       bool mustCompress = currentCompressionMode == PacketCompressionMode::Enabled;
-      bool perhapsCompress = currentCompressionMode == PacketCompressionMode::Automatic && packetBuffer.size() > 64;
+      bool perhapsCompress = currentCompressionMode == PacketCompressionMode::Automatic && m_packetBuffer.size() > 64;
       if (mustCompress || perhapsCompress)
-        compressedPackets = compressData(packetBuffer.data());
+        compressedPackets = compressData(m_packetBuffer.data());
 
-      DataStreamBuffer outBuffer;
-      outBuffer.write(currentType);
-
-      if (!compressedPackets.empty() && (mustCompress || compressedPackets.size() < packetBuffer.size())) {
-        outBuffer.writeVlqI(-(int)(compressedPackets.size()));
-        outBuffer.writeData(compressedPackets.ptr(), compressedPackets.size());
+      char header[MaxPacketHeaderSize];
+      if (!compressedPackets.empty() && (mustCompress || compressedPackets.size() < m_packetBuffer.size())) {
+        queueOutput(header, writePacketHeader(header, currentType, -(int64_t)compressedPackets.size()));
         m_outgoingStats.mix(currentType, compressedPackets.size());
+        queueOutput(std::move(compressedPackets));
       } else {
-        outBuffer.writeVlqI((int)(packetBuffer.size()));
-        outBuffer.writeData(packetBuffer.ptr(), packetBuffer.size());
-        m_outgoingStats.mix(currentType, packetBuffer.size());
+        queueOutput(header, writePacketHeader(header, currentType, m_packetBuffer.size()));
+        m_outgoingStats.mix(currentType, m_packetBuffer.size());
+        if (m_packetBuffer.size() < SendBufferSize) {
+          queueOutput(m_packetBuffer.ptr(), m_packetBuffer.size());
+        } else {
+          ByteArray packetData = m_packetBuffer.takeData();
+          ByteArray nextPacketBuffer = spareBuffer();
+          nextPacketBuffer.reserve(packetData.size());
+          m_packetBuffer.reset(std::move(nextPacketBuffer));
+          queueOutput(std::move(packetData));
+        }
       }
-      m_outputBuffer.append(outBuffer.takeData());
     }
   }
 }
@@ -269,7 +314,7 @@ List<PacketPtr> TcpPacketSocket::receivePackets() {
 }
 
 bool TcpPacketSocket::sentPacketsPending() const {
-  return !m_outputBuffer.empty() || (compressionStreamEnabled() && !m_compressedOutputBuffer.empty());
+  return !m_outputBuffer.empty() || !m_sendChain.empty();
 }
 
 bool TcpPacketSocket::writeData() {
@@ -278,28 +323,40 @@ bool TcpPacketSocket::writeData() {
 
   bool dataSent = false;
   try {
-    if (!m_outputBuffer.empty() || !m_compressedOutputBuffer.empty()) {
-      if (compressionStreamEnabled()) {
-        if (!m_outputBuffer.empty()) {
-          m_compressionStream.compress(m_outputBuffer, m_compressedOutputBuffer);
-          m_outputBuffer.clear();
+    if (compressionStreamEnabled() && !m_outputBuffer.empty()) {
+      captureCompressionStream(m_outputBuffer);
+      ByteArray compressed = spareBuffer();
+      m_compressionStream.compress(m_outputBuffer, compressed);
+      m_outputBuffer.clear();
+      if (compressed.empty())
+        recycleBuffer(std::move(compressed));
+      else
+        m_sendChain.append(std::move(compressed));
+    }
+
+    while (!m_sendChain.empty()) {
+      m_sendBuffers.clear();
+      for (size_t i = 0; i < m_sendChain.size() && i < TcpSocket::MaxSendBuffers; ++i) {
+        size_t offset = i == 0 ? m_sendChainOffset : 0;
+        m_sendBuffers.append({m_sendChain[i].ptr() + offset, m_sendChain[i].size() - offset});
+      }
+
+      size_t written = m_socket->send(m_sendBuffers);
+      if (written == 0)
+        break;
+      dataSent = true;
+      if (compressionStreamEnabled())
+        m_outgoingStats.mix(written);
+
+      while (written != 0) {
+        size_t remaining = m_sendChain.first().size() - m_sendChainOffset;
+        if (written < remaining) {
+          m_sendChainOffset += written;
+          break;
         }
-        do {
-          size_t written = m_socket->send(m_compressedOutputBuffer.ptr(), m_compressedOutputBuffer.size());
-          if (written == 0)
-            break;
-          dataSent = true;
-          m_compressedOutputBuffer.trimLeft(written);
-          m_outgoingStats.mix(written);
-        } while (!m_compressedOutputBuffer.empty());
-      } else {
-        do {
-          size_t written = m_socket->send(m_outputBuffer.ptr(), m_outputBuffer.size());
-          if (written == 0)
-            break;
-          dataSent = true;
-          m_outputBuffer.trimLeft(written);
-        } while (!m_outputBuffer.empty());
+        written -= remaining;
+        m_sendChainOffset = 0;
+        recycleBuffer(m_sendChain.takeFirst());
       }
     }
   } catch (SocketClosedException const& e) {
@@ -344,7 +401,45 @@ Maybe<PacketStats> TcpPacketSocket::outgoingStats() const {
   return m_outgoingStats.stats();
 }
 
-TcpPacketSocket::TcpPacketSocket(TcpSocketPtr socket) : m_socket(std::move(socket)) {}
+SocketPtr TcpPacketSocket::pollSocket() const {
+  return m_socket;
+}
+
+TcpPacketSocket::TcpPacketSocket(TcpSocketPtr socket) : m_socket(std::move(socket)), m_sendChainOffset(0) {}
+
+void TcpPacketSocket::queueOutput(char const* data, size_t size) {
+  if (m_sendChain.empty() || m_sendChain.last().size() + size > SendBufferSize) {
+    m_sendChain.append(spareBuffer());
+    m_sendChain.last().reserve(SendBufferSize);
+  }
+  m_sendChain.last().append(data, size);
+}
+
+void TcpPacketSocket::queueOutput(ByteArray data) {
+  if (data.size() < SendBufferSize) {
+    queueOutput(data.ptr(), data.size());
+    recycleBuffer(std::move(data));
+  } else {
+    m_sendChain.append(std::move(data));
+  }
+}
+
+ByteArray TcpPacketSocket::spareBuffer() {
+  if (m_spareBuffers.empty())
+    return ByteArray();
+  return m_spareBuffers.takeLast();
+}
+
+void TcpPacketSocket::recycleBuffer(ByteArray buffer) {
+  // Keep enough buffers around to send a burst of sector data without
+  // allocating, but not ones left over from a rare huge packet
+  size_t const MaxSpareBuffers = 32;
+  size_t const MaxSpareBufferCapacity = SendBufferSize * 4;
+  if (m_spareBuffers.size() < MaxSpareBuffers && buffer.capacity() <= MaxSpareBufferCapacity) {
+    buffer.clear();
+    m_spareBuffers.append(std::move(buffer));
+  }
+}
 
 P2PPacketSocketUPtr P2PPacketSocket::open(P2PSocketUPtr socket) {
   return P2PPacketSocketUPtr(new P2PPacketSocket(std::move(socket)));
@@ -373,6 +468,7 @@ void P2PPacketSocket::sendPackets(List<PacketPtr> packets) {
       outBuffer.write<bool>(false);
       outBuffer.writeData(packetBuffer.ptr(), packetBuffer.size());
       m_outgoingStats.mix(currentType, packetBuffer.size(), false);
+      captureCompressionStream(outBuffer.data());
       m_outputMessages.append(m_compressionStream.compress(outBuffer.takeData()));
     }
   } else {
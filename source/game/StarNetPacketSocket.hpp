@@ -76,6 +76,11 @@ public:
   virtual Maybe<PacketStats> incomingStats() const;
   virtual Maybe<PacketStats> outgoingStats() const;
 
+  // The socket that readData and writeData operate on, if waiting for it with
+  // Socket::poll is enough to know when they have work to do.  Default
+  // implementation returns nothing.
+  virtual SocketPtr pollSocket() const;
+
   virtual void setNetRules(NetCompatibilityRules netRules);
   virtual NetCompatibilityRules netRules() const;
 
@@ -89,9 +94,22 @@ public:
 
   virtual void setCompressionStreamEnabled(bool enabled);
   virtual bool compressionStreamEnabled() const;
+
+  // Must be set before anything is sent through the compression stream.
+  virtual void setCompressionStreamDictionary(ByteArray const& dictionary);
+  // Dictionaries the other end may have set for its compression stream.
+  virtual void addDecompressionStreamDictionary(ByteArray const& dictionary);
+
+  // Writes everything that goes into the compression stream to the given
+  // device as a sequence of ByteArrays, one per flush, as samples to train
+  // dictionaries on.
+  virtual void setCompressionStreamCapture(IODevicePtr device);
 private:
   bool m_useCompressionStream = false;
+  IODevicePtr m_compressionStreamCapture;
 protected:
+  void captureCompressionStream(ByteArray const& data);
+
   CompressionStream m_compressionStream;
   DecompressionStream m_decompressionStream;
 };
@@ -144,16 +162,35 @@ public:
 
   Maybe<PacketStats> incomingStats() const override;
   Maybe<PacketStats> outgoingStats() const override;
+
+  SocketPtr pollSocket() const override;
 private:
   TcpPacketSocket(TcpSocketPtr socket);
 
+  // Copies data onto the last buffer of the send chain, or starts a new one
+  // if it is full
+  void queueOutput(char const* data, size_t size);
+  // Large buffers are added to the send chain as they are
+  void queueOutput(ByteArray data);
+  ByteArray spareBuffer();
+  void recycleBuffer(ByteArray buffer);
+
   TcpSocketPtr m_socket;
 
   PacketStatCollector m_incomingStats;
   PacketStatCollector m_outgoingStats;
+  // Packets are written into m_packetBuffer, and with the compression stream
+  // enabled collected in m_outputBuffer until they are compressed.  Both are
+  // reused between calls.
+  DataStreamBuffer m_packetBuffer;
   ByteArray m_outputBuffer;
+  // Data waiting to be sent, in order, written to the socket with gather
+  // writes.  Sent buffers are kept to be reused.
+  Deque<ByteArray> m_sendChain;
+  size_t m_sendChainOffset;
+  List<ByteArray> m_spareBuffers;
+  List<pair<char const*, size_t>> m_sendBuffers;
   ByteArray m_inputBuffer;
-  ByteArray m_compressedOutputBuffer;
 };
 
 // Wraps a P2PSocket into a PacketSocket
@@ -1016,17 +1016,17 @@ EntityUpdateSetPacket::EntityUpdateSetPacket(ConnectionId forConnection) : forCo
 void EntityUpdateSetPacket::read(DataStream& ds) {
   ds.vuread(forConnection);
   ds.readMapContainer(deltas,
-      [](DataStream& ds, EntityId& entityId, ByteArray& delta) {
+      [](DataStream& ds, EntityId& entityId, ByteArrayConstPtr& delta) {
         ds.viread(entityId);
-        ds.read(delta);
+        delta = make_shared<ByteArray const>(ds.read<ByteArray>());
       });
 }
 
 void EntityUpdateSetPacket::write(DataStream& ds) const {
   ds.vuwrite(forConnection);
-  ds.writeMapContainer(deltas, [](DataStream& ds, EntityId const& entityId, ByteArray const& delta) {
+  ds.writeMapContainer(deltas, [](DataStream& ds, EntityId const& entityId, ByteArrayConstPtr const& delta) {
       ds.viwrite(entityId);
-      ds.write(delta);
+      ds.write(*delta);
     });
 }
 
@@ -777,7 +777,9 @@ struct EntityUpdateSetPacket : PacketBase<PacketType::EntityUpdateSet> {
   void write(DataStream& ds) const override;
 
   ConnectionId forConnection;
-  HashMap<EntityId, ByteArray> deltas;
+  // Deltas are shared, the server writes the same delta into the update set of
+  // every client that is at the same version of an entity.
+  HashMap<EntityId, ByteArrayConstPtr> deltas;
 };
 
 struct EntityDestroyPacket : PacketBase<PacketType::EntityDestroy> {
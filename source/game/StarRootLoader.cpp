@@ -13,6 +13,11 @@ Json const BaseAssetsSettings = Json::parseJson(R"JSON(
 
       "workerPoolSize" : 2,
 
+      // Relative to the storage directory, if given keeps images with
+      // directives applied to them in this file between runs.
+      "processedImageCache" : null,
+      "processedImageCacheSize" : 268435456,
+
       "pathIgnore" : [
         "/\\.",
         "/~",
@@ -72,6 +77,8 @@ R"JSON(
       "scriptInstructionLimit" : 10000000,
       "scriptProfilingEnabled" : false,
       "scriptInstructionMeasureInterval" : 10000,
+      "scriptProfileSampleInterval" : 0,
+      "scriptBytecodeCache" : true,
 
       "allowAdminCommands" : true,
       "allowAdminCommandsFromAnyone" : false,
@@ -92,6 +99,7 @@ R"JSON(
       "interactiveHighlight" : true,
 
       "monochromeLighting" : false,
+      "lightingThreads" : 0,
 
       "safe" : {
         "alwaysAllowClipboard" : false,
@@ -189,6 +197,9 @@ Root::Settings RootLoader::rootSettingsForOptions(Options const& options) const
       );
 
     rootSettings.storageDirectory = bootConfig.getString("storageDirectory");
+    if (auto processedImageCache = assetsSettings.optString("processedImageCache"))
+      rootSettings.assetsSettings.processedImageCache = File::relativeTo(rootSettings.storageDirectory, File::convertDirSeparators(*processedImageCache));
+    rootSettings.assetsSettings.processedImageCacheSize = assetsSettings.getUInt("processedImageCacheSize");
     rootSettings.logDirectory = bootConfig.optString("logDirectory");
     rootSettings.logFile = options.parameters.value("logfile").maybeFirst().orMaybe(m_defaults.logFile);
     rootSettings.logFileBackups = bootConfig.getUInt("logFileBackups", 10);
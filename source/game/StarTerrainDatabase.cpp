@@ -54,6 +54,32 @@ TerrainSelector::TerrainSelector(String type, Json config, TerrainSelectorParame
 
 TerrainSelector::~TerrainSelector() {}
 
+void TerrainSelector::getRegion(RectI const& region, float* out) const {
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    for (int x = region.xMin(); x < region.xMax(); ++x)
+      *out++ = get(x, y);
+  }
+}
+
+void TerrainSelector::getPoints(List<Vec2I> const& points, float* out) const {
+  if (points.empty())
+    return;
+
+  RectI bounds = RectI::boundBoxOfPoints(points);
+  bounds.setXMax(bounds.xMax() + 1);
+  bounds.setYMax(bounds.yMax() + 1);
+  if ((int64_t)bounds.width() * bounds.height() > (int64_t)points.size() * 2) {
+    for (size_t i = 0; i < points.size(); ++i)
+      out[i] = get(points[i][0], points[i][1]);
+    return;
+  }
+
+  List<float> values(bounds.volume());
+  getRegion(bounds, values.ptr());
+  for (size_t i = 0; i < points.size(); ++i)
+    out[i] = values[(points[i][1] - bounds.yMin()) * bounds.width() + (points[i][0] - bounds.xMin())];
+}
+
 TerrainDatabase::TerrainDatabase() {
   auto assets = Root::singleton().assets();
 
@@ -2,6 +2,7 @@
 
 #include "StarJson.hpp"
 #include "StarThread.hpp"
+#include "StarRect.hpp"
 
 namespace Star {
 
@@ -33,6 +34,17 @@ struct TerrainSelector {
   // considered solid, < 0.0 should be considered open space.
   virtual float get(int x, int y) const = 0;
 
+  // Fills out with the value of get for every point in the region, a row at a
+  // time from the bottom, so the value for (x, y) is at
+  // out[(y - region.yMin()) * region.width() + (x - region.xMin())].
+  // Selectors override this to do the work for the whole region together.
+  virtual void getRegion(RectI const& region, float* out) const;
+
+  // Fills out with the value of get for each of the given points.  Uses
+  // getRegion over the bounding box of the points when that is not too much
+  // bigger than the number of points.
+  void getPoints(List<Vec2I> const& points, float* out) const;
+
   String type;
   Json config;
   TerrainSelectorParameters parameters;
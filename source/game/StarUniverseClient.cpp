@@ -102,6 +102,7 @@ Maybe<String> UniverseClient::connect(UniverseConnection connection, bool allowA
 
   NetCompatibilityRules compatibilityRules;
   compatibilityRules.setVersion(LegacyVersion);
+  Maybe<unsigned> compressionDictionaryId;
   bool legacyServer = forceLegacy || (protocolResponsePacket->compressionMode() != PacketCompressionMode::Enabled);
   if (!legacyServer) {
     auto compressedSocket = as<CompressedPacketSocket>(&connection.packetSocket());
@@ -115,6 +116,22 @@ Maybe<String> UniverseClient::connect(UniverseConnection connection, bool allowA
 
         Logger::info("UniverseClient: Using '{}' network stream compression", NetCompressionModeNames.getRight(*compressionMode));
         compressedSocket->setCompressionStreamEnabled(compressionMode == NetCompressionMode::Zstd);
+
+        // Only accept the server's compression dictionary if we have exactly
+        // the same one
+        if (auto dictionaryInfo = protocolResponsePacket->info.opt("compressionDictionary")) {
+          String dictionaryPath = dictionaryInfo->getString("path");
+          unsigned dictionaryId = dictionaryInfo->getUInt("id");
+          if (assets->assetExists(dictionaryPath)) {
+            auto dictionary = assets->bytes(dictionaryPath);
+            if (ZstdCompression::dictionaryId(*dictionary) == dictionaryId) {
+              Logger::info("UniverseClient: Using network stream compression dictionary '{}'", dictionaryPath);
+              compressedSocket->setCompressionStreamDictionary(*dictionary);
+              compressedSocket->addDecompressionStreamDictionary(*dictionary);
+              compressionDictionaryId = dictionaryId;
+            }
+          }
+        }
       }
     } else {
       compatibilityRules.setVersion(1); // A version of 1 is OpenStarbound prior to the NetElement compatibility stuff
@@ -132,6 +149,8 @@ Maybe<String> UniverseClient::connect(UniverseConnection connection, bool allowA
     {"brand", "OpenStarbound"},
     {"openProtocolVersion", OpenProtocolVersion }
   };
+  if (compressionDictionaryId)
+    clientConnect->info = clientConnect->info.set("compressionDictionary", *compressionDictionaryId);
   connection.pushSingle(std::move(clientConnect));
   connection.sendAll(timeout);
 
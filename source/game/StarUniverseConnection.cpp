@@ -6,6 +6,10 @@
 namespace Star {
 
 static const int PacketSocketPollSleep = 1;
+// Packets sent from other threads are written immediately, so this only
+// bounds how long a worker takes to notice new connections, or pending data
+// that could not be written at the time.
+static const int PacketSocketPollTimeout = 10;
 
 UniverseConnection::UniverseConnection(PacketSocketUPtr packetSocket)
     : m_packetSocket(std::move(packetSocket)) {}
@@ -123,8 +127,8 @@ Maybe<PacketStats> UniverseConnection::outgoingStats() const {
   return m_packetSocket->outgoingStats();
 }
 
-UniverseConnectionServer::UniverseConnectionServer(PacketReceiveCallback packetReceiver, size_t numWorkerThreads)
-    : m_packetReceiver(std::move(packetReceiver)), m_shutdown(false) {
+UniverseConnectionServer::UniverseConnectionServer(PacketReceiveCallback packetReceiver, size_t numWorkerThreads, bool pollSockets)
+    : m_packetReceiver(std::move(packetReceiver)), m_connectionsVersion(0), m_shutdown(false), m_pollSockets(pollSockets) {
   if (numWorkerThreads == 0)
     m_numWorkerThreads = max<size_t>(2, std::thread::hardware_concurrency() / 4);
   else
@@ -136,23 +140,22 @@ UniverseConnectionServer::UniverseConnectionServer(PacketReceiveCallback packetR
 
   for (size_t i = 0; i < m_numWorkerThreads; ++i) {
     m_processingThreads.append(Thread::invoke(strf("UniverseConnectionServer::worker_{}", i), [this, i]() {
-      RecursiveMutexLocker connectionsLocker(m_connectionsMutex);
+      WorkerConnections worker;
+      Maybe<List<pair<ConnectionId, shared_ptr<Connection>>>> readyConnections;
       try {
         while (!m_shutdown) {
-          connectionsLocker.lock();
-          auto connections = m_connections.pairs();
-          connectionsLocker.unlock();
+          if (worker.connectionsVersion != m_connectionsVersion) {
+            updateWorkerConnections(i, worker);
+            readyConnections.reset();
+          }
 
           bool dataTransmitted = false;
-          size_t handledCount = 0;
-          for (auto& p : connections) {
-            if (p.second->workerIndex != i)
-              continue;
-
-            handledCount++;
+          for (auto& p : readyConnections ? *readyConnections : worker.connections) {
             MutexLocker connectionLocker(p.second->mutex);
-            if (!p.second->packetSocket || !p.second->packetSocket->isOpen())
+            if (!p.second->packetSocket || !p.second->packetSocket->isOpen()) {
+              updatePollSocket(worker, p.first, *p.second);
               continue;
+            }
 
             try {
               p.second->packetSocket->sendPackets(take(p.second->sendQueue));
@@ -185,15 +188,20 @@ UniverseConnectionServer::UniverseConnectionServer(PacketReceiveCallback packetR
               connectionLocker.lock();
               p.second->packetSocket->close();
             }
+
+            connectionLocker.lock();
+            updatePollSocket(worker, p.first, *p.second);
           }
-          m_workerStats[i].connectionsHandled = handledCount;
+          m_workerStats[i].connectionsHandled = worker.connections.size();
 
-          if (!dataTransmitted)
-            Thread::sleep(PacketSocketPollSleep);
+          if (dataTransmitted)
+            readyConnections.reset();
+          else
+            readyConnections = waitForActivity(i, worker);
         }
       } catch (std::exception const& e) {
         Logger::error("Exception caught in UniverseConnectionServer::worker_{}, closing assigned connections: {}", i, e.what());
-        connectionsLocker.lock();
+        RecursiveMutexLocker connectionsLocker(m_connectionsMutex);
         for (auto& p : m_connections)
           if (p.second->workerIndex == i)
             p.second->packetSocket->close();
@@ -252,6 +260,7 @@ void UniverseConnectionServer::addConnection(ConnectionId clientId, UniverseConn
   connection->lastActivityTime = Time::monotonicMilliseconds();
   connection->workerIndex = clientId % m_numWorkerThreads;
   m_connections.add(clientId, std::move(connection));
+  ++m_connectionsVersion;
 }
 
 UniverseConnection UniverseConnectionServer::removeConnection(ConnectionId clientId) {
@@ -260,6 +269,7 @@ UniverseConnection UniverseConnectionServer::removeConnection(ConnectionId clien
     throw UniverseConnectionException::format("Client '{}' does not exist in UniverseConnectionServer::removeConnection", clientId);
 
   auto conn = m_connections.take(clientId);
+  ++m_connectionsVersion;
   connectionsLocker.unlock();
   MutexLocker connectionLocker(conn->mutex);
 
@@ -294,6 +304,85 @@ void UniverseConnectionServer::sendPackets(ConnectionId clientId, List<PacketPtr
   }
 }
 
+void UniverseConnectionServer::updateWorkerConnections(size_t workerIndex, WorkerConnections& worker) {
+  RecursiveMutexLocker connectionsLocker(m_connectionsMutex);
+  worker.connectionsVersion = m_connectionsVersion;
+  worker.connections.clear();
+  for (auto const& p : m_connections) {
+    if (p.second->workerIndex == workerIndex)
+      worker.connections.append(p);
+  }
+  connectionsLocker.unlock();
+
+  if (!m_pollSockets)
+    return;
+
+  worker.pollable = true;
+  HashMap<ConnectionId, SocketPtr> pollSockets;
+  for (auto const& p : worker.connections) {
+    MutexLocker connectionLocker(p.second->mutex);
+    if (!p.second->packetSocket || !p.second->packetSocket->isOpen())
+      continue;
+
+    if (auto socket = p.second->packetSocket->pollSocket())
+      pollSockets.add(p.first, std::move(socket));
+    else
+      worker.pollable = false;
+  }
+
+  for (auto const& p : worker.pollSockets) {
+    if (pollSockets.value(p.first) != p.second)
+      worker.poller.remove(p.second);
+  }
+  worker.pollSockets = std::move(pollSockets);
+  worker.socketConnections.clear();
+  for (auto const& p : worker.connections) {
+    if (auto socket = worker.pollSockets.ptr(p.first))
+      worker.socketConnections.add(socket->get(), p);
+
+    MutexLocker connectionLocker(p.second->mutex);
+    updatePollSocket(worker, p.first, *p.second);
+  }
+}
+
+void UniverseConnectionServer::updatePollSocket(WorkerConnections& worker, ConnectionId clientId, Connection& connection) {
+  auto socket = worker.pollSockets.ptr(clientId);
+  if (!socket)
+    return;
+
+  if (connection.packetSocket && connection.packetSocket->isOpen()) {
+    bool writePending = !connection.sendQueue.empty() || connection.packetSocket->sentPacketsPending();
+    worker.poller.set(*socket, {true, writePending});
+  } else {
+    worker.poller.remove(*socket);
+  }
+}
+
+Maybe<List<pair<ConnectionId, shared_ptr<UniverseConnectionServer::Connection>>>> UniverseConnectionServer::waitForActivity(size_t workerIndex, WorkerConnections& worker) {
+  if (m_pollSockets && worker.pollable) {
+    if (worker.poller.empty()) {
+      Thread::sleep(PacketSocketPollTimeout);
+      return {};
+    }
+
+    try {
+      // On timeout, check every connection anyway.
+      if (auto result = worker.poller.wait(PacketSocketPollTimeout)) {
+        List<pair<ConnectionId, shared_ptr<Connection>>> readyConnections;
+        for (auto const& p : *result)
+          readyConnections.append(worker.socketConnections.get(p.first.get()));
+        return readyConnections;
+      }
+      return {};
+    } catch (NetworkException const& e) {
+      Logger::warn("UniverseConnectionServer::worker_{} failed to poll sockets: {}", workerIndex, outputException(e, false));
+    }
+  }
+
+  Thread::sleep(PacketSocketPollSleep);
+  return {};
+}
+
 uint64_t UniverseConnectionServer::totalPacketsProcessed() const {
   uint64_t total = 0;
   for (auto const& stats : m_workerStats)
@@ -79,7 +79,11 @@ public:
   // that client is complete.
   typedef function<void(UniverseConnectionServer*, ConnectionId, List<PacketPtr>)> PacketReceiveCallback;
 
-  UniverseConnectionServer(PacketReceiveCallback packetReceiver, size_t numWorkerThreads = 0);
+  // If pollSockets is true, idle workers wait with a SocketPoller until one of
+  // their connections can be read or written, rather than sleeping between
+  // checks.  Workers handling any connection without a pollable socket always
+  // sleep.
+  UniverseConnectionServer(PacketReceiveCallback packetReceiver, size_t numWorkerThreads = 0, bool pollSockets = true);
   ~UniverseConnectionServer();
 
   bool hasConnection(ConnectionId clientId) const;
@@ -130,15 +134,37 @@ private:
     WorkerStats& operator=(const WorkerStats&) = delete;
   };
 
+  // The connections handled by one worker, and the sockets it waits on for
+  // them.  Only rebuilt when connections are added or removed.
+  struct WorkerConnections {
+    uint64_t connectionsVersion = highest<uint64_t>();
+    List<pair<ConnectionId, shared_ptr<Connection>>> connections;
+    bool pollable = false;
+    SocketPoller poller;
+    HashMap<ConnectionId, SocketPtr> pollSockets;
+    HashMap<Socket*, pair<ConnectionId, shared_ptr<Connection>>> socketConnections;
+  };
+
+  void updateWorkerConnections(size_t workerIndex, WorkerConnections& worker);
+  // Waits on the socket for reading, and for writing only while there is data
+  // pending.  Must be called with the connection locked.
+  void updatePollSocket(WorkerConnections& worker, ConnectionId clientId, Connection& connection);
+  // Returns the connections that are ready to be read or written, or nothing
+  // if every connection should be checked.
+  Maybe<List<pair<ConnectionId, shared_ptr<Connection>>>> waitForActivity(size_t workerIndex, WorkerConnections& worker);
+
   PacketReceiveCallback const m_packetReceiver;
 
   mutable RecursiveMutex m_connectionsMutex;
   HashMap<ConnectionId, shared_ptr<Connection>> m_connections;
+  // Changes whenever a connection is added or removed
+  atomic<uint64_t> m_connectionsVersion;
 
   List<ThreadFunction<void>> m_processingThreads;
   List<WorkerStats> m_workerStats;
   atomic<bool> m_shutdown;
   size_t m_numWorkerThreads;
+  bool m_pollSockets;
 };
 
 }// namespace Star
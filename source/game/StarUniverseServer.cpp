@@ -18,6 +18,7 @@
 #include "StarTeamManager.hpp"
 #include "StarUniverseServerLuaBindings.hpp"
 #include "StarVersioningDatabase.hpp"
+#include "StarWorldServerScheduler.hpp"
 
 namespace Star {
 
@@ -85,10 +86,13 @@ UniverseServer::UniverseServer(String const& storageDir)
   m_teamManager = make_shared<TeamManager>();
   m_workerPool.start(universeConfig.getUInt("workerPoolThreads"));
 
+  if (universeConfig.optBool("useWorldScheduler").value(false))
+    m_worldScheduler = make_shared<WorldServerScheduler>(universeConfig.optUInt("worldSchedulerThreads").value(0));
+
   size_t networkWorkerThreads = universeConfig.optUInt("networkWorkerThreads").value(0);
   m_connectionServer = make_shared<UniverseConnectionServer>(
     bind(&UniverseServer::packetsReceived, this, _1, _2, _3),
-    networkWorkerThreads);
+    networkWorkerThreads, universeConfig.optBool("networkWorkerPolling").value(true));
 
   m_pause = make_shared<atomic<bool>>(false);
 
@@ -393,6 +397,17 @@ bool UniverseServer::executeForClient(ConnectionId clientId, function<void(World
   return success;
 }
 
+void UniverseServer::executeForWorlds(function<void(WorldServer*)> action) {
+  RecursiveMutexLocker locker(m_mainLock);
+  for (auto const& worldId : m_worlds.keys()) {
+    if (auto world = getWorld(worldId)) {
+      locker.unlock();
+      world->executeAction([&action](WorldServerThread*, WorldServer* worldServer) { action(worldServer); });
+      locker.lock();
+    }
+  }
+}
+
 void UniverseServer::disconnectClient(ConnectionId clientId, String const& reason) {
   RecursiveMutexLocker locker(m_mainLock);
   m_pendingDisconnections.add(clientId, reason);
@@ -1254,7 +1269,7 @@ void UniverseServer::handleWorldMessages() {
       auto& world = *worldResult;
 
       if (world) {
-        if (world->isRunning()) {
+        if (world->isWorldRunning()) {
           world->passMessages(std::move(it->second));
           it = m_pendingWorldMessages.erase(it);
         }
@@ -1297,7 +1312,7 @@ void UniverseServer::shutdownInactiveWorlds() {
       }
       locker.lock();
       clientsLocker.lock();
-      if (world->isJoined()) {
+      if (world->isWorldJoined()) {
         auto kickClients = world->clients();
         if (!kickClients.empty()) {
           Logger::info("UniverseServer: World {} shutdown, kicking {} players to their own ships", worldId, world->clients().size());
@@ -1840,6 +1855,8 @@ void UniverseServer::acceptConnection(UniverseConnection connection, Maybe<HostA
   }
 
   bool useCompressionStream = false;
+  ByteArrayConstPtr compressionDictionary;
+  unsigned compressionDictionaryId = 0;
   protocolResponse->allowed = true;
   if (!legacyClient) {
     auto compressionName = connectionSettings.getString("compression", "None");
@@ -1848,12 +1865,46 @@ void UniverseServer::acceptConnection(UniverseConnection connection, Maybe<HostA
     protocolResponse->info = JsonObject{
       {"compression", NetCompressionModeNames.getRight(compressionMode)},
       {"openProtocolVersion", OpenProtocolVersion}};
+
+    // Offer the client a trained dictionary for the compression stream, which
+    // both ends only use if the client has the same one in its assets.
+    auto dictionaryPath = connectionSettings.optString("compressionDictionary");
+    if (useCompressionStream && dictionaryPath) {
+      try {
+        compressionDictionary = assets->bytes(*dictionaryPath);
+        compressionDictionaryId = ZstdCompression::dictionaryId(*compressionDictionary);
+      } catch (StarException const& e) {
+        Logger::error("UniverseServer: Could not load compression dictionary '{}': {}", *dictionaryPath, outputException(e, false));
+      }
+      if (compressionDictionaryId != 0) {
+        protocolResponse->info = protocolResponse->info.set("compressionDictionary", JsonObject{
+          {"path", *dictionaryPath},
+          {"id", compressionDictionaryId}});
+      } else {
+        compressionDictionary.reset();
+      }
+    }
   }
   connection.pushSingle(protocolResponse);
   connection.sendAll(clientWaitLimit);
 
-  if (auto compressedSocket = as<CompressedPacketSocket>(&connection.packetSocket()))
+  auto compressedSocket = as<CompressedPacketSocket>(&connection.packetSocket());
+  if (compressedSocket) {
     compressedSocket->setCompressionStreamEnabled(useCompressionStream);
+    if (compressionDictionary)
+      compressedSocket->addDecompressionStreamDictionary(*compressionDictionary);
+
+    auto captureDirectory = connectionSettings.optString("compressionCaptureDirectory");
+    if (useCompressionStream && captureDirectory) {
+      try {
+        File::makeDirectoryRecursive(*captureDirectory);
+        auto capturePath = File::relativeTo(*captureDirectory, strf("{}.capture", Uuid().hex()));
+        compressedSocket->setCompressionStreamCapture(File::open(capturePath, IOMode::Write | IOMode::Truncate));
+      } catch (StarException const& e) {
+        Logger::error("UniverseServer: Could not open compression stream capture: {}", outputException(e, false));
+      }
+    }
+  }
 
   String remoteAddressString = remoteAddress ? toString(*remoteAddress) : "local";
   Logger::info("UniverseServer: Awaiting connection info from {} ({} client)", remoteAddressString, legacyClient ? "vanilla" : "custom");
@@ -1868,6 +1919,9 @@ void UniverseServer::acceptConnection(UniverseConnection connection, Maybe<HostA
     return;
   }
 
+  if (compressedSocket && compressionDictionary && clientConnect->info.getUInt("compressionDictionary", 0) == compressionDictionaryId)
+    compressedSocket->setCompressionStreamDictionary(*compressionDictionary);
+
   bool administrator = false;
   String accountString = !clientConnect->account.empty() ? strf("'{}'", clientConnect->account) : "<anonymous>";
 
@@ -2432,6 +2486,7 @@ Maybe<UniverseServer::WorldServerPromise> UniverseServer::shipWorldPromise(
 
     auto shipWorldThread = make_shared<WorldServerThread>(shipWorld, ClientShipWorldId(clientShipWorldId));
     shipWorldThread->setPause(m_pause);
+    shipWorldThread->setScheduler(m_worldScheduler);
     clientContext->updateShipChunks(shipWorldThread->readChunks());
     shipWorldThread->start();
     shipWorldThread->setUpdateAction(bind(&UniverseServer::worldUpdated, this, _1));
@@ -2474,6 +2529,7 @@ Maybe<UniverseServer::WorldServerPromise> UniverseServer::celestialWorldPromise(
 
     auto worldThread = make_shared<WorldServerThread>(worldServer, celestialWorldId);
     worldThread->setPause(m_pause);
+    worldThread->setScheduler(m_worldScheduler);
     worldThread->start();
     worldThread->setUpdateAction(bind(&UniverseServer::worldUpdated, this, _1));
 
@@ -2595,6 +2651,7 @@ Maybe<UniverseServer::WorldServerPromise> UniverseServer::instanceWorldPromise(I
 
     auto worldThread = make_shared<WorldServerThread>(worldServer, instanceWorldId);
     worldThread->setPause(m_pause);
+    worldThread->setScheduler(m_worldScheduler);
     worldThread->start();
     worldThread->setUpdateAction(bind(&UniverseServer::worldUpdated, this, _1));
 
@@ -2629,6 +2686,7 @@ Maybe<UniverseServer::WorldServerPromise> UniverseServer::customWorldPromise(Cus
 
     auto worldThread = make_shared<WorldServerThread>(worldServer, customWorldId);
     worldThread->setPause(m_pause);
+    worldThread->setScheduler(m_worldScheduler);
     worldThread->start();
     worldThread->setUpdateAction(bind(&UniverseServer::worldUpdated, this, _1));
 
@@ -2684,6 +2742,7 @@ Maybe<UniverseServer::WorldServerPromise> UniverseServer::clientCustomWorldPromi
 
       auto worldThread = make_shared<WorldServerThread>(worldServer, clientCustomWorldId);
       worldThread->setPause(m_pause);
+      worldThread->setScheduler(m_worldScheduler);
       clientContext->updateCustomWorldChunks(clientCustomWorldId.name, worldThread->readChunks());
       clientContext->setCustomWorldActive(clientCustomWorldId.name, true);
       worldThread->start();
@@ -99,6 +99,8 @@ public:
   // Returns true if function was called, false if client was not found or in
   // an invalid connection state.
   bool executeForClient(ConnectionId clientId, function<void(WorldServer*, PlayerPtr)> action);
+  // Executes the given function on every active world in a thread safe way.
+  void executeForWorlds(function<void(WorldServer*)> action);
   void disconnectClient(ConnectionId clientId, String const& reason);
   void banUser(ConnectionId clientId, String const& reason, pair<bool, bool> banType, Maybe<int> timeout);
   bool unbanIp(String const& addressString);
@@ -247,6 +249,8 @@ private:
   ClockPtr m_universeClock;
   UniverseSettingsPtr m_universeSettings;
   WorkerPool m_workerPool;
+  // Shared world tick scheduler, if unset every world runs in its own thread.
+  WorldServerSchedulerPtr m_worldScheduler;
 
   int64_t m_storageTriggerDeadline;
   int64_t m_clearBrokenWorldsDeadline;
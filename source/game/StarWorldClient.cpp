@@ -54,16 +54,6 @@ WorldClient::WorldClient(PlayerPtr mainPlayer, LuaRootPtr luaRoot) {
 
   centerClientWindowOnPlayer(Vec2U(100, 100));
 
-  m_collisionGenerator.init([this](int x, int y) {
-    if (!m_predictedTiles.empty()) {
-      if (auto p = m_predictedTiles.ptr({x, y})) {
-        if (p->collision)
-          return *p->collision;
-      }
-    }
-    return m_tileArray->tile({x, y}).collision;
-  });
-
   m_modifiedTilePredictionTimeout = (int)round(m_clientConfig.getFloat("modifiedTilePredictionTimeout") / GlobalTimestep);
 
   m_latency = 0.0;
@@ -281,7 +271,7 @@ void WorldClient::forEachCollisionBlock(RectI const& region, function<void(Colli
     return;
 
   const_cast<WorldClient*>(this)->freshenCollision(region);
-  m_tileArray->tileEach(region, [iterator](Vec2I const& pos, ClientTile const& tile) {
+  m_tileArray->tileEach(region, [&iterator](Vec2I const& pos, ClientTile const& tile) {
       if (tile.getCollision() == CollisionKind::Null) {
         iterator(CollisionBlock::nullBlock(pos));
       } else {
@@ -851,7 +841,8 @@ void WorldClient::handleIncomingPackets(List<PacketPtr> const& packets) {
           EntityId entityId = entity->entityId();
           if (connectionForEntity(entityId) == entityUpdateSet->forConnection) {
             starAssert(entity->isSlave());
-            entity->readNetState(entityUpdateSet->deltas.value(entityId), interpolationLeadTime, m_clientState.netCompatibilityRules());
+            auto delta = entityUpdateSet->deltas.value(entityId);
+            entity->readNetState(delta ? *delta : ByteArray(), interpolationLeadTime, m_clientState.netCompatibilityRules());
           }
         });
 
@@ -1182,7 +1173,7 @@ void WorldClient::update(float dt) {
 
   List<EntityId> toRemove;
   List<EntityId> clientPresenceEntities;
-  m_entityMap->updateAllEntities([&](EntityPtr const& entity) {
+  m_entityMap->updateAllEntitiesByType([&](EntityPtr const& entity) {
       try { entity->update(dt, m_currentStep); }
       catch (StarException const& e) {
         if (entity->isMaster()) // this is YOUR problem!!
@@ -1203,8 +1194,6 @@ void WorldClient::update(float dt) {
         toRemove.append(entity->entityId());
       if (entity->isMaster() && entity->clientEntityMode() == ClientEntityMode::ClientPresenceMaster)
         clientPresenceEntities.append(entity->entityId());
-    }, [](EntityPtr const& a, EntityPtr const& b) {
-      return a->entityType() < b->entityType();
     });
 
   m_clientState.setPlayer(m_mainPlayer->entityId());
@@ -1529,7 +1518,7 @@ void WorldClient::queueUpdatePackets(bool sendEntityUpdates) {
         if (auto version = m_masterEntitiesNetVersion.ptr(entity->entityId())) {
           auto updateAndVersion = entity->writeNetState(*version, netRules);
           if (!updateAndVersion.first.empty())
-            entityUpdateSet->deltas[entity->entityId()] = std::move(updateAndVersion.first);
+            entityUpdateSet->deltas[entity->entityId()] = make_shared<ByteArray const>(std::move(updateAndVersion.first));
           *version = updateAndVersion.second;
         }
       });
@@ -1744,6 +1733,11 @@ void WorldClient::lightingCalc() {
   bool monochrome = configuration->get("monochromeLighting").toBool();
   m_lightingCalculator.setParameters(root.assets()->json("/lighting.config:lighting").set("pointAdditive", newLighting));
   m_lightingCalculator.setMonochrome(monochrome);
+  // 0 leaves half of the processors for the rest of the client
+  unsigned lightingThreads = configuration->get("lightingThreads").optUInt().value(0);
+  if (lightingThreads == 0)
+    lightingThreads = Thread::numberOfProcessors() / 2;
+  m_lightingCalculator.setThreadCount(lightingThreads);
   m_lightingCalculator.begin(lightRange);
   lightingTileGather();
 
@@ -2087,44 +2081,22 @@ void WorldClient::dirtyCollision(RectI const& region) {
   if (!inWorld())
     return;
 
-  auto dirtyRegion = region.padded(CollisionGenerator::BlockInfluenceRadius);
-  for (int x = dirtyRegion.xMin(); x < dirtyRegion.xMax(); ++x) {
-    for (int y = dirtyRegion.yMin(); y < dirtyRegion.yMax(); ++y) {
-      if (auto tile = m_tileArray->modifyTile({x, y}))
-        tile->collisionCacheDirty = true;
-    }
-  }
+  WorldImpl::dirtyCollision(m_tileArray, region);
 }
 
 void WorldClient::freshenCollision(RectI const& region) {
   if (!inWorld())
     return;
 
-  RectI freshenRegion = RectI::null();
-  for (int x = region.xMin(); x < region.xMax(); ++x) {
-    for (int y = region.yMin(); y < region.yMax(); ++y) {
-      if (auto tile = m_tileArray->modifyTile({x, y})) {
-        if (tile->collisionCacheDirty)
-          freshenRegion.combine(RectI(x, y, x + 1, y + 1));
-      }
-    }
-  }
-
-  if (!freshenRegion.isNull()) {
-    for (int x = freshenRegion.xMin(); x < freshenRegion.xMax(); ++x) {
-      for (int y = freshenRegion.yMin(); y < freshenRegion.yMax(); ++y) {
-        if (auto tile = m_tileArray->modifyTile({x, y})) {
-          tile->collisionCacheDirty = false;
-          tile->collisionCache.clear();
+  WorldImpl::freshenCollision(m_tileArray, m_collisionGenerator, region, [this](int x, int y) {
+      if (!m_predictedTiles.empty()) {
+        if (auto p = m_predictedTiles.ptr({x, y})) {
+          if (p->collision)
+            return *p->collision;
         }
       }
-    }
-
-    for (auto& collisionBlock : m_collisionGenerator.getBlocks(freshenRegion)) {
-      if (auto tile = m_tileArray->modifyTile(collisionBlock.space))
-        tile->collisionCache.append(std::move(collisionBlock));
-    }
-  }
+      return m_tileArray->tile({x, y}).collision;
+    });
 }
 
 float WorldClient::lightLevel(Vec2F const& pos) const {
@@ -665,6 +665,11 @@ EntityPtr SpawnerWorld::getEntity(EntityId entityId) const {
 
 WorldGenerator::WorldGenerator(WorldServer* server) : m_worldServer(server) {
   m_microDungeonFactory = make_shared<MicroDungeonFactory>();
+  m_pregenerationTemplateRevision = 0;
+}
+
+WorldGenerator::~WorldGenerator() {
+  cancelPregeneration();
 }
 
 void WorldGenerator::generateSectorLevel(WorldStorage* worldStorage, Sector const& sector, SectorGenerationLevel generationLevel) {
@@ -730,6 +735,59 @@ RpcPromise<Vec2I> WorldGenerator::enqueuePlacement(List<BiomeItemDistribution> d
   return promise.first;
 }
 
+void WorldGenerator::pregenerateSectors(WorldStorage* worldStorage, List<Sector> const& sectors) {
+  if (!checkPregenerationTemplate()) {
+    m_pregenerationTemplate = m_worldServer->worldTemplate();
+    m_pregenerationTemplateRevision = m_pregenerationTemplate->revision();
+    m_worldTemplateCopies = make_shared<WorldTemplateCopies>();
+    m_worldTemplateCopies->store = m_pregenerationTemplate->store();
+  }
+
+  // Cancel work for sectors that are no longer going to be generated, and
+  // forget biome items of sectors that were unloaded before being finalized.
+  HashSet<Sector> pregenerate = HashSet<Sector>::from(sectors);
+  eraseWhere(m_pregeneratedTiles, [&pregenerate](auto const& p) {
+      if (pregenerate.contains(p.first))
+        return false;
+      p.second.claimed->store(true);
+      return true;
+    });
+  eraseWhere(m_pregeneratedBiomeItems, [worldStorage](auto const& p) {
+      return worldStorage->sectorLoadLevel(p.first) == SectorLoadLevel::None;
+    });
+
+  for (auto const& sector : sectors) {
+    if (m_pregeneratedTiles.contains(sector))
+      continue;
+
+    RectI sectorRegion = worldStorage->tileArray()->sectorRegion(sector);
+    auto claimed = make_shared<atomic<bool>>(false);
+    auto promise = pregenerationWorkerPool().addProducer<PregeneratedSector>(
+        [copies = m_worldTemplateCopies, claimed, sectorRegion]() -> PregeneratedSector {
+          if (claimed->exchange(true))
+            return {};
+
+          WorldTemplatePtr worldTemplate;
+          {
+            MutexLocker locker(copies->mutex);
+            if (!copies->idle.empty())
+              worldTemplate = copies->idle.takeLast();
+          }
+          if (!worldTemplate)
+            worldTemplate = make_shared<WorldTemplate>(copies->store);
+
+          PregeneratedSector pregenerated;
+          pregenerated.blockInfos = worldTemplate->blockInfoRegion(sectorRegion);
+          pregenerated.biomeItems = potentialBiomePlacements(*worldTemplate, sectorRegion);
+
+          MutexLocker locker(copies->mutex);
+          copies->idle.append(std::move(worldTemplate));
+          return pregenerated;
+        });
+    m_pregeneratedTiles.add(sector, PregenerationWork{std::move(claimed), std::move(promise)});
+  }
+}
+
 void WorldGenerator::replaceBiomeBlocks(ServerTile* tile) {
   auto materialDatabase = Root::singleton().materialDatabase();
   MaterialId oldForeground = tile->foreground;
@@ -781,12 +839,60 @@ void WorldGenerator::replaceBiomeBlocks(ServerTile* tile) {
   tile->updateCollision(biomeForegroundCollision(materialDatabase, oldForeground, tile->foreground, tile->collision));
 }
 
+WorkerPool& WorldGenerator::pregenerationWorkerPool() {
+  static WorkerPool pool("WorldGenerator::pregeneration", Root::singleton().assets()->json("/worldstorage.config")
+      .optUInt("generationWorkerThreads").value(max(Thread::numberOfProcessors() / 2, 1u)));
+  return pool;
+}
+
+bool WorldGenerator::checkPregenerationTemplate() {
+  auto const& worldTemplate = m_worldServer->worldTemplate();
+  if (m_pregenerationTemplate == worldTemplate && m_pregenerationTemplateRevision == worldTemplate->revision())
+    return true;
+
+  cancelPregeneration();
+  m_pregenerationTemplate.reset();
+  m_worldTemplateCopies.reset();
+  m_pregeneratedTiles.clear();
+  m_pregeneratedBiomeItems.clear();
+  return false;
+}
+
+void WorldGenerator::cancelPregeneration() {
+  for (auto const& p : m_pregeneratedTiles)
+    p.second.claimed->store(true);
+}
+
+List<BiomeItemPlacement> WorldGenerator::potentialBiomePlacements(WorldTemplate const& worldTemplate, RectI const& region) {
+  List<BiomeItemPlacement> placements;
+  for (int x = region.xMin(); x < region.xMax(); ++x) {
+    for (int y = region.yMin(); y < region.yMax(); ++y)
+      placements.appendAll(worldTemplate.validBiomeItems(x, y, worldTemplate.potentialBiomeItemsAt(x, y)));
+  }
+  return placements;
+}
+
 void WorldGenerator::prepareTiles(WorldStorage* worldStorage, ServerTileSectorArray::Sector const& sector) {
   auto materialDatabase = Root::singleton().materialDatabase();
   auto planet = m_worldServer->worldTemplate();
   // Generate sector.
   auto tileArray = worldStorage->tileArray();
   RectI sectorRegion = tileArray->sectorRegion(sector);
+  List<WorldTemplate::BlockInfo> blockInfos;
+  // Pregeneration work that has not been started is cancelled and done here
+  // instead, work that is already running is waited on, as it would take no
+  // longer than doing it again.
+  Maybe<PregenerationWork> pregenerated;
+  if (checkPregenerationTemplate())
+    pregenerated = m_pregeneratedTiles.maybeTake(sector);
+  if (pregenerated && pregenerated->claimed->exchange(true)) {
+    auto& result = pregenerated->promise.get();
+    blockInfos = std::move(result.blockInfos);
+    m_pregeneratedBiomeItems[sector] = std::move(result.biomeItems);
+    planet->cacheBlockInfoRegion(sectorRegion, blockInfos);
+  } else {
+    blockInfos = planet->blockInfoRegion(sectorRegion);
+  }
   for (int x = sectorRegion.xMin(); x < sectorRegion.xMax(); ++x) {
     for (int y = sectorRegion.yMin(); y < sectorRegion.yMax(); ++y) {
       Vec2I pos(x, y);
@@ -795,7 +901,7 @@ void WorldGenerator::prepareTiles(WorldStorage* worldStorage, ServerTileSectorAr
       if (!tile)
         continue;
 
-      auto blockInfo = planet->blockInfo(pos[0], pos[1]);
+      auto const& blockInfo = blockInfos[(y - sectorRegion.yMin()) * sectorRegion.width() + (x - sectorRegion.xMin())];
 
       tile->blockBiomeIndex = blockInfo.blockBiomeIndex;
       tile->environmentBiomeIndex = blockInfo.environmentBiomeIndex;
@@ -1058,16 +1164,16 @@ void WorldGenerator::prepareSector(WorldStorage* worldStorage, ServerTileSectorA
     }
   }
 
+  Maybe<List<BiomeItemPlacement>> potentialPlacements;
+  if (checkPregenerationTemplate())
+    potentialPlacements = m_pregeneratedBiomeItems.maybeTake(sector);
+  if (!potentialPlacements)
+    potentialPlacements = potentialBiomePlacements(*planet, sectorTiles);
+
   List<BiomeItemPlacement> placementQueue;
-  for (int x = sectorTiles.xMin(); x < sectorTiles.xMax(); ++x) {
-    for (int y = sectorTiles.yMin(); y < sectorTiles.yMax(); ++y) {
-      auto tile = tileArray->tile(Vec2I(x, y));
-      if (tile.dungeonId == NoDungeonId) {
-        auto potential = m_worldServer->worldTemplate()->potentialBiomeItemsAt(x, y);
-        for (auto const& placement : m_worldServer->worldTemplate()->validBiomeItems(x, y, potential))
-          placementQueue.append(placement);
-      }
-    }
+  for (auto& placement : *potentialPlacements) {
+    if (tileArray->tile(placement.position).dungeonId == NoDungeonId)
+      placementQueue.append(std::move(placement));
   }
 
   sort(placementQueue);
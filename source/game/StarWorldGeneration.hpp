@@ -7,6 +7,7 @@
 #include "StarMicroDungeon.hpp"
 #include "StarCellularLiquid.hpp"
 #include "StarBiomePlacement.hpp"
+#include "StarWorldTemplate.hpp"
 
 namespace Star {
 
@@ -115,6 +116,7 @@ private:
 class WorldGenerator : public WorldGeneratorFacade {
 public:
   WorldGenerator(WorldServer* server);
+  ~WorldGenerator();
 
   void generateSectorLevel(WorldStorage* worldStorage, Sector const& sector, SectorGenerationLevel generationLevel) override;
   void sectorLoadLevelChanged(WorldStorage* worldStorage, Sector const& sector, SectorLoadLevel loadLevel) override;
@@ -124,6 +126,7 @@ public:
   bool entityKeepAlive(WorldStorage* worldStorage, EntityPtr const& entity) const override;
   bool entityPersistent(WorldStorage* worldStorage, EntityPtr const& entity) const override;
   RpcPromise<Vec2I> enqueuePlacement(List<BiomeItemDistribution> distributions, Maybe<DungeonId> id) override;
+  void pregenerateSectors(WorldStorage* worldStorage, List<Sector> const& sectors) override;
 
   void replaceBiomeBlocks(ServerTile* tile);
 
@@ -135,6 +138,44 @@ private:
     bool fulfilled;
   };
 
+  // Copies of the world template for calculating block info on worker
+  // threads, as the world template caches are not thread safe.  Idle copies
+  // are reused by later work.
+  struct WorldTemplateCopies {
+    Json store;
+    Mutex mutex;
+    List<WorldTemplatePtr> idle;
+  };
+
+  // Everything about a never generated sector that only depends on the world
+  // template.
+  struct PregeneratedSector {
+    List<WorldTemplate::BlockInfo> blockInfos;
+    // Biome items that would be placed in the sector wherever there is no
+    // dungeon, as in prepareSector.
+    List<BiomeItemPlacement> biomeItems;
+  };
+
+  // Whichever of the worker and the world thread sets 'claimed' first does
+  // the work, so queued work is cancelled and running work is waited on.
+  struct PregenerationWork {
+    shared_ptr<atomic<bool>> claimed;
+    WorkerPoolPromise<PregeneratedSector> promise;
+  };
+
+  // Shared between all WorldGenerator instances.
+  static WorkerPool& pregenerationWorkerPool();
+
+  // Drops pregenerated tiles if the world template has changed since they
+  // were started, and returns whether pregenerated tiles can be used.
+  bool checkPregenerationTemplate();
+  // Cancels pregeneration work that has not started yet.
+  void cancelPregeneration();
+
+  // Every biome item placement in the region that the world template allows,
+  // before excluding dungeon tiles.
+  static List<BiomeItemPlacement> potentialBiomePlacements(WorldTemplate const& worldTemplate, RectI const& region);
+
   void prepareTiles(WorldStorage* worldStorage, Sector const& sector);
   void generateMicroDungeons(WorldStorage* worldStorage, Sector const& sector);
   void generateCaveLiquid(WorldStorage* worldStorage, Sector const& sector);
@@ -156,6 +197,14 @@ private:
   WorldServer* m_worldServer;
   MicroDungeonFactoryPtr m_microDungeonFactory;
   List<QueuedPlacement> m_queuedPlacements;
+
+  WorldTemplatePtr m_pregenerationTemplate;
+  uint64_t m_pregenerationTemplateRevision;
+  shared_ptr<WorldTemplateCopies> m_worldTemplateCopies;
+  // Work for the BaseTiles generation level of never generated sectors
+  HashMap<Sector, PregenerationWork> m_pregeneratedTiles;
+  // Biome items of pregenerated sectors, kept until their Finalize level
+  HashMap<Sector, List<BiomeItemPlacement>> m_pregeneratedBiomeItems;
 };
 
 }
@@ -29,6 +29,20 @@ namespace WorldImpl {
   template <typename TileSectorArray>
   bool rectTileCollision(shared_ptr<TileSectorArray> const& tileSectorArray, RectI const& region, bool solidCollision);
 
+  // Dirty collision is regenerated in chunks of this size, so that dirty tiles
+  // far apart in one query region do not regenerate every tile between them.
+  int const CollisionChunkSize = 32;
+
+  // Marks the cached collision of every tile whose collision geometry can be
+  // changed by the tiles in the given region as dirty.
+  template <typename TileSectorArray>
+  void dirtyCollision(shared_ptr<TileSectorArray> const& tileSectorArray, RectI const& region);
+  // Regenerates the cached collision of every dirty tile in the given region,
+  // using the given accessor for CollisionGenerator::getBlocks.
+  template <typename TileSectorArray, typename CollisionKindAccessor>
+  void freshenCollision(shared_ptr<TileSectorArray> const& tileSectorArray, CollisionGenerator& collisionGenerator,
+      RectI region, CollisionKindAccessor&& accessor);
+
   template <typename TileSectorArray>
   bool lineTileCollision(WorldGeometry const& worldGeometry, shared_ptr<TileSectorArray> const& tileSectorArray, Vec2F const& begin, Vec2F const& end, CollisionSet const& collisionSet);
 
@@ -109,6 +123,58 @@ namespace WorldImpl {
       });
   }
 
+  template <typename TileSectorArray>
+  void dirtyCollision(shared_ptr<TileSectorArray> const& tileSectorArray, RectI const& region) {
+    tileSectorArray->tileEvalColumns(region.padded(CollisionGenerator::BlockInfluenceRadius),
+        [](Vec2I const&, typename TileSectorArray::Tile* column, size_t columnSize) {
+          for (size_t i = 0; i < columnSize; ++i)
+            column[i].collisionCacheDirty = true;
+        });
+  }
+
+  template <typename TileSectorArray, typename CollisionKindAccessor>
+  void freshenCollision(shared_ptr<TileSectorArray> const& tileSectorArray, CollisionGenerator& collisionGenerator,
+      RectI region, CollisionKindAccessor&& accessor) {
+    if (region.isEmpty())
+      return;
+
+    // Regions at least as wide as the world are evaluated as exactly the width
+    // of the world starting at 0, so chunk them the same way.
+    int worldWidth = tileSectorArray->size()[0];
+    if (region.width() >= worldWidth)
+      region = RectI(0, region.yMin(), worldWidth, region.yMax());
+
+    // Find the bounds of the dirty tiles in each chunk of the region
+    Vec2I chunks = (region.size() + Vec2I::filled(CollisionChunkSize - 1)) / CollisionChunkSize;
+    List<RectI> dirtyRegions(chunks[0] * chunks[1], RectI::null());
+    tileSectorArray->tileEvalColumns(region, [&](Vec2I const& pos, typename TileSectorArray::Tile* column, size_t columnSize) {
+        for (size_t i = 0; i < columnSize; ++i) {
+          if (column[i].collisionCacheDirty) {
+            Vec2I tilePos(pos[0], pos[1] + (int)i);
+            Vec2I chunk = (tilePos - region.min()) / CollisionChunkSize;
+            dirtyRegions[chunk[0] * chunks[1] + chunk[1]].combine(RectI::withSize(tilePos, {1, 1}));
+          }
+        }
+      });
+
+    for (auto const& dirtyRegion : dirtyRegions) {
+      if (dirtyRegion.isNull())
+        continue;
+
+      tileSectorArray->tileEvalColumns(dirtyRegion, [](Vec2I const&, typename TileSectorArray::Tile* column, size_t columnSize) {
+          for (size_t i = 0; i < columnSize; ++i) {
+            column[i].collisionCacheDirty = false;
+            column[i].collisionCache.clear();
+          }
+        });
+
+      for (auto& collisionBlock : collisionGenerator.getBlocks(dirtyRegion, accessor)) {
+        if (auto tile = tileSectorArray->modifyTile(collisionBlock.space))
+          tile->collisionCache.append(std::move(collisionBlock));
+      }
+    }
+  }
+
   template <typename TileSectorArray>
   bool lineTileCollision(WorldGeometry const& worldGeometry, shared_ptr<TileSectorArray> const& tileSectorArray,
       Vec2F const& begin, Vec2F const& end, CollisionSet const& collisionSet) {
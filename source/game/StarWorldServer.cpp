@@ -469,7 +469,8 @@ void WorldServer::handleIncomingPackets(ConnectionId clientId, List<PacketPtr> c
           EntityId entityId = entity->entityId();
           if (connectionForEntity(entityId) == clientId) {
             starAssert(entity->isSlave());
-            entity->readNetState(entityUpdateSet->deltas.value(entityId), interpolationLeadTime, clientInfo->clientState.netCompatibilityRules());
+            auto delta = entityUpdateSet->deltas.value(entityId);
+            entity->readNetState(delta ? *delta : ByteArray(), interpolationLeadTime, clientInfo->clientState.netCompatibilityRules());
           }
         });
       clientInfo->pendingForward = true;
@@ -515,7 +516,12 @@ void WorldServer::handleIncomingPackets(ConnectionId clientId, List<PacketPtr> c
         clientInfo->outgoingPackets.append(make_shared<EntityMessageResponsePacket>(makeLeft("Unknown entity"), entityMessagePacket->uuid));
       } else {
         if (entity->isMaster()) {
+          bool profileScripts = m_luaRoot->profileSampleInterval() != 0;
+          if (profileScripts)
+            m_luaRoot->setProfileCategory(EntityTypeNames.getRight(entity->entityType()));
           auto response = entity->receiveMessage(clientId, entityMessagePacket->message, entityMessagePacket->args);
+          if (profileScripts)
+            m_luaRoot->setProfileCategory("world");
           if (response)
             clientInfo->outgoingPackets.append(make_shared<EntityMessageResponsePacket>(makeRight(response.take()), entityMessagePacket->uuid));
           else
@@ -643,8 +649,13 @@ void WorldServer::update(float dt) {
   if (doBreakChecks)
     m_needsGlobalBreakCheck = false;
 
+  // Only look up entity type names for the script profile while it is being
+  // sampled.
+  bool profileScripts = m_luaRoot->profileSampleInterval() != 0;
   List<EntityId> toRemove;
-  m_entityMap->updateAllEntities([&](EntityPtr const& entity) {
+  m_entityMap->updateAllEntitiesByType([&](EntityPtr const& entity) {
+      if (profileScripts)
+        m_luaRoot->setProfileCategory(EntityTypeNames.getRight(entity->entityType()));
       entity->update(dt, m_currentStep);
 
       if (auto tileEntity = as<TileEntity>(entity)) {
@@ -658,9 +669,9 @@ void WorldServer::update(float dt) {
 
       if (entity->shouldDestroy() && entity->entityMode() == EntityMode::Master)
         toRemove.append(entity->entityId());
-    }, [](EntityPtr const& a, EntityPtr const& b) {
-      return a->entityType() < b->entityType();
     });
+  if (profileScripts)
+    m_luaRoot->setProfileCategory("world");
 
   for (auto& pair : m_scriptContexts)
     pair.second->update(pair.second->updateDt(dt));
@@ -719,12 +730,15 @@ void WorldServer::update(float dt) {
     removeEntity(entityId, true);
 
   bool sendRemoteUpdates = m_entityUpdateTimer.wrapTick(dt);
+  if (sendRemoteUpdates)
+    ++m_entityUpdateCount;
   for (auto const& pair : m_clientInfo) {
     for (auto const& monitoredRegion : pair.second->monitoringRegions(m_entityMap))
       signalRegion(monitoredRegion.padded(jsonToVec2I(m_serverConfig.get("playerActiveRegionPad"))));
     queueUpdatePackets(pair.first, sendRemoteUpdates);
   }
   m_netStateCache.clear();
+  m_entityCreateCache.clear();
 
   for (auto& pair : m_clientInfo)
     pair.second->pendingForward = false;
@@ -734,7 +748,9 @@ void WorldServer::update(float dt) {
   LogMap::set(strf("server_{}_entities", m_worldId), strf("{} in {} sectors", m_entityMap->size(), m_tileArray->loadedSectorCount()));
   LogMap::set(strf("server_{}_time", m_worldId), strf("age = {:4.2f}, day = {:4.2f}/{:4.2f}s", epochTime(), timeOfDay(), dayLength()));
   LogMap::set(strf("server_{}_active_liquid", m_worldId), m_liquidEngine->activeCells());
+  LogMap::set(strf("server_{}_sleeping_liquid", m_worldId), m_liquidEngine->sleepingCells());
   LogMap::set(strf("server_{}_lua_mem", m_worldId), m_luaRoot->luaMemoryUsage());
+  m_luaRoot->logSampledProfile(strf("server_{}_lua_profile", m_worldId), 3);
 }
 
 WorldGeometry WorldServer::geometry() const {
@@ -826,7 +842,7 @@ CollisionKind WorldServer::tileCollisionKind(Vec2I const& pos) const {
 
 void WorldServer::forEachCollisionBlock(RectI const& region, function<void(CollisionBlock const&)> const& iterator) const {
   const_cast<WorldServer*>(this)->freshenCollision(region);
-  m_tileArray->tileEach(region, [iterator](Vec2I const& pos, ServerTile const& tile) {
+  m_tileArray->tileEach(region, [&iterator](Vec2I const& pos, ServerTile const& tile) {
       if (tile.getCollision() == CollisionKind::Null) {
         iterator(CollisionBlock::nullBlock(pos));
       } else {
@@ -1421,13 +1437,26 @@ void WorldServer::init(bool firstTime) {
 
   m_entityMessageResponses = {};
 
-  m_collisionGenerator.init([=](int x, int y) {
-      return m_tileArray->tile({x, y}).getCollision();
-    });
-
   m_entityUpdateTimer = GameTimer(m_serverConfig.query("interpolationSettings.normal").getFloat("entityUpdateDelta") / 60.f);
   m_tileEntityBreakCheckTimer = GameTimer(m_serverConfig.getFloat("tileEntityBreakCheckInterval"));
 
+  auto readEntityUpdateTiers = [](Json const& config) {
+    EntityUpdateTiers tiers;
+    for (auto const& tier : config.iterateArray())
+      tiers.append({tier.getFloat(0), max<unsigned>(tier.getUInt(1), 1)});
+    sort(tiers);
+    return tiers;
+  };
+  m_defaultEntityUpdateTiers.clear();
+  m_entityUpdateTiers.clear();
+  for (auto const& pair : m_serverConfig.getObject("entityUpdateTiers", {})) {
+    if (pair.first == "default")
+      m_defaultEntityUpdateTiers = readEntityUpdateTiers(pair.second);
+    else
+      m_entityUpdateTiers[EntityTypeNames.getLeft(pair.first)] = readEntityUpdateTiers(pair.second);
+  }
+  m_entityUpdateCount = 0;
+
   m_liquidEngine = make_shared<LiquidCellEngine<LiquidId>>(liquidsDatabase->liquidEngineParameters(), make_shared<LiquidWorld>(this));
   for (auto liquidSettings : liquidsDatabase->allLiquidSettings())
     m_liquidEngine->setLiquidTickDelta(liquidSettings->id, liquidSettings->tickDelta);
@@ -1766,8 +1795,11 @@ bool WorldServer::signalRegion(RectI const& region) {
   return true;
 }
 
-void WorldServer::generateRegion(RectI const& region) {
-  for (auto sector : m_worldStorage->sectorsForRegion(region))
+void WorldServer::generateRegion(RectI const& region, bool pregenerate) {
+  auto sectors = m_worldStorage->sectorsForRegion(region);
+  if (pregenerate)
+    m_worldStorage->pregenerateSectors(sectors);
+  for (auto sector : sectors)
     m_worldStorage->activateSector(sector);
 }
 
@@ -2008,29 +2040,44 @@ void WorldServer::queueUpdatePackets(ConnectionId clientId, bool sendRemoteUpdat
       updateSetPackets.add(p.first, make_shared<EntityUpdateSetPacket>(p.first));
   }
 
+  // Local clients have every update anyway, so they are never thinned out
+  RectF window = RectF(clientInfo->clientState.window());
+  bool tieredUpdates = !clientInfo->local;
+
   for (auto const& monitoredEntity : monitoredEntities) {
     EntityId entityId = monitoredEntity->entityId();
     ConnectionId connectionId = connectionForEntity(entityId);
     if (connectionId != clientId) {
       auto netRules = clientInfo->clientState.netCompatibilityRules();
       if (auto version = clientInfo->clientSlavesNetVersion.ptr(entityId)) {
-        if (auto updateSetPacket = updateSetPackets.value(connectionId)) {
+        auto updateSetPacket = updateSetPackets.value(connectionId);
+        if (updateSetPacket && tieredUpdates && connectionId == ServerConnectionId && !entityUpdateDue(*monitoredEntity, window))
+          updateSetPacket.reset();
+        if (updateSetPacket) {
           auto pair = make_pair(entityId, *version);
           auto& cache = m_netStateCache[netRules];
           auto i = cache.find(pair);
-          if (i == cache.end())
-            i = cache.insert(pair, monitoredEntity->writeNetState(*version, netRules)).first;
+          if (i == cache.end()) {
+            auto netState = monitoredEntity->writeNetState(*version, netRules);
+            i = cache.insert(pair, {make_shared<ByteArray const>(std::move(netState.first)), netState.second}).first;
+          }
           const auto& netState = i->second;
-          if (!netState.first.empty())
+          if (!netState.first->empty())
             updateSetPacket->deltas[entityId] = netState.first;
           *version = netState.second;
         }
       } else if (!monitoredEntity->masterOnly()) {
         // Client was unaware of this entity until now
-        auto firstUpdate = monitoredEntity->writeNetState(0, netRules);
-        clientInfo->clientSlavesNetVersion.add(entityId, firstUpdate.second);
-        clientInfo->outgoingPackets.append(make_shared<EntityCreatePacket>(monitoredEntity->entityType(),
-              entityFactory->netStoreEntity(monitoredEntity, netRules), std::move(firstUpdate.first), entityId));
+        auto& cache = m_entityCreateCache[netRules];
+        auto i = cache.find(entityId);
+        if (i == cache.end()) {
+          auto firstUpdate = monitoredEntity->writeNetState(0, netRules);
+          auto entityCreate = make_shared<EntityCreatePacket>(monitoredEntity->entityType(),
+              entityFactory->netStoreEntity(monitoredEntity, netRules), std::move(firstUpdate.first), entityId);
+          i = cache.insert(entityId, {std::move(entityCreate), firstUpdate.second}).first;
+        }
+        clientInfo->clientSlavesNetVersion.add(entityId, i->second.second);
+        clientInfo->outgoingPackets.append(i->second.first);
       }
     }
   }
@@ -2039,6 +2086,26 @@ void WorldServer::queueUpdatePackets(ConnectionId clientId, bool sendRemoteUpdat
     clientInfo->outgoingPackets.append(std::move(p.second));
 }
 
+bool WorldServer::entityUpdateDue(Entity const& entity, RectF const& window) const {
+  auto tiers = m_entityUpdateTiers.ptr(entity.entityType());
+  if (!tiers)
+    tiers = &m_defaultEntityUpdateTiers;
+  if (tiers->empty())
+    return true;
+
+  float distance = vmag(m_geometry.diffToNearestCoordInBox(window, entity.position()));
+  unsigned interval = 1;
+  for (auto const& tier : *tiers) {
+    if (distance < tier.first)
+      break;
+    interval = tier.second;
+  }
+
+  // Offset by entity id so entities on the same interval are spread out over
+  // different updates
+  return (m_entityUpdateCount + (uint64_t)entity.entityId()) % interval == 0;
+}
+
 void WorldServer::updateDamage(float dt) {
   m_damageManager->update(dt);
 
@@ -2176,41 +2243,13 @@ void WorldServer::writeNetTile(Vec2I const& pos, NetTile& netTile) const {
 }
 
 void WorldServer::dirtyCollision(RectI const& region) {
-  auto dirtyRegion = region.padded(CollisionGenerator::BlockInfluenceRadius);
-  for (int x = dirtyRegion.xMin(); x < dirtyRegion.xMax(); ++x) {
-    for (int y = dirtyRegion.yMin(); y < dirtyRegion.yMax(); ++y) {
-      if (auto tile = m_tileArray->modifyTile({x, y}))
-        tile->collisionCacheDirty = true;
-    }
-  }
+  WorldImpl::dirtyCollision(m_tileArray, region);
 }
 
 void WorldServer::freshenCollision(RectI const& region) {
-  RectI freshenRegion = RectI::null();
-  for (int x = region.xMin(); x < region.xMax(); ++x) {
-    for (int y = region.yMin(); y < region.yMax(); ++y) {
-      if (auto tile = m_tileArray->modifyTile({x, y})) {
-        if (tile->collisionCacheDirty)
-          freshenRegion.combine(RectI(x, y, x + 1, y + 1));
-      }
-    }
-  }
-
-  if (!freshenRegion.isNull()) {
-    for (int x = freshenRegion.xMin(); x < freshenRegion.xMax(); ++x) {
-      for (int y = freshenRegion.yMin(); y < freshenRegion.yMax(); ++y) {
-        if (auto tile = m_tileArray->modifyTile({x, y})) {
-          tile->collisionCacheDirty = false;
-          tile->collisionCache.clear();
-        }
-      }
-    }
-
-    for (auto collisionBlock : m_collisionGenerator.getBlocks(freshenRegion)) {
-      if (auto tile = m_tileArray->modifyTile(collisionBlock.space))
-        tile->collisionCache.append(std::move(collisionBlock));
-    }
-  }
+  WorldImpl::freshenCollision(m_tileArray, m_collisionGenerator, region, [this](int x, int y) {
+      return m_tileArray->tile({x, y}).getCollision();
+    });
 }
 
 void WorldServer::removeEntity(EntityId entityId, bool andDie) {
@@ -202,8 +202,10 @@ public:
   // Signal a region to load / generate, returns true if it is now fully loaded
   // and generated
   bool signalRegion(RectI const& region);
-  // Immediately generate a given region
-  void generateRegion(RectI const& region);
+  // Immediately generate a given region.  If pregenerate is true, the terrain
+  // of never generated sectors beyond those needed by the first sector is
+  // calculated on worker threads while this thread generates the rest.
+  void generateRegion(RectI const& region, bool pregenerate = true);
   // Returns true if a region is fully active without signaling it.
   bool regionActive(RectI const& region);
 
@@ -336,6 +338,10 @@ private:
 
   // Queues pending (step based) updates to the given player
   void queueUpdatePackets(ConnectionId clientId, bool sendRemoteUpdates);
+  // Whether a remote client with the given window should be sent deltas for
+  // a server master entity on this entity update, based on how far off
+  // screen it is.
+  bool entityUpdateDue(Entity const& entity, RectF const& window) const;
   void updateDamage(float dt);
 
   void updateDamagedBlocks(float dt);
@@ -401,12 +407,24 @@ private:
   CollisionGenerator m_collisionGenerator;
   List<CollisionBlock> m_workingCollisionBlocks;
 
-  HashMap<NetCompatibilityRules, HashMap<pair<EntityId, uint64_t>, pair<ByteArray, uint64_t>>> m_netStateCache;
+  // Entity deltas and creation packets written during a single step, shared
+  // between every client that needs the same one.
+  HashMap<NetCompatibilityRules, HashMap<pair<EntityId, uint64_t>, pair<ByteArrayConstPtr, uint64_t>>> m_netStateCache;
+  HashMap<NetCompatibilityRules, HashMap<EntityId, pair<PacketPtr, uint64_t>>> m_entityCreateCache;
   OrderedHashMap<ConnectionId, shared_ptr<ClientInfo>> m_clientInfo;
 
   GameTimer m_entityUpdateTimer;
   GameTimer m_tileEntityBreakCheckTimer;
 
+  // Pairs of a distance outside of a client's window and an interval, in
+  // order of distance.  Entities at least that far away are only sent deltas
+  // on every interval'th entity update.  Skipped deltas are not lost, the next
+  // one sent covers everything since the version the client has.
+  typedef List<pair<float, unsigned>> EntityUpdateTiers;
+  EntityUpdateTiers m_defaultEntityUpdateTiers;
+  HashMap<EntityType, EntityUpdateTiers> m_entityUpdateTiers;
+  uint64_t m_entityUpdateCount;
+
   shared_ptr<LiquidCellEngine<LiquidId>> m_liquidEngine;
   FallingBlocksAgentPtr m_fallingBlocksAgent;
   Spawner m_spawner;
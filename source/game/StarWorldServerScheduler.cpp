@@ -0,0 +1,134 @@
+#include "StarWorldServerScheduler.hpp"
+#include "StarLogging.hpp"
+#include "StarTime.hpp"
+
+namespace Star {
+
+WorldServerScheduler::WorldServerScheduler(size_t threadCount) : m_shutdown(false) {
+  if (threadCount == 0)
+    threadCount = max<size_t>(1, Thread::numberOfProcessors());
+
+  Logger::info("WorldServerScheduler: Starting {} world worker threads", threadCount);
+  for (size_t i = 0; i < threadCount; ++i)
+    m_threads.append(Thread::invoke(strf("WorldServerScheduler::worker_{}", i), [this]() { worker(); }));
+}
+
+WorldServerScheduler::~WorldServerScheduler() {
+  {
+    MutexLocker locker(m_mutex);
+    m_shutdown = true;
+    m_workCondition.broadcast();
+  }
+  for (auto& thread : m_threads)
+    thread.finish();
+}
+
+size_t WorldServerScheduler::threadCount() const {
+  return m_threads.size();
+}
+
+size_t WorldServerScheduler::worldCount() const {
+  MutexLocker locker(m_mutex);
+  return m_worlds.size();
+}
+
+void WorldServerScheduler::addWorld(WorldServerThread* world) {
+  bool hasClients = !world->noClients();
+  MutexLocker locker(m_mutex);
+  for (auto const& scheduled : m_worlds) {
+    if (scheduled.world == world)
+      return;
+  }
+  m_worlds.append(ScheduledWorld{world, Time::monotonicTime(), hasClients, false});
+  m_workCondition.signal();
+}
+
+void WorldServerScheduler::removeWorld(WorldServerThread* world) {
+  MutexLocker locker(m_mutex);
+  while (true) {
+    auto it = std::find_if(m_worlds.begin(), m_worlds.end(), [world](ScheduledWorld const& scheduled) {
+        return scheduled.world == world;
+      });
+    if (it == m_worlds.end())
+      return;
+
+    if (!it->ticking) {
+      m_worlds.erase(it);
+      return;
+    }
+
+    m_tickFinishedCondition.wait(m_mutex);
+  }
+}
+
+void WorldServerScheduler::worker() {
+  MutexLocker locker(m_mutex);
+  while (!m_shutdown) {
+    double now = Time::monotonicTime();
+
+    // Pick the most urgent world that is due, preferring worlds with clients
+    // and empty worlds that have waited too long, and otherwise find out how
+    // long until the next world is due.
+    auto preferred = [now](ScheduledWorld const& scheduled) {
+      return scheduled.hasClients || now - scheduled.deadline >= EmptyWorldMaxLateness;
+    };
+    ScheduledWorld* next = nullptr;
+    bool nextPreferred = false;
+    Maybe<double> nextDeadline;
+    for (auto& scheduled : m_worlds) {
+      if (scheduled.ticking)
+        continue;
+
+      if (scheduled.deadline <= now) {
+        bool scheduledPreferred = preferred(scheduled);
+        if (!next || (scheduledPreferred && !nextPreferred)
+            || (scheduledPreferred == nextPreferred && scheduled.deadline < next->deadline)) {
+          next = &scheduled;
+          nextPreferred = scheduledPreferred;
+        }
+      } else if (!nextDeadline || scheduled.deadline < *nextDeadline) {
+        nextDeadline = scheduled.deadline;
+      }
+    }
+
+    if (!next) {
+      if (nextDeadline)
+        m_workCondition.wait(m_mutex, max<unsigned>(1, ceil((*nextDeadline - now) * 1000)));
+      else
+        m_workCondition.wait(m_mutex);
+      continue;
+    }
+
+    next->ticking = true;
+    WorldServerThread* world = next->world;
+    double lateness = now - next->deadline;
+    locker.unlock();
+
+    LogMap::set(strf("server_{}_lateness", world->worldId()), strf("{:4.2f}ms", lateness * 1000));
+
+    Maybe<double> spareTime;
+    if (!world->m_stop && !world->m_errorOccurred)
+      spareTime = world->tick();
+    bool finished = !spareTime || world->m_stop || world->m_errorOccurred;
+    bool hasClients = !world->noClients();
+    if (finished)
+      world->m_scheduledRunning = false;
+
+    locker.lock();
+    auto it = std::find_if(m_worlds.begin(), m_worlds.end(), [world](ScheduledWorld const& scheduled) {
+        return scheduled.world == world;
+      });
+    if (finished) {
+      m_worlds.erase(it);
+    } else {
+      it->ticking = false;
+      it->hasClients = hasClients;
+      it->deadline = Time::monotonicTime() + max(0.0, *spareTime);
+    }
+    m_tickFinishedCondition.broadcast();
+    // Another worker may be waiting on this world's deadline.
+    m_workCondition.signal();
+  }
+}
+
+}
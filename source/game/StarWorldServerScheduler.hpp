@@ -0,0 +1,55 @@
+#pragma once
+
+#include "StarThread.hpp"
+#include "StarWorldServerThread.hpp"
+
+namespace Star {
+
+STAR_CLASS(WorldServerScheduler);
+
+// Ticks many WorldServerThreads on a fixed number of shared worker threads
+// rather than giving every world its own OS thread.  Each world keeps its own
+// tick deadline, a free worker always picks the due world with the earliest
+// deadline, and worlds that have clients on them are preferred over empty
+// worlds that are equally due.  Empty worlds that have been waiting for longer
+// than EmptyWorldMaxLateness are treated as if they had clients, so that busy
+// worlds cannot starve them.  How late each world tick starts relative to its
+// deadline is reported in LogMap as server_<world>_lateness.
+class WorldServerScheduler {
+public:
+  static constexpr double EmptyWorldMaxLateness = 0.25;
+
+  // If threadCount is 0, uses one thread per hardware processor.
+  WorldServerScheduler(size_t threadCount = 0);
+  ~WorldServerScheduler();
+
+  size_t threadCount() const;
+  size_t worldCount() const;
+
+  // Begins ticking the given world immediately.  The world must be removed
+  // before it is destroyed.
+  void addWorld(WorldServerThread* world);
+  // Stops ticking the given world, blocks until any tick of this world that is
+  // currently in progress completes.
+  void removeWorld(WorldServerThread* world);
+
+private:
+  struct ScheduledWorld {
+    WorldServerThread* world;
+    double deadline;
+    bool hasClients;
+    bool ticking;
+  };
+
+  void worker();
+
+  mutable Mutex m_mutex;
+  ConditionVariable m_workCondition;
+  ConditionVariable m_tickFinishedCondition;
+  List<ScheduledWorld> m_worlds;
+
+  List<ThreadFunction<void>> m_threads;
+  bool m_shutdown;
+};
+
+}
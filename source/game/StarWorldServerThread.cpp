@@ -1,5 +1,5 @@
 #include "StarWorldServerThread.hpp"
-#include "StarTickRateMonitor.hpp"
+#include "StarWorldServerScheduler.hpp"
 #include "StarNpc.hpp"
 #include "StarRoot.hpp"
 #include "StarLogging.hpp"
@@ -12,6 +12,8 @@ WorldServerThread::WorldServerThread(WorldServerPtr server, WorldId worldId)
   : Thread("WorldServerThread: " + printWorldId(worldId)),
     m_worldServer(std::move(server)),
     m_worldId(std::move(worldId)),
+    m_scheduled(false),
+    m_scheduledRunning(false),
     m_stop(false),
     m_errorOccurred(false),
     m_shouldExpire(true) {
@@ -21,6 +23,8 @@ WorldServerThread::WorldServerThread(WorldServerPtr server, WorldId worldId)
 
 WorldServerThread::~WorldServerThread() {
   m_stop = true;
+  if (m_scheduled)
+    m_scheduler->removeWorld(this);
   join();
 
   RecursiveMutexLocker locker(m_mutex);
@@ -35,18 +39,55 @@ WorldId WorldServerThread::worldId() const {
 void WorldServerThread::start() {
   m_stop = false;
   m_errorOccurred = false;
-  Thread::start();
+  if (m_scheduler) {
+    if (m_scheduled)
+      return;
+    try {
+      initTickState();
+    } catch (std::exception const& e) {
+      Logger::error("WorldServerThread exception caught: {}", outputException(e, true));
+      m_errorOccurred = true;
+    }
+    m_scheduled = true;
+    m_scheduledRunning = !m_errorOccurred;
+    if (m_scheduledRunning)
+      m_scheduler->addWorld(this);
+  } else {
+    Thread::start();
+  }
 }
 
 void WorldServerThread::stop() {
   m_stop = true;
-  Thread::join();
+  if (m_scheduled) {
+    m_scheduler->removeWorld(this);
+    m_scheduledRunning = false;
+    m_scheduled = false;
+  } else {
+    Thread::join();
+  }
 }
 
 void WorldServerThread::setPause(shared_ptr<const atomic<bool>> pause) {
   m_pause = pause;
 }
 
+void WorldServerThread::setScheduler(WorldServerSchedulerPtr scheduler) {
+  m_scheduler = std::move(scheduler);
+}
+
+bool WorldServerThread::isWorldRunning() const {
+  if (m_scheduler)
+    return m_scheduledRunning;
+  return Thread::isRunning();
+}
+
+bool WorldServerThread::isWorldJoined() const {
+  if (m_scheduler)
+    return !m_scheduled;
+  return Thread::isJoined();
+}
+
 bool WorldServerThread::serverErrorOccurred() {
   return m_errorOccurred;
 }
@@ -204,59 +245,81 @@ WorldChunks WorldServerThread::readChunks() {
 
 void WorldServerThread::run() {
   try {
-    auto& root = Root::singleton();
-    double updateMeasureWindow = root.assets()->json("/universe_server.config:updateMeasureWindow").toDouble();
-    double fidelityDecrementScore = root.assets()->json("/universe_server.config:fidelityDecrementScore").toDouble();
-    double fidelityIncrementScore = root.assets()->json("/universe_server.config:fidelityIncrementScore").toDouble();
+    initTickState();
+    while (!m_stop && !m_errorOccurred) {
+      auto spareTime = tick();
+      if (!spareTime)
+        break;
 
-    String serverFidelityMode = root.configuration()->get("serverFidelity").toString();
-    Maybe<WorldServerFidelity> lockedFidelity;
-    if (!serverFidelityMode.equalsIgnoreCase("automatic"))
-      lockedFidelity = WorldServerFidelityNames.getLeft(serverFidelityMode);
+      int64_t spareMilliseconds = floor(*spareTime * 1000);
+      if (spareMilliseconds > 0)
+        Thread::sleepPrecise(spareMilliseconds);
+    }
+  } catch (std::exception const& e) {
+    Logger::error("WorldServerThread exception caught: {}", outputException(e, true));
+    m_errorOccurred = true;
+  }
+}
 
-    double storageInterval = root.assets()->json("/universe_server.config:worldStorageInterval").toDouble() / 1000.0;
-    Timer storageTimer = Timer::withTime(storageInterval);
+void WorldServerThread::initTickState() {
+  auto& root = Root::singleton();
+  double updateMeasureWindow = root.assets()->json("/universe_server.config:updateMeasureWindow").toDouble();
+
+  String serverFidelityMode = root.configuration()->get("serverFidelity").toString();
+  Maybe<WorldServerFidelity> lockedFidelity;
+  if (!serverFidelityMode.equalsIgnoreCase("automatic"))
+    lockedFidelity = WorldServerFidelityNames.getLeft(serverFidelityMode);
+
+  double storageInterval = root.assets()->json("/universe_server.config:worldStorageInterval").toDouble() / 1000.0;
+
+  m_tickState = TickState{
+    root.assets()->json("/universe_server.config:fidelityDecrementScore").toDouble(),
+    root.assets()->json("/universe_server.config:fidelityIncrementScore").toDouble(),
+    lockedFidelity,
+    storageInterval,
+    Timer::withTime(storageInterval),
+    TickRateApproacher(1.0f / ServerGlobalTimestep, updateMeasureWindow),
+    0.0,
+    WorldServerFidelity::Medium
+  };
+}
 
-    TickRateApproacher tickApproacher(1.0f / ServerGlobalTimestep, updateMeasureWindow);
-    double fidelityScore = 0.0;
-    WorldServerFidelity automaticFidelity = WorldServerFidelity::Medium;
+Maybe<double> WorldServerThread::tick() {
+  try {
+    auto& state = *m_tickState;
+    auto fidelity = state.lockedFidelity.value(state.automaticFidelity);
+    LogMap::set(strf("server_{}_fidelity", m_worldId), WorldServerFidelityNames.getRight(fidelity));
+    LogMap::set(strf("server_{}_update", m_worldId), strf("{:4.2f}Hz", state.tickApproacher.rate()));
+
+    update(fidelity);
+    state.tickApproacher.setTargetTickRate(1.0f / ServerGlobalTimestep);
+    state.tickApproacher.tick();
+
+    if (state.storageTimer.timeUp()) {
+      sync();
+      state.storageTimer.restart(state.storageInterval);
+    }
 
-    while (!m_stop && !m_errorOccurred) {
-      auto fidelity = lockedFidelity.value(automaticFidelity);
-      LogMap::set(strf("server_{}_fidelity", m_worldId), WorldServerFidelityNames.getRight(fidelity));
-      LogMap::set(strf("server_{}_update", m_worldId), strf("{:4.2f}Hz", tickApproacher.rate()));
-
-      update(fidelity);
-      tickApproacher.setTargetTickRate(1.0f / ServerGlobalTimestep);
-      tickApproacher.tick();
-
-      if (storageTimer.timeUp()) {
-        sync();
-        storageTimer.restart(storageInterval);
-      }
-
-      double spareTime = tickApproacher.spareTime();
-      fidelityScore += spareTime;
-
-      if (fidelityScore <= fidelityDecrementScore) {
-        if (automaticFidelity > WorldServerFidelity::Minimum)
-          automaticFidelity = (WorldServerFidelity)((int)automaticFidelity - 1);
-        fidelityScore = 0.0;
-      }
-
-      if (fidelityScore >= fidelityIncrementScore) {
-        if (automaticFidelity < WorldServerFidelity::High)
-          automaticFidelity = (WorldServerFidelity)((int)automaticFidelity + 1);
-        fidelityScore = 0.0;
-      }
-
-      int64_t spareMilliseconds = floor(spareTime * 1000);
-      if (spareMilliseconds > 0)
-        Thread::sleepPrecise(spareMilliseconds);
+    double spareTime = state.tickApproacher.spareTime();
+    state.fidelityScore += spareTime;
+
+    if (state.fidelityScore <= state.fidelityDecrementScore) {
+      if (state.automaticFidelity > WorldServerFidelity::Minimum)
+        state.automaticFidelity = (WorldServerFidelity)((int)state.automaticFidelity - 1);
+      state.fidelityScore = 0.0;
     }
+
+    if (state.fidelityScore >= state.fidelityIncrementScore) {
+      if (state.automaticFidelity < WorldServerFidelity::High)
+        state.automaticFidelity = (WorldServerFidelity)((int)state.automaticFidelity + 1);
+      state.fidelityScore = 0.0;
+    }
+
+    return spareTime;
   } catch (std::exception const& e) {
     Logger::error("WorldServerThread exception caught: {}", outputException(e, true));
     m_errorOccurred = true;
+    return {};
   }
 }
 
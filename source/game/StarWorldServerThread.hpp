@@ -2,15 +2,22 @@
 
 #include "StarWorldServer.hpp"
 #include "StarThread.hpp"
+#include "StarTime.hpp"
+#include "StarTickRateMonitor.hpp"
 #include "StarRpcThreadPromise.hpp"
 
 namespace Star {
 
 STAR_CLASS(WorldServerThread);
+STAR_CLASS(WorldServerScheduler);
 
 // Runs a WorldServer in a separate thread and guards exceptions that occur in
 // it.  All methods are designed to not throw exceptions, but will instead log
 // the error and trigger the WorldServerThread error state.
+//
+// If a WorldServerScheduler is set before start() is called, the world does
+// not get its own OS thread and is instead ticked by the scheduler's shared
+// worker threads.
 class WorldServerThread : public Thread {
 public:
   struct Message {
@@ -30,6 +37,16 @@ public:
   // Signals the WorldServerThread to stop and then joins it
   void stop();
   void setPause(shared_ptr<const atomic<bool>> pause);
+  // Must be called before start(), if set the world will be ticked by the
+  // given scheduler rather than its own thread.
+  void setScheduler(WorldServerSchedulerPtr scheduler);
+
+  // Whether the world is still being ticked, and whether it has been stopped
+  // for good, whether it runs on its own thread or on the scheduler.  Use
+  // these rather than the Thread methods, which know nothing about scheduled
+  // worlds.
+  bool isWorldRunning() const;
+  bool isWorldJoined() const;
 
   // An exception occurred from the actual WorldServer itself and the
   // WorldServerThread has stopped running.
@@ -82,6 +99,26 @@ protected:
   virtual void run();
 
 private:
+  friend WorldServerScheduler;
+
+  struct TickState {
+    double fidelityDecrementScore;
+    double fidelityIncrementScore;
+    Maybe<WorldServerFidelity> lockedFidelity;
+    double storageInterval;
+    Timer storageTimer;
+    TickRateApproacher tickApproacher;
+    double fidelityScore;
+    WorldServerFidelity automaticFidelity;
+  };
+
+  void initTickState();
+  // Performs a single world tick along with periodic storage and automatic
+  // fidelity adjustment, and returns the number of seconds until the next
+  // tick is due.  Returns nothing if an error occurred and the world should
+  // no longer be ticked.
+  Maybe<double> tick();
+
   void update(WorldServerFidelity fidelity);
   void sync();
 
@@ -100,6 +137,11 @@ private:
   mutable RecursiveMutex m_messageMutex;
   List<Message> m_messages;
 
+  Maybe<TickState> m_tickState;
+  WorldServerSchedulerPtr m_scheduler;
+  atomic<bool> m_scheduled;
+  atomic<bool> m_scheduledRunning;
+
   atomic<bool> m_stop;
   shared_ptr<const atomic<bool>> m_pause;
   mutable atomic<bool> m_errorOccurred;
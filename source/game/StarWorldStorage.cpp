@@ -93,6 +93,7 @@ WorldStorage::WorldStorage(WorldChunks const& chunks, WorldGeneratorFacadePtr co
 }
 
 WorldStorage::~WorldStorage() {
+  finishBackgroundWork();
   if (m_db.isOpen()) {
     unloadAll(true);
     m_db.close();
@@ -100,10 +101,12 @@ WorldStorage::~WorldStorage() {
 }
 
 VersionedJson WorldStorage::worldMetadata() {
+  finishPendingSync();
   return readWorldMetadata(*m_db.find(metadataKey())).userMetadata;
 }
 
 void WorldStorage::setWorldMetadata(VersionedJson const& metadata) {
+  finishPendingSync();
   m_db.insert(metadataKey(), writeWorldMetadata({Vec2U(m_tileArray->size()), metadata}));
 }
 
@@ -155,6 +158,7 @@ void WorldStorage::loadSector(Sector sector) {
     loadSectorToLevel(sector, SectorLoadLevel::Loaded);
     setSectorTimeToLive(sector, randomizedSectorTTL());
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException(strf("Failed to load sector {}", sector), e);
@@ -166,12 +170,71 @@ void WorldStorage::activateSector(Sector sector) {
     generateSectorToLevel(sector, SectorGenerationLevel::Complete);
     setSectorTimeToLive(sector, randomizedSectorTTL());
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException(strf("Failed to load sector {}", sector), e);
   }
 }
 
+void WorldStorage::pregenerateSectors(List<Sector> const& sectors) {
+  if (!m_sectorPregenerationEnabled || !m_db.isOpen())
+    return;
+
+  // Searching probes the database for every sector around the given ones, so
+  // only search again once the given sectors or the loaded sectors change.
+  if (sectors == m_pregenerationSectors && m_sectorMetadata.size() == m_pregenerationLoadedSectors)
+    return;
+  m_pregenerationSectors = sectors;
+  m_pregenerationLoadedSectors = m_sectorMetadata.size();
+
+  auto neverGenerated = [this](Sector const& sector) {
+    if (auto metadata = m_sectorMetadata.ptr(sector))
+      return metadata->loadLevel >= SectorLoadLevel::Tiles && metadata->generationLevel == SectorGenerationLevel::None;
+    // Only look at what has been committed so as not to wait on a background
+    // sync.  A sector stored since the last commit is pregenerated for nothing.
+    return !m_db.containsCommitted(tileSectorKey(sector));
+  };
+
+  // Generating a sector completely first requires generating every sector up
+  // to this many steps away from it to the first generation level.
+  unsigned const neighborhoodRadius = (unsigned)SectorGenerationLevel::Complete - 1;
+
+  auto neighborhood = [&](Sector const& sector, function<void(Sector const&)> visit) {
+    HashSet<Sector> visited;
+    List<Sector> ring = {sector};
+    for (unsigned i = 0; i <= neighborhoodRadius; ++i) {
+      List<Sector> nextRing;
+      for (auto const& s : ring) {
+        if (m_tileArray->sectorValid(s) && visited.add(s)) {
+          visit(s);
+          nextRing.appendAll(adjacentSectors(s));
+        }
+      }
+      ring = std::move(nextRing);
+    }
+  };
+
+  // The caller goes on to generate the first sector straight away, so the
+  // sectors that it needs are left to the calling thread rather than queued
+  // behind each other on the workers.
+  HashSet<Sector> seen;
+  if (!sectors.empty())
+    neighborhood(sectors.first(), [&](Sector const& s) { seen.add(s); });
+
+  List<Sector> pregenerate;
+  for (auto const& sector : sectors) {
+    neighborhood(sector, [&](Sector const& s) {
+        if (pregenerate.size() < m_sectorPregenerationLimit && seen.add(s) && neverGenerated(s))
+          pregenerate.append(s);
+      });
+    if (pregenerate.size() >= m_sectorPregenerationLimit)
+      break;
+  }
+
+  m_generatorFacade->pregenerateSectors(this, pregenerate);
+}
+
 void WorldStorage::queueSectorActivation(Sector sector) {
   if (auto p = m_sectorMetadata.ptr(sector)) {
     p->timeToLive = randomizedSectorTTL();
@@ -196,6 +259,7 @@ void WorldStorage::triggerTerraformSector(Sector sector) {
       throw WorldStorageException(strf("Couldn't flag sector {} for terraforming; metadata unavailable", sector));
     }
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException(strf("Failed to terraform sector {}", sector), e);
@@ -227,6 +291,7 @@ Maybe<Vec2F> WorldStorage::findUniqueEntity(String const& uniqueId) {
   // Only return the unique index entry for the entity IF that stored sector is
   // not loaded, if the stored sector is loaded then the entity ought to have
   // been in the live entity map.
+  finishPendingSync();
   if (auto sectorAndPosition = getUniqueIndexEntry(uniqueId)) {
     if (m_sectorMetadata.value(sectorAndPosition->first).loadLevel < SectorLoadLevel::Entities)
       return sectorAndPosition->second;
@@ -240,6 +305,7 @@ EntityId WorldStorage::loadUniqueEntity(String const& uniqueId) {
   if (entityId != NullEntityId)
     return entityId;
 
+  finishPendingSync();
   if (auto sectorAndPosition = getUniqueIndexEntry(uniqueId)) {
     loadSector(sectorAndPosition->first);
     return m_entityMap->uniqueEntityId(uniqueId);
@@ -256,17 +322,26 @@ void WorldStorage::generateQueue(Maybe<size_t> sectorGenerationLevelLimit, funct
         });
     }
 
-    while (!m_generationQueue.empty()) {
+    prefetchQueuedSectors();
+    pregenerateSectors(m_generationQueue.keys());
+
+    for (auto const& sector : m_generationQueue.keys()) {
       if (sectorGenerationLevelLimit && *sectorGenerationLevelLimit == 0)
         break;
 
-      auto p = generateSectorToLevel(m_generationQueue.firstKey(), SectorGenerationLevel::Complete, sectorGenerationLevelLimit.value(NPos));
+      // Come back to sectors whose tiles are still being read in the
+      // background rather than blocking on them.
+      if (sectorPrefetchPending(sector))
+        continue;
+
+      auto p = generateSectorToLevel(sector, SectorGenerationLevel::Complete, sectorGenerationLevelLimit.value(NPos));
       if (p.first)
-        m_generationQueue.removeFirst();
+        m_generationQueue.remove(sector);
       if (sectorGenerationLevelLimit)
         *sectorGenerationLevelLimit -= p.second;
     }
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException("WorldStorage generation failed while generating from queue", e);
@@ -333,6 +408,7 @@ void WorldStorage::tick(float dt, String const* worldId) {
         }
 
         if (!zombiesToStore.empty()) {
+          finishPendingSync();
           EntitySectorStore sectorStore;
           if (auto res = m_db.find(entitySectorKey(sector)))
             sectorStore = readEntitySector(*res);
@@ -355,6 +431,7 @@ void WorldStorage::tick(float dt, String const* worldId) {
         strf("{} active, {}/{} unloaded ({} held)", m_sectorMetadata.size(), unloaded, skipped + unloaded, skipped));
     }
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException("WorldStorage exception during tick", e);
@@ -363,6 +440,7 @@ void WorldStorage::tick(float dt, String const* worldId) {
 
 void WorldStorage::unloadAll(bool force) {
   try {
+    finishPendingSync();
     auto storageConfig = Root::singleton().assets()->json("/worldstorage.config");
     auto sectors = m_sectorMetadata.keys();
 
@@ -385,6 +463,7 @@ void WorldStorage::unloadAll(bool force) {
       unloadSectorToLevel(sector, SectorLoadLevel::None, force);
 
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException("WorldStorage exception during unload", e);
@@ -393,10 +472,26 @@ void WorldStorage::unloadAll(bool force) {
 
 void WorldStorage::sync() {
   try {
+    // Only one sync may be in flight, if the last one is not done yet this is
+    // where the world thread gets held back.
+    finishPendingSync();
+
+    auto snapshots = make_shared<List<SectorSnapshot>>();
     for (auto const& pair : m_sectorMetadata)
-      syncSector(pair.first);
-    m_db.commit();
+      snapshots->append(snapshotSector(pair.first));
+
+    auto write = [this, snapshots]() {
+      for (auto const& snapshot : *snapshots)
+        writeSectorSnapshot(snapshot);
+      m_db.commit();
+    };
+
+    if (m_backgroundSync)
+      m_pendingSync = backgroundWorkerPool().addWork(write);
+    else
+      write();
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException("WorldStorage exception during sync", e);
@@ -405,6 +500,7 @@ void WorldStorage::sync() {
 
 WorldChunks WorldStorage::readChunks() {
   try {
+    finishPendingSync();
     for (auto const& pair : m_sectorMetadata)
       syncSector(pair.first);
 
@@ -416,6 +512,7 @@ WorldChunks WorldStorage::readChunks() {
     return WorldChunks(chunks);
 
   } catch (std::exception const& e) {
+    finishBackgroundWork();
     m_db.rollback();
     m_db.close();
     throw WorldStorageException("WorldStorage exception during readChunks", e);
@@ -602,10 +699,21 @@ void WorldStorage::openDatabase(BTreeDatabase& db, IODevicePtr device) {
     throw WorldStorageException::format("World database format is too old or unrecognized!");
 }
 
+WorkerPool& WorldStorage::backgroundWorkerPool() {
+  static WorkerPool pool("WorldStorage::background", Root::singleton().assets()->json("/worldstorage.config").optUInt("backgroundWorkerThreads").value(2));
+  return pool;
+}
+
 WorldStorage::WorldStorage() {
   auto storageConfig = Root::singleton().assets()->json("/worldstorage.config");
   m_sectorTimeToLive = jsonToVec2F(storageConfig.get("sectorTimeToLive"));
   m_generationQueueTimeToLive = storageConfig.getFloat("generationQueueTimeToLive");
+  m_backgroundSync = storageConfig.optBool("backgroundSync").value(true);
+  m_sectorPrefetchEnabled = storageConfig.optBool("sectorPrefetch").value(true);
+  m_sectorPrefetchLimit = storageConfig.optUInt("sectorPrefetchLimit").value(32);
+  m_sectorPregenerationEnabled = storageConfig.optBool("sectorPregeneration").value(true);
+  m_sectorPregenerationLimit = storageConfig.optUInt("sectorPregenerationLimit").value(64);
+  m_pregenerationLoadedSectors = 0;
 }
 
 bool WorldStorage::belongsInSector(Sector const& sector, Vec2F const& position) const {
@@ -672,6 +780,8 @@ void WorldStorage::loadSectorToLevel(Sector const& sector, SectorLoadLevel targe
   if (metadata.loadLevel >= targetLoadLevel)
     return;
 
+  finishPendingSync();
+
   metadata.timeToLive = randomizedSectorTTL();
 
   for (uint8_t i = (uint8_t)metadata.loadLevel + 1; i <= (uint8_t)targetLoadLevel; ++i) {
@@ -684,9 +794,13 @@ void WorldStorage::loadSectorToLevel(Sector const& sector, SectorLoadLevel targe
     }
 
     if (currentLoad == SectorLoadLevel::Tiles) {
-      if (auto res = m_db.find(tileSectorKey(sector))) {
-        TileSectorStore sectorStore = readTileSector(*res);
+      TileSectorStore sectorStore;
+      if (auto prefetch = takeSectorPrefetch(sector))
+        sectorStore = prefetch.take();
+      else if (auto res = m_db.find(tileSectorKey(sector)))
+        sectorStore = readTileSector(*res);
 
+      if (sectorStore.tiles) {
         m_tileArray->loadSector(sector, std::move(sectorStore.tiles));
 
         metadata.generationLevel = sectorStore.generationLevel;
@@ -733,6 +847,8 @@ bool WorldStorage::unloadSectorToLevel(Sector const& sector, SectorLoadLevel tar
   if (!m_tileArray->sectorValid(sector) || targetLoadLevel == SectorLoadLevel::Loaded)
     return true;
 
+  finishPendingSync();
+
   auto& metadata = m_sectorMetadata[sector];
   bool entitiesOverlap = false;
   if (m_entityMap) {
@@ -817,8 +933,15 @@ bool WorldStorage::unloadSectorToLevel(Sector const& sector, SectorLoadLevel tar
 }
 
 void WorldStorage::syncSector(Sector const& sector) {
+  finishPendingSync();
+  writeSectorSnapshot(snapshotSector(sector));
+}
+
+auto WorldStorage::snapshotSector(Sector const& sector) -> SectorSnapshot {
+  SectorSnapshot snapshot;
+  snapshot.sector = sector;
   if (!m_tileArray->sectorValid(sector))
-    return;
+    return snapshot;
 
   auto entityFactory = Root::singleton().entityFactory();
   auto& metadata = m_sectorMetadata[sector];
@@ -841,15 +964,112 @@ void WorldStorage::syncSector(Sector const& sector) {
         sectorStore.append(entityFactory->storeVersionedEntity(entity));
       }
     }
-    m_db.insert(entitySectorKey(sector), writeEntitySector(sectorStore));
-    updateSectorUniques(sector, storedUniques);
+    snapshot.entities.emplace(std::move(sectorStore), std::move(storedUniques));
   }
 
   if (metadata.loadLevel >= SectorLoadLevel::Tiles) {
-    TileSectorStore sectorStore;
-    sectorStore.tiles = m_tileArray->copySector(sector);
-    sectorStore.generationLevel = metadata.generationLevel;
-    m_db.insert(tileSectorKey(sector), writeTileSector(sectorStore));
+    snapshot.tiles.tiles = m_tileArray->copySector(sector);
+    snapshot.tiles.generationLevel = metadata.generationLevel;
+  }
+
+  return snapshot;
+}
+
+void WorldStorage::writeSectorSnapshot(SectorSnapshot const& snapshot) {
+  if (snapshot.entities) {
+    m_db.insert(entitySectorKey(snapshot.sector), writeEntitySector(snapshot.entities->first));
+    updateSectorUniques(snapshot.sector, snapshot.entities->second);
+  }
+
+  if (snapshot.tiles.tiles)
+    m_db.insert(tileSectorKey(snapshot.sector), writeTileSector(snapshot.tiles));
+}
+
+void WorldStorage::finishPendingSync() {
+  if (m_pendingSync)
+    m_pendingSync.take().finish();
+}
+
+void WorldStorage::prefetchQueuedSectors() {
+  if (!m_sectorPrefetchEnabled || !m_db.isOpen())
+    return;
+
+  auto prefetch = [this](Sector const& sector) {
+    if (m_sectorPrefetches.size() >= m_sectorPrefetchLimit)
+      return false;
+
+    // Stored tile data only changes when a loaded sector is stored, so reading
+    // a sector that is not currently loaded is safe until it is loaded.
+    if (!m_tileArray->sectorValid(sector) || m_sectorMetadata.contains(sector) || m_sectorPrefetches.contains(sector))
+      return true;
+
+    m_sectorPrefetches.add(sector, backgroundWorkerPool().addProducer<TileSectorStore>([this, sector]() -> TileSectorStore {
+        if (auto res = m_db.find(tileSectorKey(sector)))
+          return readTileSector(*res);
+        return TileSectorStore();
+      }));
+    return true;
+  };
+
+  // Drop finished reads for sectors that have since left the queue.
+  HashSet<Sector> queuedSectors;
+  for (auto const& sector : m_generationQueue.keys()) {
+    queuedSectors.add(sector);
+    queuedSectors.addAll(adjacentSectors(sector));
+  }
+  eraseWhere(m_sectorPrefetches, [&queuedSectors](auto const& p) {
+      return !queuedSectors.contains(p.first) && p.second.done();
+    });
+
+  for (auto const& sector : m_generationQueue.keys()) {
+    if (!prefetch(sector))
+      return;
+    for (auto const& adjacentSector : adjacentSectors(sector)) {
+      if (!prefetch(adjacentSector))
+        return;
+    }
+  }
+}
+
+bool WorldStorage::sectorPrefetchPending(Sector const& sector) const {
+  if (m_sectorPrefetches.empty())
+    return false;
+
+  auto pending = [this](Sector const& s) {
+    if (auto promise = m_sectorPrefetches.ptr(s))
+      return !promise->done();
+    return false;
+  };
+
+  if (pending(sector))
+    return true;
+  for (auto const& adjacentSector : adjacentSectors(sector)) {
+    if (pending(adjacentSector))
+      return true;
+  }
+  return false;
+}
+
+auto WorldStorage::takeSectorPrefetch(Sector const& sector) -> Maybe<TileSectorStore> {
+  if (auto promise = m_sectorPrefetches.maybeTake(sector))
+    return std::move(promise->get());
+  return {};
+}
+
+void WorldStorage::finishBackgroundWork() {
+  for (auto& p : m_sectorPrefetches) {
+    try {
+      p.second.get();
+    } catch (std::exception const&) {}
+  }
+  m_sectorPrefetches.clear();
+
+  if (m_pendingSync) {
+    try {
+      m_pendingSync.take().finish();
+    } catch (std::exception const& e) {
+      Logger::error("WorldStorage: Background sync failed: {}", outputException(e, false));
+    }
   }
 }
 
@@ -6,6 +6,7 @@
 #include "StarOrderedSet.hpp"
 #include "StarWorldTiles.hpp"
 #include "StarRpcPromise.hpp"
+#include "StarWorkerPool.hpp"
 #include "StarBiomePlacement.hpp"
 
 namespace Star {
@@ -71,6 +72,13 @@ struct WorldGeneratorFacade {
   // Queues up a microdungeon. Fulfills the rpc promise with the position the
   // microdungeon was placed at
   virtual RpcPromise<Vec2I> enqueuePlacement(List<BiomeItemDistribution> placements, Maybe<DungeonId> id) = 0;
+
+  // Called with sectors that have never been generated and are expected to be
+  // soon, most urgent first.  The generator may start any work towards
+  // generating them that does not touch the world on worker threads, to be
+  // picked up by generateSectorLevel.  Sectors that were passed previously
+  // but not this time are no longer expected to be generated.
+  virtual void pregenerateSectors(WorldStorage* storage, List<Sector> const& sectors) = 0;
 };
 
 // Handles paging entity and tile data in / out of disk backed storage for
@@ -84,6 +92,17 @@ struct WorldGeneratorFacade {
 // indeterminate world state cause the underlying database to be rolled back
 // and then immediately closed.  The underlying database committed only when
 // destructed without error, or a manual call to sync().
+//
+// Sectors waiting in the generation queue have their stored tile data read
+// and decoded ahead of time on a shared background worker pool, and the
+// generation queue skips over sectors whose tile data is still in flight, so
+// that the world thread does not have to wait on disk reads for queued
+// sectors.
+//
+// sync() only snapshots the loaded sectors on the calling thread, the
+// snapshots are then compressed, written and committed on the same worker
+// pool.  At most one sync is in flight at a time, anything else that needs to
+// touch the database first waits for the pending sync to finish.
 class WorldStorage {
 public:
   typedef ServerTileSectorArray::Sector Sector;
@@ -125,6 +144,10 @@ public:
   // Fully load, reset the TTL, and if necessary, fully generate the given
   // sector.
   void activateSector(Sector sector);
+  // Lets the generator start work on worker threads for the given sectors, and
+  // the sectors around them that they need, ahead of them being activated in
+  // order.  What the first sector needs is left to the calling thread.
+  void pregenerateSectors(List<Sector> const& sectors);
   // Queue the given sector for activation, if it is not already active.  If
   // the sector is loaded at all, also resets the TTL.
   void queueSectorActivation(Sector sector);
@@ -168,7 +191,7 @@ public:
   void unloadAll(bool force = false);
 
   // Sync all active sectors without unloading them, and commits the underlying
-  // database.
+  // database.  The write and commit happen in the background.
   void sync();
 
   // Syncs all active sectors to disk and stores the full content of the world
@@ -213,6 +236,14 @@ private:
     TileArrayPtr tiles;
   };
 
+  // Everything about a loaded sector that needs to be written to the
+  // database, captured so that it can be written without touching the world.
+  struct SectorSnapshot {
+    Sector sector;
+    Maybe<pair<EntitySectorStore, UniqueIndexStore>> entities;
+    TileSectorStore tiles;
+  };
+
   struct SectorMetadata {
     SectorMetadata();
 
@@ -243,6 +274,9 @@ private:
 
   static void openDatabase(BTreeDatabase& db, IODevicePtr device);
 
+  // Shared between all WorldStorage instances.
+  static WorkerPool& backgroundWorkerPool();
+
   WorldStorage();
 
   bool belongsInSector(Sector const& sector, Vec2F const& position) const;
@@ -269,6 +303,27 @@ private:
 
   // Sync this sector to disk without unloading it.
   void syncSector(Sector const& sector);
+  SectorSnapshot snapshotSector(Sector const& sector);
+  // Only touches the database, so may be called from any thread.
+  void writeSectorSnapshot(SectorSnapshot const& snapshot);
+
+  // Blocks until any background sync is written and committed, re-throwing
+  // any error that occurred while doing so.
+  void finishPendingSync();
+
+  // Starts background tile reads for queued sectors (and the sectors around
+  // them) that are not yet loaded.
+  void prefetchQueuedSectors();
+  // True if generating the given sector would have to wait on a background
+  // tile read that is not finished yet.
+  bool sectorPrefetchPending(Sector const& sector) const;
+  // Takes the prefetched tile data for the given sector if there is any,
+  // waiting for it if the read is still in progress.  If the sector was never
+  // stored, the returned store has no tiles.
+  Maybe<TileSectorStore> takeSectorPrefetch(Sector const& sector);
+  // Waits for and discards all in flight background reads and writes without
+  // throwing, used before the database is rolled back or closed.
+  void finishBackgroundWork();
 
   // Returns the sectors within WorldSectorSize of the given sector.  This is
   // *not exactly the same* as the surrounding 9 sectors in a square pattern,
@@ -300,6 +355,19 @@ private:
   StableHashMap<Sector, SectorMetadata> m_sectorMetadata;
   OrderedHashMap<Sector, float> m_generationQueue;
   BTreeDatabase m_db;
+
+  bool m_backgroundSync;
+  Maybe<WorkerPoolHandle> m_pendingSync;
+
+  bool m_sectorPrefetchEnabled;
+  size_t m_sectorPrefetchLimit;
+  HashMap<Sector, WorkerPoolPromise<TileSectorStore>> m_sectorPrefetches;
+
+  bool m_sectorPregenerationEnabled;
+  size_t m_sectorPregenerationLimit;
+  // The sectors and number of loaded sectors at the last pregeneration search
+  List<Sector> m_pregenerationSectors;
+  size_t m_pregenerationLoadedSectors;
 };
 
 }
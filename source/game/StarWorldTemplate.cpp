@@ -112,11 +112,13 @@ WorldLayoutPtr WorldTemplate::worldLayout() const {
 
 void WorldTemplate::setWorldParameters(VisitableWorldParametersPtr newParameters) {
   m_worldParameters = take(newParameters);
+  ++m_revision;
 }
 
 void WorldTemplate::setWorldLayout(WorldLayoutPtr newLayout) {
   m_layout = take(newLayout);
   m_blockCache.clear();
+  ++m_revision;
 }
 
 void WorldTemplate::setSkyParameters(SkyParameters newParameters) {
@@ -188,16 +190,19 @@ Maybe<Vec2I> WorldTemplate::findSensiblePlayerStart() const {
 void WorldTemplate::addCustomTerrainRegion(PolyF poly) {
   m_customTerrainRegions.append({poly, poly.boundBox(), true});
   m_blockCache.clear();
+  ++m_revision;
 }
 
 void WorldTemplate::addCustomSpaceRegion(PolyF poly) {
   m_customTerrainRegions.append({poly, poly.boundBox(), false});
   m_blockCache.clear();
+  ++m_revision;
 }
 
 void WorldTemplate::clearCustomTerrains() {
   m_customTerrainRegions.clear();
   m_blockCache.clear();
+  ++m_revision;
 }
 
 List<RectI> WorldTemplate::previewAddBiomeRegion(Vec2I const& position, int width) {
@@ -232,6 +237,7 @@ void WorldTemplate::addBiomeRegion(Vec2I const& position, String const& biomeNam
   if (auto terrestrialParameters = as<TerrestrialWorldParameters>(m_worldParameters)) {
     m_layout->addBiomeRegion(*terrestrialParameters, m_seed, position, biomeName, subBlockSelector, width);
     m_blockCache.clear();
+    ++m_revision;
   } else {
     Logger::error("Cannot add biome region to non-terrestrial world!");
     // throw StarException("Cannot add biome region to non-terrestrial world!");
@@ -242,6 +248,7 @@ void WorldTemplate::expandBiomeRegion(Vec2I const& position, int newWidth) {
   if (auto terrestrialParameters = as<TerrestrialWorldParameters>(m_worldParameters)) {
     m_layout->expandBiomeRegion(position, newWidth);
     m_blockCache.clear();
+    ++m_revision;
   } else {
     Logger::error("Cannot expand biome region on non-terrestrial world!");
     // throw StarException("Cannot expand biome region on non-terrestrial world!");
@@ -578,6 +585,7 @@ WorldTemplate::WorldTemplate() {
   m_customTerrainBlendWeight = m_templateConfig.getFloat("customTerrainBlendWeight");
 
   m_blockCache.setMaxSize(m_templateConfig.getInt("blockCacheSize"));
+  m_revision = 0;
   m_geometry = Vec2U(2048, 2048);
   m_seed = Random::randu64();
 }
@@ -623,164 +631,238 @@ pair<float, float> WorldTemplate::customTerrainWeighting(int x, int y) const {
   return {finalSolidWeight * m_customTerrainBlendWeight, 1.0f - minimumDistance / m_customTerrainBlendSize};
 }
 
-WorldTemplate::BlockInfo WorldTemplate::getBlockInfo(uint32_t x, uint32_t y) const {
-  return m_blockCache.get(Vector<uint32_t, 2>(x, y), [this, x, y](Vector<uint32_t, 2>) {
-      BlockInfo blockInfo;
-
-      if (!m_layout)
-        return blockInfo;
-
-      // The environment biome is calculated with weighting based on the flat coordinates.
-      List<WorldLayout::RegionWeighting> flatWeighting = m_layout->getWeighting(x, y);
-
-      // The block biome is calculated optionally with higher frequency noise
-      // added to prevent straight lines appearing on the boundaries of
-      // regions.
-
-      int blendNoiseOffset = 0;
-      if (auto const& blendNoise = m_layout->blendNoise())
-        blendNoiseOffset = (int)blendNoise->get(x, y);
-
-      Vec2I blockPos;
-      List<WorldLayout::RegionWeighting> blockWeighting;
-      List<WorldLayout::RegionWeighting> transitionWeighting;
-      if (auto const& blockNoise = m_layout->blockNoise()) {
-        blockPos = blockNoise->apply(Vec2I(x, y), m_geometry.size());
-        blockWeighting = m_layout->getWeighting(blockPos[0] + blendNoiseOffset, blockPos[1]);
-        transitionWeighting = m_layout->getWeighting(blockPos[0], blockPos[1]);
-      } else {
-        blockPos = Vec2I(x, y);
-        blockWeighting = flatWeighting;
-        transitionWeighting = flatWeighting;
-      }
+template <typename Sampler>
+WorldTemplate::BlockInfo WorldTemplate::computeBlockInfo(uint32_t x, uint32_t y, Sampler&& sampler) const {
+  BlockInfo blockInfo;
 
-      if (flatWeighting.empty() || blockWeighting.empty())
-        return blockInfo;
+  if (!m_layout)
+    return blockInfo;
 
-      auto const& primaryFlatWeighting = flatWeighting.first();
-      auto const& primaryBlockWeighting = blockWeighting.first();
+  // The environment biome is calculated with weighting based on the flat coordinates.
+  List<WorldLayout::RegionWeighting> flatWeighting = m_layout->getWeighting(x, y);
 
-      blockInfo.blockBiomeIndex = primaryBlockWeighting.region->blockBiomeIndex;
-      blockInfo.environmentBiomeIndex = primaryFlatWeighting.region->environmentBiomeIndex;
+  // The block biome is calculated optionally with higher frequency noise
+  // added to prevent straight lines appearing on the boundaries of
+  // regions.
 
-      blockInfo.biomeTransition = transitionWeighting.first().weight < m_templateConfig.getFloat("biomeTransitionThreshold", 0);
+  int blendNoiseOffset = 0;
+  if (auto const& blendNoise = m_layout->blendNoise())
+    blendNoiseOffset = (int)blendNoise->get(x, y);
 
-      float terrainSelect = 0.0f;
-      float foregroundCaveSelect = 0.0f;
-      float backgroundCaveSelect = 0.0f;
+  Vec2I blockPos;
+  List<WorldLayout::RegionWeighting> blockWeighting;
+  List<WorldLayout::RegionWeighting> transitionWeighting;
+  if (auto const& blockNoise = m_layout->blockNoise()) {
+    blockPos = blockNoise->apply(Vec2I(x, y), m_geometry.size());
+    blockWeighting = m_layout->getWeighting(blockPos[0] + blendNoiseOffset, blockPos[1]);
+    transitionWeighting = m_layout->getWeighting(blockPos[0], blockPos[1]);
+  } else {
+    blockPos = Vec2I(x, y);
+    blockWeighting = flatWeighting;
+    transitionWeighting = flatWeighting;
+  }
 
-      // Terrain weighting uses the flat weighting, and weights each selector
-      // to blend among them.
-      for (auto const& weighting : flatWeighting) {
-        if (weighting.region->terrainSelectorIndex != NullTerrainSelectorIndex) {
-          auto const& terrainSelector = m_layout->getTerrainSelector(weighting.region->terrainSelectorIndex);
-          float select = terrainSelector->get(weighting.xValue, y) * weighting.weight;
-          terrainSelect += select;
-        }
-      }
+  if (flatWeighting.empty() || blockWeighting.empty())
+    return blockInfo;
 
-      // This is a bit of a cheat. Since customTerrainWeighting is always flat,
-      // there are some odd effects that come from linearly interpolating from
-      // the generally non-flat terrain sources to flat regions of space.  By
-      // using an interpolator that has an exaggerated S curve between the
-      // points, this hides some of these effects.
-      auto ctweighting = customTerrainWeighting(x, y);
-      terrainSelect = quintic2(ctweighting.second, terrainSelect, ctweighting.first);
-
-      if (terrainSelect > 0.0f) {
-        blockInfo.terrain = true;
-
-        for (auto const& weighting : flatWeighting) {
-          if (weighting.region->foregroundCaveSelectorIndex != NullTerrainSelectorIndex) {
-            auto const& foregroundCaveSelector = m_layout->getTerrainSelector(weighting.region->foregroundCaveSelectorIndex);
-            foregroundCaveSelect += foregroundCaveSelector->get(weighting.xValue, y) * weighting.weight;
-          }
+  auto const& primaryFlatWeighting = flatWeighting.first();
+  auto const& primaryBlockWeighting = blockWeighting.first();
 
-          if (weighting.region->backgroundCaveSelectorIndex != NullTerrainSelectorIndex) {
-            auto const& backgroundCaveSelector = m_layout->getTerrainSelector(weighting.region->backgroundCaveSelectorIndex);
-            backgroundCaveSelect += backgroundCaveSelector->get(weighting.xValue, y) * weighting.weight;
-          }
-        }
+  blockInfo.blockBiomeIndex = primaryBlockWeighting.region->blockBiomeIndex;
+  blockInfo.environmentBiomeIndex = primaryFlatWeighting.region->environmentBiomeIndex;
 
-        auto surfaceCaveAttenuationDist = m_templateConfig.getFloat("surfaceCaveAttenuationDist", 0);
-        if (terrainSelect < surfaceCaveAttenuationDist) {
-          auto surfaceCaveAttenuationFactor = m_templateConfig.getFloat("surfaceCaveAttenuationFactor", 1);
-          foregroundCaveSelect -= (surfaceCaveAttenuationDist - terrainSelect) * surfaceCaveAttenuationFactor;
-          backgroundCaveSelect -= (surfaceCaveAttenuationDist - terrainSelect) * surfaceCaveAttenuationFactor;
-        }
-      }
+  blockInfo.biomeTransition = transitionWeighting.first().weight < m_templateConfig.getFloat("biomeTransitionThreshold", 0);
+
+  float terrainSelect = 0.0f;
+  float foregroundCaveSelect = 0.0f;
+  float backgroundCaveSelect = 0.0f;
 
-      blockInfo.foregroundCave = foregroundCaveSelect > 0.0f;
-      blockInfo.backgroundCave = backgroundCaveSelect > 0.0f;
+  // Terrain weighting uses the flat weighting, and weights each selector
+  // to blend among them.
+  for (auto const& weighting : flatWeighting) {
+    if (weighting.region->terrainSelectorIndex != NullTerrainSelectorIndex) {
+      float select = sampler(weighting.region->terrainSelectorIndex, weighting.xValue, y) * weighting.weight;
+      terrainSelect += select;
+    }
+  }
+
+  // This is a bit of a cheat. Since customTerrainWeighting is always flat,
+  // there are some odd effects that come from linearly interpolating from
+  // the generally non-flat terrain sources to flat regions of space.  By
+  // using an interpolator that has an exaggerated S curve between the
+  // points, this hides some of these effects.
+  auto ctweighting = customTerrainWeighting(x, y);
+  terrainSelect = quintic2(ctweighting.second, terrainSelect, ctweighting.first);
 
-      auto const& regionLiquids = primaryFlatWeighting.region->regionLiquids;
-      blockInfo.caveLiquid = regionLiquids.caveLiquid;
-      blockInfo.caveLiquidSeedDensity = regionLiquids.caveLiquidSeedDensity;
-      blockInfo.oceanLiquid = regionLiquids.oceanLiquid;
-      blockInfo.oceanLiquidLevel = regionLiquids.oceanLiquidLevel;
-      blockInfo.encloseLiquids = regionLiquids.encloseLiquids;
-      blockInfo.fillMicrodungeons = regionLiquids.fillMicrodungeons;
+  if (terrainSelect > 0.0f) {
+    blockInfo.terrain = true;
 
-      if (!blockInfo.terrain && blockInfo.encloseLiquids && (int)y < blockInfo.oceanLiquidLevel) {
-        blockInfo.terrain = true;
-        blockInfo.foregroundCave = true;
+    for (auto const& weighting : flatWeighting) {
+      if (weighting.region->foregroundCaveSelectorIndex != NullTerrainSelectorIndex) {
+        foregroundCaveSelect += sampler(weighting.region->foregroundCaveSelectorIndex, weighting.xValue, y) * weighting.weight;
       }
 
-      if (blockInfo.terrain) {
-        if (auto blockBiome = biome(blockInfo.blockBiomeIndex)) {
-          if (!blockInfo.foregroundCave) {
-            blockInfo.foreground = blockBiome->mainBlock;
-            blockInfo.background = blockInfo.foreground;
-          } else if (!blockInfo.backgroundCave) {
-            blockInfo.background = blockBiome->mainBlock;
-          }
+      if (weighting.region->backgroundCaveSelectorIndex != NullTerrainSelectorIndex) {
+        backgroundCaveSelect += sampler(weighting.region->backgroundCaveSelectorIndex, weighting.xValue, y) * weighting.weight;
+      }
+    }
+
+    auto surfaceCaveAttenuationDist = m_templateConfig.getFloat("surfaceCaveAttenuationDist", 0);
+    if (terrainSelect < surfaceCaveAttenuationDist) {
+      auto surfaceCaveAttenuationFactor = m_templateConfig.getFloat("surfaceCaveAttenuationFactor", 1);
+      foregroundCaveSelect -= (surfaceCaveAttenuationDist - terrainSelect) * surfaceCaveAttenuationFactor;
+      backgroundCaveSelect -= (surfaceCaveAttenuationDist - terrainSelect) * surfaceCaveAttenuationFactor;
+    }
+  }
+
+  blockInfo.foregroundCave = foregroundCaveSelect > 0.0f;
+  blockInfo.backgroundCave = backgroundCaveSelect > 0.0f;
+
+  auto const& regionLiquids = primaryFlatWeighting.region->regionLiquids;
+  blockInfo.caveLiquid = regionLiquids.caveLiquid;
+  blockInfo.caveLiquidSeedDensity = regionLiquids.caveLiquidSeedDensity;
+  blockInfo.oceanLiquid = regionLiquids.oceanLiquid;
+  blockInfo.oceanLiquidLevel = regionLiquids.oceanLiquidLevel;
+  blockInfo.encloseLiquids = regionLiquids.encloseLiquids;
+  blockInfo.fillMicrodungeons = regionLiquids.fillMicrodungeons;
+
+  if (!blockInfo.terrain && blockInfo.encloseLiquids && (int)y < blockInfo.oceanLiquidLevel) {
+    blockInfo.terrain = true;
+    blockInfo.foregroundCave = true;
+  }
 
-          // subBlock, foregroundOre, and backgroundOre selectors can be empty
-          // if they are not enabled, otherwise they will always have the
-          // correct count
-
-          if (!primaryBlockWeighting.region->subBlockSelectorIndexes.empty()) {
-            for (size_t i = 0; i < blockBiome->subBlocks.size(); ++i) {
-              auto const& selector = m_layout->getTerrainSelector(primaryBlockWeighting.region->subBlockSelectorIndexes.at(i));
-              if (selector->get(primaryBlockWeighting.xValue - blendNoiseOffset, blockPos[1]) > 0.0f) {
-                if (!blockInfo.foregroundCave) {
-                  blockInfo.foreground = blockBiome->subBlocks.at(i);
-                  blockInfo.background = blockInfo.foreground;
-                } else if (!blockInfo.backgroundCave) {
-                  blockInfo.background = blockBiome->subBlocks.at(i);
-                }
-
-                break;
-              }
+  if (blockInfo.terrain) {
+    if (auto blockBiome = biome(blockInfo.blockBiomeIndex)) {
+      if (!blockInfo.foregroundCave) {
+        blockInfo.foreground = blockBiome->mainBlock;
+        blockInfo.background = blockInfo.foreground;
+      } else if (!blockInfo.backgroundCave) {
+        blockInfo.background = blockBiome->mainBlock;
+      }
+
+      // subBlock, foregroundOre, and backgroundOre selectors can be empty
+      // if they are not enabled, otherwise they will always have the
+      // correct count
+
+      if (!primaryBlockWeighting.region->subBlockSelectorIndexes.empty()) {
+        for (size_t i = 0; i < blockBiome->subBlocks.size(); ++i) {
+          if (sampler(primaryBlockWeighting.region->subBlockSelectorIndexes.at(i), primaryBlockWeighting.xValue - blendNoiseOffset, blockPos[1]) > 0.0f) {
+            if (!blockInfo.foregroundCave) {
+              blockInfo.foreground = blockBiome->subBlocks.at(i);
+              blockInfo.background = blockInfo.foreground;
+            } else if (!blockInfo.backgroundCave) {
+              blockInfo.background = blockBiome->subBlocks.at(i);
             }
+
+            break;
           }
+        }
+      }
 
-          if (!blockInfo.foregroundCave && !primaryBlockWeighting.region->foregroundOreSelectorIndexes.empty()) {
-            for (size_t i = 0; i < blockBiome->ores.size(); ++i) {
-              auto const& selector = m_layout->getTerrainSelector(primaryBlockWeighting.region->foregroundOreSelectorIndexes.at(i));
-              if (selector->get(x, y) > 0.0f) {
-                blockInfo.foregroundMod = blockBiome->ores.at(i).first;
-                break;
-              }
-            }
+      if (!blockInfo.foregroundCave && !primaryBlockWeighting.region->foregroundOreSelectorIndexes.empty()) {
+        for (size_t i = 0; i < blockBiome->ores.size(); ++i) {
+          if (sampler(primaryBlockWeighting.region->foregroundOreSelectorIndexes.at(i), x, y) > 0.0f) {
+            blockInfo.foregroundMod = blockBiome->ores.at(i).first;
+            break;
           }
+        }
+      }
 
-          if (!blockInfo.backgroundCave && !primaryBlockWeighting.region->backgroundOreSelectorIndexes.empty()) {
-            for (size_t i = 0; i < blockBiome->ores.size(); ++i) {
-              auto const& selector = m_layout->getTerrainSelector(primaryBlockWeighting.region->backgroundOreSelectorIndexes.at(i));
-              if (selector->get(x, y) > 0.0f) {
-                blockInfo.backgroundMod = blockBiome->ores.at(i).first;
-                break;
-              }
-            }
+      if (!blockInfo.backgroundCave && !primaryBlockWeighting.region->backgroundOreSelectorIndexes.empty()) {
+        for (size_t i = 0; i < blockBiome->ores.size(); ++i) {
+          if (sampler(primaryBlockWeighting.region->backgroundOreSelectorIndexes.at(i), x, y) > 0.0f) {
+            blockInfo.backgroundMod = blockBiome->ores.at(i).first;
+            break;
           }
         }
       }
+    }
+  }
+
+  return blockInfo;
+}
 
-      return blockInfo;
+WorldTemplate::BlockInfo WorldTemplate::getBlockInfo(uint32_t x, uint32_t y) const {
+  return m_blockCache.get(Vector<uint32_t, 2>(x, y), [this, x, y](Vector<uint32_t, 2>) {
+      return computeBlockInfo(x, y, [this](TerrainSelectorIndex index, int sx, int sy) {
+          return m_layout->getTerrainSelector(index)->get(sx, sy);
+        });
     });
 }
 
+List<WorldTemplate::BlockInfo> WorldTemplate::blockInfoRegion(RectI const& region) const {
+  List<BlockInfo> blockInfos;
+  blockInfos.reserve(region.volume());
+
+  // Selector values for the current row, for queries at the row of the block
+  // being calculated.  Most queries in a row are made at a constant offset
+  // from the block's x position, so are evaluated together from the first
+  // column that uses that offset to the end of the row.  Queries at other
+  // rows, or offsets that keep changing, go through TerrainSelector::get.
+  struct SelectorRow {
+    int y;
+    int offset;
+    int column;
+    unsigned evaluations;
+    List<float> values;
+  };
+  HashMap<TerrainSelectorIndex, SelectorRow> selectorRows;
+  unsigned const MaxRowEvaluations = 4;
+
+  int width = region.width();
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    for (int column = 0; column < width; ++column) {
+      int x = region.xMin() + column;
+      Vector<uint32_t, 2> key(m_geometry.xwrap(x), y);
+      if (auto blockInfo = m_blockCache.ptr(key)) {
+        blockInfos.append(*blockInfo);
+        continue;
+      }
+
+      auto sampler = [&](TerrainSelectorIndex index, int sx, int sy) -> float {
+        auto const& selector = m_layout->getTerrainSelector(index);
+        if (sy != y)
+          return selector->get(sx, sy);
+
+        int offset = sx - column;
+        auto& row = selectorRows[index];
+        if (row.values.empty() || row.y != y || row.offset != offset || column < row.column) {
+          if (row.values.empty() || row.y != y)
+            row.evaluations = 0;
+          else if (row.evaluations >= MaxRowEvaluations)
+            return selector->get(sx, sy);
+
+          row.y = y;
+          row.offset = offset;
+          row.column = column;
+          ++row.evaluations;
+          row.values.resize(width - column);
+          selector->getRegion(RectI(sx, y, offset + width, y + 1), row.values.ptr());
+        }
+        return row.values[column - row.column];
+      };
+
+      BlockInfo blockInfo = computeBlockInfo(key[0], key[1], sampler);
+      m_blockCache.set(key, blockInfo);
+      blockInfos.append(blockInfo);
+    }
+  }
+
+  return blockInfos;
+}
+
+void WorldTemplate::cacheBlockInfoRegion(RectI const& region, List<BlockInfo> const& blockInfos) const {
+  size_t i = 0;
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    for (int x = region.xMin(); x < region.xMax(); ++x)
+      m_blockCache.set(Vector<uint32_t, 2>(m_geometry.xwrap(x), y), blockInfos.at(i++));
+  }
+}
+
+uint64_t WorldTemplate::revision() const {
+  return m_revision;
+}
+
 Json WorldTemplate::BlockInfo::toJson() const {
   return JsonObject({
     {"blockBiomeIndex", blockBiomeIndex},
@@ -131,6 +131,17 @@ public:
   bool isOutside(RectI const& region) const;
 
   BlockInfo blockInfo(int x, int y) const;
+  // Block info for every block in the region, in rows from the bottom of the
+  // region.  Evaluates terrain selectors a row at a time rather than block by
+  // block, with the same results as blockInfo.
+  List<BlockInfo> blockInfoRegion(RectI const& region) const;
+  // Adds block info for the region, as returned by blockInfoRegion on a copy
+  // of this template with the same revision, to the block cache.
+  void cacheBlockInfoRegion(RectI const& region, List<BlockInfo> const& blockInfos) const;
+
+  // Increases every time the world parameters, layout or custom terrain
+  // regions change, and so a copy made from store() may differ.
+  uint64_t revision() const;
 
   // partial blockinfo that doesn't use terrain selectors
   BlockInfo blockBiomeInfo(int x, int y) const;
@@ -185,6 +196,10 @@ private:
 
   // Calculates block info and adds to cache
   BlockInfo getBlockInfo(uint32_t x, uint32_t y) const;
+  // Calculates block info, getting terrain selector values through
+  // sampler(TerrainSelectorIndex, int x, int y)
+  template <typename Sampler>
+  BlockInfo computeBlockInfo(uint32_t x, uint32_t y, Sampler&& sampler) const;
 
   Json m_templateConfig;
   float m_customTerrainBlendSize;
@@ -201,6 +216,7 @@ private:
   List<CustomTerrainRegion> m_customTerrainRegions;
 
   mutable HashLruCache<Vector<uint32_t, 2>, BlockInfo> m_blockCache;
+  uint64_t m_revision;
 };
 
 }
@@ -77,6 +77,9 @@ bool LuaBaseComponent::init() {
   if (!m_luaRoot)
     return false;
 
+  static String const InitFunction = "init";
+  LuaProfileSample profileSample(m_luaRoot.get(), m_scripts, InitFunction);
+
   m_error.reset();
   try {
     m_context = m_luaRoot->createContext(m_scripts);
@@ -105,6 +108,8 @@ bool LuaBaseComponent::init() {
 void LuaBaseComponent::uninit() {
   if (m_context) {
     if (m_context->containsPath("uninit")) {
+      static String const UninitFunction = "uninit";
+      LuaProfileSample profileSample(m_luaRoot.get(), m_scripts, UninitFunction);
       try {
         m_context->invokePath("uninit");
       } catch (LuaException const& e) {
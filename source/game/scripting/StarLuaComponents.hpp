@@ -5,6 +5,7 @@
 #include "StarListener.hpp"
 #include "StarWorld.hpp"
 #include "StarWorldLuaBindings.hpp"
+#include "StarLuaRoot.hpp"
 
 namespace Star {
 
@@ -193,6 +194,7 @@ Maybe<Ret> LuaBaseComponent::invoke(String const& name, V&&... args) {
   if (!checkInitialization())
     return {};
 
+  LuaProfileSample profileSample(m_luaRoot.get(), m_scripts, name);
   try {
     auto method = m_context->getPath(name);
     if (method == LuaNil)
@@ -348,6 +350,7 @@ Maybe<Json> LuaMessageHandlingComponent<Base>::handleMessage(
     return {};
 
   if (auto handler = m_messageHandlers.ptr(message)) {
+    LuaProfileSample profileSample(Base::luaRoot().get(), Base::scripts(), message);
     try {
       if (handler->localOnly) {
         if (!localMessage)
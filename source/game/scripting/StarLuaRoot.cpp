@@ -1,16 +1,52 @@
 #include "StarLuaRoot.hpp"
 #include "StarAssets.hpp"
+#include "StarLuaBytecodeCache.hpp"
+#include "StarTime.hpp"
+#include "StarLogging.hpp"
 
 namespace Star {
 
+namespace {
+  // Compiled scripts shared between every LuaRoot in the process, and saved to
+  // the storage directory unless disabled.  Dropped on root reload, to be
+  // created again on next use.
+  Mutex s_bytecodeCacheMutex;
+  LuaBytecodeCachePtr s_bytecodeCache;
+
+  LuaBytecodeCachePtr bytecodeCache(LuaEngine& engine) {
+    MutexLocker locker(s_bytecodeCacheMutex);
+    if (!s_bytecodeCache) {
+      auto& root = Root::singleton();
+      Maybe<String> storageFile;
+      if (root.configuration()->get("scriptBytecodeCache").toBool())
+        storageFile = root.toStoragePath("lua/bytecode.cache");
+      s_bytecodeCache = make_shared<LuaBytecodeCache>(root.assets()->digest(), LuaBytecodeCache::engineSignature(engine), storageFile);
+    }
+    return s_bytecodeCache;
+  }
+}
+
 LuaRoot::LuaRoot() {
   auto& root = Root::singleton();
   m_scriptCache = make_shared<ScriptCache>();
 
+  m_profileSampleInterval = 0;
+  m_profileInvocations = 0;
+  m_profileStartTime = Time::monotonicMicroseconds();
+  m_profileCategory = "world";
+  m_profileMeasureInterval = 0;
+
   restart();
 
   m_rootReloadListener = make_shared<CallbackListener>([cache = m_scriptCache]() {
       cache->clear();
+      MutexLocker locker(s_bytecodeCacheMutex);
+      auto bytecodeCache = take(s_bytecodeCache);
+      locker.unlock();
+      // Waits for the write, as the next cache may be loaded from the same
+      // file.
+      if (bytecodeCache)
+        bytecodeCache->save();
     });
   root.registerReloadListener(m_rootReloadListener);
 
@@ -44,10 +80,18 @@ void LuaRoot::restart() {
   m_luaEngine->setInstructionLimit(root.configuration()->get("scriptInstructionLimit").toUInt());
   m_luaEngine->setProfilingEnabled(root.configuration()->get("scriptProfilingEnabled").toBool());
   m_luaEngine->setInstructionMeasureInterval(root.configuration()->get("scriptInstructionMeasureInterval").toUInt());
+
+  m_profileSamples.clear();
+  setProfileSampleInterval(root.configuration()->get("scriptProfileSampleInterval").toUInt());
 }
 
 void LuaRoot::shutdown() {
   clearScriptCache();
+  MutexLocker locker(s_bytecodeCacheMutex);
+  auto bytecodeCache = s_bytecodeCache;
+  locker.unlock();
+  if (bytecodeCache)
+    bytecodeCache->save();
 
   if (!m_luaEngine)
     return;
@@ -152,14 +196,136 @@ void LuaRoot::addCallbacks(String const& groupName, LuaCallbacks const& callback
   m_luaCallbacks[groupName] = callbacks;
 }
 
+void LuaRoot::setProfileSampleInterval(unsigned sampleInterval) {
+  if (sampleInterval != m_profileSampleInterval) {
+    m_profileSampleInterval = sampleInterval;
+    clearSampledProfile();
+  }
+}
+
+unsigned LuaRoot::profileSampleInterval() const {
+  return m_profileSampleInterval;
+}
+
+void LuaRoot::setProfileCategory(String const& category) {
+  if (m_profileSampleInterval != 0)
+    m_profileCategory = category;
+}
+
+List<LuaScriptProfileEntry> LuaRoot::sampledProfile(size_t count) const {
+  List<LuaScriptProfileEntry const*> entries;
+  for (auto const& p : m_profileEntries)
+    entries.append(&p.second);
+
+  count = min(count, entries.size());
+  std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), [](auto a, auto b) {
+      return a->selfTime > b->selfTime;
+    });
+
+  List<LuaScriptProfileEntry> profile;
+  for (size_t i = 0; i < count; ++i)
+    profile.append(*entries[i]);
+  return profile;
+}
+
+StringList LuaRoot::sampledProfileReport(size_t count) const {
+  double seconds = max(Time::monotonicMicroseconds() - m_profileStartTime, (int64_t)1) / 1000000.0;
+  double scale = m_profileSampleInterval / seconds;
+
+  StringList report;
+  for (auto const& entry : sampledProfile(count)) {
+    report.append(strf("{} {} ({}): {:.2f}ms/s self, {:.2f}ms/s total, {:.0f} instructions/s, {:.1f}KiB/s allocated, {} samples",
+        entry.category, entry.function, entry.scripts, entry.selfTime * scale / 1000.0, entry.totalTime * scale / 1000.0,
+        entry.instructions * scale, entry.allocatedBytes * scale / 1024.0, entry.samples));
+  }
+  return report;
+}
+
+void LuaRoot::clearSampledProfile() {
+  m_profileEntries.clear();
+  m_profileInvocations = 0;
+  m_profileStartTime = Time::monotonicMicroseconds();
+}
+
+void LuaRoot::logSampledProfile(String const& prefix, size_t count) {
+  if (m_profileSampleInterval == 0 && m_profileLogKeys.empty())
+    return;
+
+  StringList report;
+  if (m_profileSampleInterval != 0)
+    report = sampledProfileReport(count);
+
+  StringList logKeys;
+  for (size_t i = 0; i < report.size(); ++i) {
+    logKeys.append(strf("{}_{}", prefix, i + 1));
+    LogMap::set(logKeys.last(), report[i]);
+  }
+
+  for (auto const& key : m_profileLogKeys) {
+    if (!logKeys.contains(key))
+      LogMap::remove(key);
+  }
+  m_profileLogKeys = std::move(logKeys);
+}
+
+bool LuaRoot::beginProfileSample() {
+  if (m_profileSampleInterval == 0 || !m_luaEngine)
+    return false;
+
+  // Everything invoked from within a sampled invocation is sampled as well, so
+  // that it can be subtracted out of the self cost of the outer invocation.
+  if (m_profileSamples.empty() && ++m_profileInvocations % m_profileSampleInterval != 0)
+    return false;
+
+  // Instructions are only counted every measure interval, which is usually
+  // far longer than a single invocation, so it is shortened while sampling.
+  if (m_profileSamples.empty()) {
+    m_profileMeasureInterval = m_luaEngine->instructionMeasureInterval();
+    m_luaEngine->setInstructionMeasureInterval(min(m_profileMeasureInterval, ProfileInstructionMeasureInterval));
+  }
+
+  m_profileSamples.append({Time::monotonicMicroseconds(), m_luaEngine->instructionCount(), m_luaEngine->allocatedBytes(), 0, 0, 0});
+  return true;
+}
+
+void LuaRoot::endProfileSample(StringList const& scripts, String const& function) {
+  if (m_profileSamples.empty() || !m_luaEngine)
+    return;
+
+  auto sample = m_profileSamples.takeLast();
+  int64_t time = Time::monotonicMicroseconds() - sample.startTime;
+  uint64_t instructions = m_luaEngine->instructionCount() - sample.startInstructions;
+  uint64_t allocatedBytes = m_luaEngine->allocatedBytes() - sample.startAllocatedBytes;
+  if (m_profileSamples.empty())
+    m_luaEngine->setInstructionMeasureInterval(m_profileMeasureInterval);
+
+  String scriptNames = scripts.join(", ");
+  auto& entry = m_profileEntries[make_tuple(m_profileCategory, scriptNames, function)];
+  if (entry.samples++ == 0) {
+    entry.category = m_profileCategory;
+    entry.scripts = std::move(scriptNames);
+    entry.function = function;
+  }
+  entry.totalTime += time;
+  entry.selfTime += time - sample.nestedTime;
+  entry.instructions += instructions - sample.nestedInstructions;
+  entry.allocatedBytes += allocatedBytes - sample.nestedAllocatedBytes;
+
+  if (!m_profileSamples.empty()) {
+    auto& parent = m_profileSamples.last();
+    parent.nestedTime += time;
+    parent.nestedInstructions += instructions;
+    parent.nestedAllocatedBytes += allocatedBytes;
+  }
+}
+
 LuaEngine& LuaRoot::luaEngine() const {
   return *m_luaEngine;
 }
 
 void LuaRoot::ScriptCache::loadScript(LuaEngine& engine, String const& assetPath) {
-  auto assets = Root::singleton().assets();
   RecursiveMutexLocker locker(mutex);
-  scripts[assetPath] = engine.compile(*assets->bytes(assetPath), assetPath);
+  scripts[assetPath] = bytecodeCache(engine)->compile(engine, assetPath, *Root::singleton().assets()->bytes(assetPath));
 }
 
 bool LuaRoot::ScriptCache::scriptLoaded(String const& assetPath) const {
@@ -181,15 +347,26 @@ void LuaRoot::ScriptCache::loadContextScript(LuaContext& context, String const&
   RecursiveMutexLocker locker(mutex);
   if (!scriptLoaded(assetPath))
     loadScript(context.engine(), assetPath);
-  context.load(scripts.get(assetPath));
+  context.load(*scripts.get(assetPath));
 }
 
 size_t LuaRoot::ScriptCache::memoryUsage() const {
   RecursiveMutexLocker locker(mutex);
   size_t total = 0;
   for (auto const& p : scripts)
-    total += p.second.size();
+    total += p.second->size();
   return total;
 }
 
+LuaProfileSample::LuaProfileSample(LuaRoot* root, StringList const& scripts, String const& function)
+  : m_root(nullptr), m_scripts(scripts), m_function(function) {
+  if (root && root->beginProfileSample())
+    m_root = root;
+}
+
+LuaProfileSample::~LuaProfileSample() {
+  if (m_root)
+    m_root->endProfileSample(m_scripts, m_function);
+}
+
 }
@@ -8,6 +8,24 @@ namespace Star {
 
 STAR_CLASS(LuaRoot);
 
+struct LuaScriptProfileEntry {
+  // What the script was invoked for, such as the type of entity being updated
+  String category;
+  // Scripts of the context the function was invoked in
+  String scripts;
+  // Name of the invoked function, such as "update" or a message name
+  String function;
+  // Number of sampled invocations
+  uint64_t samples;
+  // Time in microseconds, excluding sampled invocations nested inside
+  int64_t selfTime;
+  // Time in microseconds, including sampled invocations nested inside
+  int64_t totalTime;
+  // Instructions and allocated bytes, excluding nested sampled invocations
+  uint64_t instructions;
+  uint64_t allocatedBytes;
+};
+
 // Loads and caches lua scripts from assets.  Automatically clears cache on
 // root reload.  Uses an internal LuaEngine, so this and all contexts are meant
 // for single threaded access and have no locking.
@@ -43,6 +61,41 @@ public:
 
   void addCallbacks(String const& groupName, LuaCallbacks const& callbacks);
 
+  // Instructions in sampled invocations are counted in steps of this many, so
+  // shorter invocations may show as 0 or 1 instructions.  Nothing is counted
+  // unless the engine has an instruction limit or profiling enabled.
+  static constexpr unsigned ProfileInstructionMeasureInterval = 100;
+
+  // Sampled profiling of script invocations, cheap enough to leave running on
+  // a live server.  One in every 'sampleInterval' invocations is measured,
+  // along with everything invoked from inside of it, and its wall time,
+  // instructions and allocations are attributed to the current category, the
+  // invoking scripts and the function.  0 disables sampling.
+  void setProfileSampleInterval(unsigned sampleInterval);
+  unsigned profileSampleInterval() const;
+
+  // Every invocation is attributed to this category until it is changed.
+  // Ignored while sampling is disabled, callers that build the category per
+  // invocation should check profileSampleInterval() first.
+  void setProfileCategory(String const& category);
+
+  // Returns at most 'count' of the sampled entries with the highest self time,
+  // since sampling was enabled or the profile was last cleared.
+  List<LuaScriptProfileEntry> sampledProfile(size_t count = NPos) const;
+  // Prints sampled entries, scaled up by the sample interval to estimate the
+  // cost of each one per second.
+  StringList sampledProfileReport(size_t count = NPos) const;
+  void clearSampledProfile();
+  // Sets the top 'count' lines of the report in LogMap as '<prefix>_<n>', and
+  // removes any previously set lines that are no longer in the report, which
+  // is all of them once sampling is disabled.
+  void logSampledProfile(String const& prefix, size_t count);
+
+  // Used by LuaProfileSample, returns true if the next invocation is sampled,
+  // in which case endProfileSample must be called after it.
+  bool beginProfileSample();
+  void endProfileSample(StringList const& scripts, String const& function);
+
   LuaEngine& luaEngine() const;
 private:
   class ScriptCache {
@@ -56,7 +109,16 @@ private:
 
   private:
     mutable RecursiveMutex mutex;
-    StringMap<ByteArray> scripts;
+    StringMap<ByteArrayConstPtr> scripts;
+  };
+
+  struct ProfileSample {
+    int64_t startTime;
+    uint64_t startInstructions;
+    uint64_t startAllocatedBytes;
+    int64_t nestedTime;
+    uint64_t nestedInstructions;
+    uint64_t nestedAllocatedBytes;
   };
 
   LuaEnginePtr m_luaEngine;
@@ -66,6 +128,33 @@ private:
   ListenerPtr m_rootReloadListener;
 
   String m_storageDirectory;
+
+  unsigned m_profileSampleInterval;
+  uint64_t m_profileInvocations;
+  int64_t m_profileStartTime;
+  String m_profileCategory;
+  // The engine's own instruction measure interval, restored once the
+  // outermost sampled invocation ends.
+  unsigned m_profileMeasureInterval;
+  List<ProfileSample> m_profileSamples;
+  HashMap<tuple<String, String, String>, LuaScriptProfileEntry> m_profileEntries;
+  StringList m_profileLogKeys;
+};
+
+// Measures a script invocation from construction to destruction, if
+// LuaRoot sampled profiling picks it.
+class LuaProfileSample {
+public:
+  LuaProfileSample(LuaRoot* root, StringList const& scripts, String const& function);
+  ~LuaProfileSample();
+
+  LuaProfileSample(LuaProfileSample const&) = delete;
+  LuaProfileSample& operator=(LuaProfileSample const&) = delete;
+
+private:
+  LuaRoot* m_root;
+  StringList const& m_scripts;
+  String const& m_function;
 };
 
 }
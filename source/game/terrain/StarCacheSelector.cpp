@@ -23,4 +23,24 @@ float CacheSelector::get(int x, int y) const {
     });
 }
 
+void CacheSelector::getRegion(RectI const& region, float* out) const {
+  // Evaluate the source over the whole region if any of it is not cached
+  size_t i = 0;
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    for (int x = region.xMin(); x < region.xMax(); ++x) {
+      auto value = m_cache.ptr(Vec2I(x, y));
+      if (!value) {
+        m_source->getRegion(region, out);
+        i = 0;
+        for (int ry = region.yMin(); ry < region.yMax(); ++ry) {
+          for (int rx = region.xMin(); rx < region.xMax(); ++rx)
+            m_cache.set(Vec2I(rx, ry), out[i++]);
+        }
+        return;
+      }
+      out[i++] = *value;
+    }
+  }
+}
+
 }
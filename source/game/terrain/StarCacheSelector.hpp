@@ -12,6 +12,7 @@ struct CacheSelector : TerrainSelector {
   CacheSelector(Json const& config, TerrainSelectorParameters const& parameters, TerrainDatabase const* database);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
   TerrainSelectorConstPtr m_source;
   mutable HashLruCache<Vec2I, float> m_cache;
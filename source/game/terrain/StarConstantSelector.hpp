@@ -10,6 +10,7 @@ struct ConstantSelector : TerrainSelector {
   ConstantSelector(Json const& config, TerrainSelectorParameters const& parameters);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
   float m_value;
 };
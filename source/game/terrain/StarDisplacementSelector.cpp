@@ -53,6 +53,31 @@ float DisplacementSelector::get(int x, int y) const {
   return m_source->get(x_, y_);
 }
 
+void DisplacementSelector::getRegion(RectI const& region, float* out) const {
+  int width = region.width();
+  List<float> xXValues(width);
+  List<float> yXValues(width);
+  for (int i = 0; i < width; ++i) {
+    xXValues[i] = (region.xMin() + i) * xXInfluence;
+    yXValues[i] = (region.xMin() + i) * yXInfluence;
+  }
+
+  List<float> xDisplacement(width);
+  List<float> yDisplacement(width);
+  List<Vec2I> points;
+  points.reserve(region.volume());
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    xDisplacementFunction.getRow(xXValues.ptr(), y * xYInfluence, xDisplacement.ptr(), width);
+    yDisplacementFunction.getRow(yXValues.ptr(), y * yYInfluence, yDisplacement.ptr(), width);
+    for (int i = 0; i < width; ++i) {
+      auto x_ = region.xMin() + i + xDisplacement[i];
+      auto y_ = y + clampY(yDisplacement[i]);
+      points.append(Vec2I((int)x_, (int)y_));
+    }
+  }
+  m_source->getPoints(points, out);
+}
+
 float DisplacementSelector::clampY(float v) const {
   if (!yClamp)
     return v;
@@ -15,4 +15,11 @@ float FlatSurfaceSelector::get(int, int y) const {
   return flip * (surfaceLevel - (y - adjustment));
 }
 
+void FlatSurfaceSelector::getRegion(RectI const& region, float* out) const {
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    float value = get(0, y);
+    out = std::fill_n(out, region.width(), value);
+  }
+}
+
 }
@@ -47,4 +47,19 @@ float IslandSurfaceSelector::get(int x, int y) const {
   return (col.topLevel - col.bottomLevel) / 2 - abs((col.topLevel + col.bottomLevel) / 2 - y);
 }
 
+void IslandSurfaceSelector::getRegion(RectI const& region, float* out) const {
+  List<IslandColumn> columns;
+  columns.reserve(region.width());
+  for (int x = region.xMin(); x < region.xMax(); ++x) {
+    columns.append(columnCache.get(x, [=](int x) {
+        return IslandSurfaceSelector::generateColumn(x);
+      }));
+  }
+
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    for (auto const& col : columns)
+      *out++ = (col.topLevel - col.bottomLevel) / 2 - abs((col.topLevel + col.bottomLevel) / 2 - y);
+  }
+}
+
 }
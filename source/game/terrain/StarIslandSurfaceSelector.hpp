@@ -17,6 +17,7 @@ struct IslandSurfaceSelector : TerrainSelector {
   IslandSurfaceSelector(Json const& config, TerrainSelectorParameters const& parameters);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
   IslandColumn generateColumn(int x) const;
 
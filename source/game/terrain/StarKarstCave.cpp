@@ -36,6 +36,22 @@ float KarstCaveSelector::get(int x, int y) const {
     }).get(x, y);
 }
 
+void KarstCaveSelector::getRegion(RectI const& region, float* out) const {
+  // Fetch each sector overlapping the region only once
+  int width = region.width();
+  for (int sy = region.yMin() - pmod(region.yMin(), m_sectorSize); sy < region.yMax(); sy += m_sectorSize) {
+    for (int sx = region.xMin() - pmod(region.xMin(), m_sectorSize); sx < region.xMax(); sx += m_sectorSize) {
+      auto& sector = m_sectorCache.get(Vec2I(sx, sy), [=](Vec2I const& key) {
+          return Sector(this, key);
+        });
+      for (int y = max(sy, region.yMin()); y < min(sy + m_sectorSize, region.yMax()); ++y) {
+        for (int x = max(sx, region.xMin()); x < min(sx + m_sectorSize, region.xMax()); ++x)
+          out[(y - region.yMin()) * width + (x - region.xMin())] = sector.get(x, y);
+      }
+    }
+  }
+}
+
 KarstCaveSelector::Sector::Sector(KarstCaveSelector const* parent, Vec2I sector)
   : parent(parent), sector(sector), values(square(parent->m_sectorSize)) {
 
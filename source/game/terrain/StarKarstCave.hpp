@@ -14,6 +14,7 @@ public:
   KarstCaveSelector(Json const& config, TerrainSelectorParameters const& parameters);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
 private:
   struct LayerPerlins {
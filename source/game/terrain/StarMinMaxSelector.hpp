@@ -10,6 +10,7 @@ struct MinMaxSelector : TerrainSelector {
   MinMaxSelector(Json const& config, TerrainSelectorParameters const& parameters, TerrainDatabase const* database);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
   List<TerrainSelectorConstPtr> m_sources;
 };
@@ -26,4 +26,40 @@ float MixSelector::get(int x, int y) const {
   return lerp(f * 0.5f + 0.5f, m_aSource->get(x, y), m_bSource->get(x, y));
 }
 
+void MixSelector::getRegion(RectI const& region, float* out) const {
+  size_t count = region.volume();
+  m_mixSource->getRegion(region, out);
+
+  // Like get, only evaluates either source if some point in the region needs
+  // it.
+  bool needA = false;
+  bool needB = false;
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = clamp(out[i], -1.0f, 1.0f);
+    needA |= out[i] != 1;
+    needB |= out[i] != -1;
+  }
+
+  List<float> aValues;
+  if (needA) {
+    aValues.resize(count);
+    m_aSource->getRegion(region, aValues.ptr());
+  }
+  List<float> bValues;
+  if (needB) {
+    bValues.resize(count);
+    m_bSource->getRegion(region, bValues.ptr());
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    float f = out[i];
+    if (f == -1)
+      out[i] = aValues[i];
+    else if (f == 1)
+      out[i] = bValues[i];
+    else
+      out[i] = lerp(f * 0.5f + 0.5f, aValues[i], bValues[i]);
+  }
+}
+
 }
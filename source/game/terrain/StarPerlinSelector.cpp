@@ -27,4 +27,16 @@ float PerlinSelector::get(int x, int y) const {
   return function.get(x * xInfluence, y * yInfluence);
 }
 
+void PerlinSelector::getRegion(RectI const& region, float* out) const {
+  List<float> xValues;
+  xValues.reserve(region.width());
+  for (int x = region.xMin(); x < region.xMax(); ++x)
+    xValues.append(x * xInfluence);
+
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    function.getRow(xValues.ptr(), y * yInfluence, out, xValues.size());
+    out += xValues.size();
+  }
+}
+
 }
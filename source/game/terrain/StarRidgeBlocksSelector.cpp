@@ -32,4 +32,28 @@ float RidgeBlocksSelector::get(int x, int y) const {
   }
 }
 
+void RidgeBlocksSelector::getRegion(RectI const& region, float* out) const {
+  if (commonality <= 0.0f) {
+    std::fill_n(out, region.volume(), 0.0f);
+    return;
+  }
+
+  int width = region.width();
+  List<float> xValues(width);
+  for (int i = 0; i < width; ++i)
+    xValues[i] = region.xMin() + i;
+
+  // Only the x displacement samples along the row, the y displacement and the
+  // ridges are sampled at the displaced points and cannot be batched.
+  List<float> xDisplacement(width);
+  for (int y = region.yMin(); y < region.yMax(); ++y) {
+    noisePerlin.getRow(xValues.ptr(), y, xDisplacement.ptr(), width);
+    for (int i = 0; i < width; ++i) {
+      int x_ = xValues[i] + xDisplacement[i];
+      int y_ = y + noisePerlin.get(y, x_);
+      *out++ = (ridgePerlin1.get(x_, y_) - ridgePerlin2.get(x_, y_)) * commonality + bias;
+    }
+  }
+}
+
 }
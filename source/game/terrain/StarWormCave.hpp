@@ -30,6 +30,7 @@ public:
   WormCaveSelector(Json const& config, TerrainSelectorParameters const& parameters);
 
   float get(int x, int y) const override;
+  void getRegion(RectI const& region, float* out) const override;
 
 private:
   int m_sectorSize;
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "StarCellularLightArray.hpp"
+#include "StarCellularLighting.hpp"
+#include "StarRandom.hpp"
+
+// Lighting scenes shared by cellular_light_array_test and lighting_benchmark,
+// so that the benchmark times exactly what the tests check.
+
+namespace Star {
+
+unsigned const LightingFixtureSpreadPasses = 3;
+float const LightingFixtureSpreadMaxAir = 15.0f;
+float const LightingFixtureSpreadMaxObstacle = 4.0f;
+
+// Roughly the number of visible tiles on a 4K display zoomed all the way out,
+// plus the ambient lighting border around them.
+size_t const LightingFixtureViewWidth = 480;
+size_t const LightingFixtureViewHeight = 270;
+
+// The cell by cell spread algorithm that the column based one replaces, used
+// as a reference for its results and its speed.
+template <typename LightTraits>
+void referenceLightSpread(List<typename CellularLightArray<LightTraits>::Cell>& cells, size_t height,
+    size_t xMin, size_t yMin, size_t xMax, size_t yMax) {
+  float dropoffAir = 1.0f / LightingFixtureSpreadMaxAir;
+  float dropoffObstacle = 1.0f / LightingFixtureSpreadMaxObstacle;
+  float dropoffAirDiag = 1.0f / LightingFixtureSpreadMaxAir * Constants::sqrt2;
+  float dropoffObstacleDiag = 1.0f / LightingFixtureSpreadMaxObstacle * Constants::sqrt2;
+
+  for (unsigned p = 0; p < LightingFixtureSpreadPasses; ++p) {
+    for (size_t x = xMin + 1; x < xMax - 1; ++x) {
+      for (size_t y = yMin + 1; y < yMax - 1; ++y) {
+        auto cell = cells[x * height + y];
+        float straightDropoff = cell.obstacle ? dropoffObstacle : dropoffAir;
+        float diagDropoff = cell.obstacle ? dropoffObstacleDiag : dropoffAirDiag;
+
+        for (auto i : {(x + 1) * height + y, x * height + y + 1})
+          cells[i].light = LightTraits::spread(cell.light, cells[i].light, straightDropoff);
+        for (auto i : {(x + 1) * height + y + 1, (x + 1) * height + y - 1})
+          cells[i].light = LightTraits::spread(cell.light, cells[i].light, diagDropoff);
+      }
+    }
+
+    for (size_t x = xMax - 2; x > xMin; --x) {
+      for (size_t y = yMax - 2; y > yMin; --y) {
+        auto cell = cells[x * height + y];
+        float straightDropoff = cell.obstacle ? dropoffObstacle : dropoffAir;
+        float diagDropoff = cell.obstacle ? dropoffObstacleDiag : dropoffAirDiag;
+
+        for (auto i : {(x - 1) * height + y, x * height + y - 1})
+          cells[i].light = LightTraits::spread(cell.light, cells[i].light, straightDropoff);
+        for (auto i : {(x - 1) * height + y + 1, (x - 1) * height + y - 1})
+          cells[i].light = LightTraits::spread(cell.light, cells[i].light, diagDropoff);
+      }
+    }
+  }
+}
+
+// Sets up a view sized light array with random obstacles and spread lights,
+// and returns a copy of its cells before any spreading.
+template <typename LightTraits>
+List<typename CellularLightArray<LightTraits>::Cell> beginLightSpreadFixture(CellularLightArray<LightTraits>& lightArray,
+    RandomSource& rand, function<typename LightTraits::Value(RandomSource&)> randomLight) {
+  lightArray.setParameters(LightingFixtureSpreadPasses, LightingFixtureSpreadMaxAir, LightingFixtureSpreadMaxObstacle, 0.0f, 1.0f, 0.0f, false);
+
+  size_t border = lightArray.borderCells();
+  size_t width = LightingFixtureViewWidth + border * 2;
+  size_t height = LightingFixtureViewHeight + border * 2;
+  lightArray.begin(width, height);
+
+  for (size_t x = 0; x < width; ++x) {
+    for (size_t y = 0; y < height; ++y) {
+      lightArray.setObstacle(x, y, rand.randf() < 0.4f);
+      if (rand.randf() < 0.02f)
+        lightArray.setLight(x, y, randomLight(rand));
+    }
+  }
+
+  List<typename CellularLightArray<LightTraits>::Cell> cells;
+  for (size_t i = 0; i < width * height; ++i)
+    cells.append(lightArray.cellAtIndex(i));
+  return cells;
+}
+
+// A view sized colored lighting scene with random cells, spread lights and
+// point lights, including a few point lights bright enough to reach across
+// several threaded strips along a band of rows without obstacles.
+struct ColoredLightingFixture {
+  Json config;
+  RectI queryRegion;
+  int clearRow;
+  List<pair<Vec2F, Vec3F>> spreadLights;
+  List<pair<Vec2F, Vec3F>> pointLights;
+  List<pair<Vec3F, bool>> cells;
+
+  // Starts a calculation of the scene with the given number of threads, ready
+  // for CellularLightingCalculator::calculate.
+  void begin(CellularLightingCalculator& calculator, unsigned threadCount) const {
+    calculator.setParameters(config);
+    calculator.setThreadCount(threadCount);
+    calculator.begin(queryRegion);
+    for (size_t i = 0; i < cells.size(); ++i)
+      calculator.setCellIndex(i, cells[i].first, cells[i].second);
+    for (auto const& light : spreadLights)
+      calculator.addSpreadLight(light.first, light.second);
+    for (auto const& light : pointLights)
+      calculator.addPointLight(light.first, light.second, 0.0f, 0.0f, 0.0f);
+  }
+};
+
+inline ColoredLightingFixture makeColoredLightingFixture(uint64_t seed) {
+  RandomSource rand(seed);
+  ColoredLightingFixture fixture;
+  fixture.config = JsonObject{
+    {"spreadPasses", LightingFixtureSpreadPasses},
+    {"spreadMaxAir", LightingFixtureSpreadMaxAir},
+    {"spreadMaxObstacle", LightingFixtureSpreadMaxObstacle},
+    {"pointMaxAir", 20.0f},
+    {"pointMaxObstacle", 5.0f},
+    {"pointObstacleBoost", 1.0f},
+    {"pointAdditive", true},
+    {"brightnessLimit", 1.0f}
+  };
+
+  RectI queryRegion = RectI::withSize(Vec2I(-100, 200), Vec2I(LightingFixtureViewWidth, LightingFixtureViewHeight));
+  fixture.queryRegion = queryRegion;
+  for (size_t i = 0; i < 200; ++i) {
+    Vec2F position = Vec2F(queryRegion.min())
+        + Vec2F(rand.randf(-20.0f, LightingFixtureViewWidth + 20.0f), rand.randf(-20.0f, LightingFixtureViewHeight + 20.0f));
+    Vec3F light(rand.randf(), rand.randf(), rand.randf());
+    if (i % 2 == 0)
+      fixture.spreadLights.append({position, light});
+    else
+      fixture.pointLights.append({position, light});
+  }
+
+  fixture.clearRow = queryRegion.yMin() + 100;
+  for (size_t i = 0; i < 4; ++i) {
+    Vec2F position(queryRegion.xMin() + rand.randf(0.0f, LightingFixtureViewWidth), fixture.clearRow + 0.5f);
+    fixture.pointLights.append({position, Vec3F(4.0f, 3.0f, 2.0f)});
+  }
+
+  CellularLightingCalculator calculator;
+  calculator.setParameters(fixture.config);
+  calculator.begin(queryRegion);
+  RectI calculationRegion = calculator.calculationRegion();
+  for (int x = calculationRegion.xMin(); x < calculationRegion.xMax(); ++x) {
+    for (int y = calculationRegion.yMin(); y < calculationRegion.yMax(); ++y) {
+      Vec3F light = rand.randf() < 0.02f ? Vec3F(rand.randf(), rand.randf(), rand.randf()) : Vec3F();
+      bool obstacle = rand.randf() < 0.4f;
+      fixture.cells.append({light, obstacle && abs(y - fixture.clearRow) > 2});
+    }
+  }
+
+  return fixture;
+}
+
+}
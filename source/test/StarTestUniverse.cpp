@@ -58,6 +58,10 @@ void TestUniverse::update(unsigned times) {
   }
 }
 
+String TestUniverse::adminCommand(String const& command) {
+  return m_server->adminCommand(command);
+}
+
 List<Drawable> TestUniverse::currentClientDrawables() {
   WorldRenderData renderData;
   auto worldClient = m_client->worldClient();
@@ -15,6 +15,8 @@ public:
 
   void update(unsigned times = 1);
 
+  String adminCommand(String const& command);
+
   List<Drawable> currentClientDrawables();
 
 private:
@@ -254,3 +254,76 @@ TEST(BTreeDatabaseTest, Threading) {
   }
 }
 
+
+TEST(BTreeDatabaseTest, CommittedReads) {
+  auto tmpFile = File::temporaryFile();
+  auto finallyGuard = finally([&tmpFile]() { tmpFile->remove(); });
+
+  BTreeDatabase db("TestDB", 4);
+  db.setAutoCommit(false);
+  db.setBlockSize(256);
+  db.setIODevice(tmpFile);
+  db.open();
+
+  List<uint32_t> keySet;
+  while (keySet.size() < 5000)
+    keySet.append(Random::randu32() % MaxKey);
+
+  // Uncommitted writes are only visible to the regular read methods.
+  db.insert(toByteArray(keySet[0]), genBlock(keySet[0]));
+  EXPECT_TRUE(db.find(toByteArray(keySet[0])).isValid());
+  EXPECT_FALSE(db.findCommitted(toByteArray(keySet[0])).isValid());
+  db.commit();
+  EXPECT_TRUE(db.findCommitted(toByteArray(keySet[0])).isValid());
+
+  atomic<bool> writing(true);
+  auto writer = Thread::invoke("databaseTestWriter",
+      [&db, &keySet, &writing]() {
+        auto doneGuard = finally([&writing]() { writing = false; });
+        try {
+          for (uint32_t k : keySet) {
+            db.insert(toByteArray(k), genBlock(k));
+            if (Random::randi32() % 7 == 0)
+              db.remove(toByteArray(Random::randFrom(keySet)));
+            if (Random::randi32() % 23 == 0)
+              db.commit();
+          }
+          db.commit();
+        } catch (std::exception const& e) {
+          SCOPED_TRACE(outputException(e, true));
+          FAIL();
+        }
+      });
+
+  List<ThreadFunction<void>> readers;
+  for (size_t i = 0; i < 4; ++i) {
+    readers.append(Thread::invoke("databaseTestReader",
+        [&db, &keySet, &writing]() {
+          try {
+            while (writing) {
+              uint32_t k = Random::randFrom(keySet);
+              if (auto res = db.findCommitted(toByteArray(k))) {
+                EXPECT_TRUE(checkBlock(k, *res));
+              }
+
+              db.forEachCommitted(toByteArray(k), toByteArray(k + 100), [](ByteArray key, ByteArray value) {
+                  EXPECT_TRUE(checkBlock(fromBigEndian(*(uint32_t*)key.ptr()), value));
+                });
+            }
+          } catch (std::exception const& e) {
+            SCOPED_TRACE(outputException(e, true));
+            FAIL();
+          }
+        }));
+  }
+
+  writer.finish();
+  for (auto& reader : readers)
+    reader.finish();
+
+  size_t count = 0;
+  db.forAllCommitted([&count](ByteArray, ByteArray) { ++count; });
+  EXPECT_EQ(count, db.recordCount());
+
+  db.close();
+}
@@ -0,0 +1,66 @@
+#include "StarCellularLightingFixture.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  template <typename LightTraits>
+  void testSpread(function<typename LightTraits::Value(RandomSource&)> randomLight, function<float(typename LightTraits::Value const&, typename LightTraits::Value const&)> difference) {
+    RandomSource rand(113);
+    CellularLightArray<LightTraits> lightArray;
+    auto referenceCells = beginLightSpreadFixture<LightTraits>(lightArray, rand, randomLight);
+
+    size_t border = lightArray.borderCells();
+    size_t width = LightingFixtureViewWidth + border * 2;
+    size_t height = LightingFixtureViewHeight + border * 2;
+    referenceLightSpread<LightTraits>(referenceCells, height, 0, 0, width, height);
+    lightArray.calculate(border, border, width - border, height - border);
+
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < width * height; ++i)
+      maxDifference = max(maxDifference, difference(lightArray.cellAtIndex(i).light, referenceCells[i].light));
+    EXPECT_LT(maxDifference, 0.0001f);
+  }
+}
+
+TEST(CellularLightArrayTest, ScalarSpread) {
+  testSpread<ScalarLightTraits>(
+      [](RandomSource& rand) { return rand.randf(); },
+      [](float a, float b) { return fabs(a - b); });
+}
+
+TEST(CellularLightArrayTest, ColoredSpread) {
+  testSpread<ColoredLightTraits>(
+      [](RandomSource& rand) { return Vec3F(rand.randf(), rand.randf(), rand.randf()); },
+      [](Vec3F const& a, Vec3F const& b) { return max(fabs(a[0] - b[0]), max(fabs(a[1] - b[1]), fabs(a[2] - b[2]))); });
+}
+
+TEST(CellularLightArrayTest, ThreadedCalculation) {
+  auto fixture = makeColoredLightingFixture(114);
+  CellularLightingCalculator calculator;
+  auto calculate = [&](unsigned threadCount, Lightmap& lightmap) {
+    fixture.begin(calculator, threadCount);
+    calculator.calculate(lightmap);
+  };
+
+  Lightmap single;
+  calculate(1, single);
+
+  for (unsigned threadCount : {2, 3, 4, 8}) {
+    Lightmap threaded;
+    calculate(threadCount, threaded);
+    ASSERT_EQ(threaded.size(), single.size());
+
+    float maxDifference = 0.0f;
+    for (unsigned x = 0; x < single.width(); ++x) {
+      for (unsigned y = 0; y < single.height(); ++y) {
+        Vec3F difference = threaded.get(x, y) - single.get(x, y);
+        maxDifference = max(maxDifference, max(fabs(difference[0]), max(fabs(difference[1]), fabs(difference[2]))));
+      }
+    }
+    // Point light attenuation is traced relative to the origin of each strip,
+    // so it rounds a little differently, but well under one 8 bit step.
+    EXPECT_LT(maxDifference, 0.001f);
+  }
+}
@@ -0,0 +1,158 @@
+#include "StarCellularLiquid.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  typedef uint8_t TestLiquidId;
+
+  // A closed basin of flow cells, surrounded by collision.
+  struct TestLiquidWorld : CellularLiquidWorld<TestLiquidId> {
+    TestLiquidWorld(int width, int height)
+      : width(width), height(height), cells(width * height, CellularLiquidFlowCell<TestLiquidId>{{}, 0.0f, 0.0f}), drain(-1, -1), drainRate(0.0f) {}
+
+    CellularLiquidCell<TestLiquidId> cell(Vec2I const& location) const override {
+      if (location[0] < 0 || location[0] >= width || location[1] < 0 || location[1] >= height)
+        return CellularLiquidCollisionCell();
+      return cells[location[0] * height + location[1]];
+    }
+
+    void setFlow(Vec2I const& location, CellularLiquidFlowCell<TestLiquidId> const& flow) override {
+      cells[location[0] * height + location[1]] = flow;
+    }
+
+    float drainLevel(Vec2I const& location) const override {
+      return location == drain ? drainRate : 0.0f;
+    }
+
+    float totalLevel() const {
+      float total = 0.0f;
+      for (auto const& cell : cells)
+        total += cell.level;
+      return total;
+    }
+
+    int width;
+    int height;
+    List<CellularLiquidFlowCell<TestLiquidId>> cells;
+    Vec2I drain;
+    float drainRate;
+  };
+
+  // Every processed chunk counts as settled, so chunks go to sleep after a
+  // fixed number of updates regardless of what the liquid is doing.
+  LiquidCellEngineParameters testParameters(float minimumChunkWakeChange) {
+    LiquidCellEngineParameters parameters;
+    parameters.lateralMoveFactor = 0.4f;
+    parameters.spreadOverfillUpFactor = 0.2f;
+    parameters.spreadOverfillLateralFactor = 0.5f;
+    parameters.spreadOverfillDownFactor = 0.2f;
+    parameters.pressureEqualizeFactor = 0.3f;
+    parameters.pressureMoveFactor = 0.3f;
+    parameters.maximumPressureLevelImbalance = 0.1f;
+    parameters.minimumLivenPressureChange = 0.01f;
+    parameters.minimumLivenLevelChange = 0.005f;
+    parameters.minimumLiquidLevel = 0.01f;
+    parameters.interactTransformationLevel = 0.1f;
+    parameters.maximumSleepingChunkChange = highest<float>();
+    parameters.chunkSleepUpdates = 5;
+    parameters.minimumChunkWakeChange = minimumChunkWakeChange;
+    return parameters;
+  }
+
+  // A column of liquid on the left side of the basin
+  void pour(TestLiquidWorld& world, LiquidCellEngine<TestLiquidId>& engine) {
+    for (int x = 0; x < 8; ++x) {
+      for (int y = 0; y < world.height; ++y)
+        world.setFlow({x, y}, {TestLiquidId(1), 1.0f, 0.0f});
+    }
+    engine.visitRegion(RectI(0, 0, world.width, world.height));
+  }
+}
+
+TEST(CellularLiquidTest, ChunkSleep) {
+  auto world = make_shared<TestLiquidWorld>(64, 32);
+  LiquidCellEngine<TestLiquidId> engine(testParameters(highest<float>()), world);
+  pour(*world, engine);
+
+  for (size_t i = 0; i < 10; ++i)
+    engine.update();
+  EXPECT_EQ(engine.activeCells(), 0u);
+  EXPECT_GT(engine.sleepingCells(), 0u);
+  EXPECT_TRUE(engine.isSleeping({4, 20}));
+
+  // Nothing moves while everything is asleep
+  auto cells = world->cells;
+  for (size_t i = 0; i < 10; ++i)
+    engine.update();
+  for (size_t i = 0; i < cells.size(); ++i)
+    EXPECT_EQ(world->cells[i].level, cells[i].level);
+
+  // Visiting from outside of the engine wakes the chunk back up
+  engine.visitLocation({4, 20});
+  engine.update();
+  EXPECT_FALSE(engine.isSleeping({4, 20}));
+  EXPECT_GT(engine.activeCells(), 0u);
+}
+
+TEST(CellularLiquidTest, ChunkWake) {
+  auto world = make_shared<TestLiquidWorld>(64, 32);
+  LiquidCellEngine<TestLiquidId> engine(testParameters(0.05f), world);
+  for (int x = 0; x < world->width; ++x) {
+    for (int y = 0; y < 16; ++y)
+      world->setFlow({x, y}, {TestLiquidId(1), 1.0f, 0.0f});
+  }
+  engine.visitRegion(RectI(0, 0, world->width, world->height));
+
+  // Every chunk of the flat layer is processed every update until they all go
+  // to sleep together
+  for (size_t i = 0; i < 10; ++i)
+    engine.update();
+  EXPECT_EQ(engine.activeCells(), 0u);
+  EXPECT_TRUE(engine.isSleeping({4, 0}));
+  EXPECT_TRUE(engine.isSleeping({20, 0}));
+
+  // Pouring in a column of liquid on top of the first chunk wakes only that
+  // chunk, and once that pushes liquid into the next chunk it wakes up as well
+  for (int x = 10; x < 14; ++x) {
+    for (int y = 16; y < world->height; ++y)
+      world->setFlow({x, y}, {TestLiquidId(1), 1.0f, 0.0f});
+  }
+  engine.visitRegion(RectI(10, 16, 14, world->height));
+  engine.update();
+  EXPECT_FALSE(engine.isSleeping({4, 0}));
+  EXPECT_TRUE(engine.isSleeping({36, 0}));
+  for (size_t i = 0; i < 10 && engine.isSleeping({20, 0}); ++i)
+    engine.update();
+  EXPECT_FALSE(engine.isSleeping({20, 0}));
+}
+
+TEST(CellularLiquidTest, SlowDrain) {
+  // Every cell of a pool with a slow drain in one corner changes by less
+  // than the sleep threshold each update, but the pool must still drain just
+  // as far as it does without sleep.
+  auto drainPool = [](unsigned chunkSleepUpdates) {
+    auto world = make_shared<TestLiquidWorld>(16, 16);
+    world->drain = Vec2I(0, 0);
+    world->drainRate = 0.02f;
+    auto parameters = testParameters(0.1f);
+    parameters.maximumSleepingChunkChange = 0.03f;
+    parameters.chunkSleepUpdates = chunkSleepUpdates;
+    LiquidCellEngine<TestLiquidId> engine(parameters, world);
+    for (int x = 0; x < world->width; ++x) {
+      for (int y = 0; y < 4; ++y)
+        world->setFlow({x, y}, {TestLiquidId(1), 1.0f, 0.0f});
+    }
+    engine.visitRegion(RectI(0, 0, world->width, world->height));
+
+    for (size_t i = 0; i < 4000; ++i)
+      engine.update();
+    EXPECT_EQ(engine.activeCells(), 0u);
+    return world->totalLevel();
+  };
+
+  float unslept = drainPool(0);
+  EXPECT_LT(unslept, 8.0f);
+  EXPECT_NEAR(drainPool(5), unslept, 0.5f);
+}
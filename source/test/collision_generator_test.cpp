@@ -0,0 +1,87 @@
+#include "StarCollisionGenerator.hpp"
+#include "StarWorldImpl.hpp"
+#include "StarRandom.hpp"
+#include "StarMap.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+TEST(CollisionGeneratorTest, PartialRegions) {
+  // Collision geometry is regenerated for only the dirty part of a world, so
+  // generating any part of a region must give the same blocks for each space
+  // as generating the whole region at once.
+  RandomSource rand(311);
+  MultiArray<CollisionKind, 2> kinds(60, 60);
+  List<CollisionKind> choices = {CollisionKind::None, CollisionKind::None, CollisionKind::Platform, CollisionKind::Dynamic, CollisionKind::Block};
+  for (size_t x = 0; x < kinds.size(0); ++x) {
+    for (size_t y = 0; y < kinds.size(1); ++y)
+      kinds(x, y) = rand.randFrom(choices);
+  }
+  auto accessor = [&kinds](int x, int y) {
+    if (x < 0 || y < 0 || x >= (int)kinds.size(0) || y >= (int)kinds.size(1))
+      return CollisionKind::None;
+    return kinds(x, y);
+  };
+
+  auto blockPolys = [](List<CollisionBlock> const& blocks) {
+    Map<Vec2I, List<PolyF>> polys;
+    for (auto const& block : blocks)
+      polys[block.space].append(block.poly);
+    return polys;
+  };
+
+  CollisionGenerator generator;
+  auto expected = blockPolys(generator.getBlocks(RectI(0, 0, 60, 60), accessor));
+  EXPECT_FALSE(expected.empty());
+
+  List<CollisionBlock> partBlocks;
+  for (auto const& region : {RectI(0, 0, 60, 7), RectI(0, 7, 31, 60), RectI(31, 7, 60, 33), RectI(31, 33, 60, 60)})
+    partBlocks.appendAll(generator.getBlocks(region, accessor));
+  EXPECT_EQ(blockPolys(partBlocks), expected);
+
+  EXPECT_TRUE(generator.getBlocks(RectI::null(), accessor).empty());
+}
+
+TEST(CollisionGeneratorTest, FreshenWorldWideRegions) {
+  // Regions at least as wide as the world cover it exactly once, wherever
+  // they start, and must freshen the same blocks as the world itself.
+  RandomSource rand(312);
+  List<CollisionKind> choices = {CollisionKind::None, CollisionKind::None, CollisionKind::Platform, CollisionKind::Block};
+  auto makeTileArray = [&]() {
+    auto tileArray = make_shared<ServerTileSectorArray>(Vec2U(40, 40));
+    for (auto const& sector : tileArray->validSectorsFor(RectI(0, 0, 40, 40)))
+      tileArray->loadDefaultSector(sector);
+    return tileArray;
+  };
+
+  auto expectedArray = makeTileArray();
+  auto wideArray = makeTileArray();
+  for (int x = 0; x < 40; ++x) {
+    for (int y = 0; y < 40; ++y) {
+      CollisionKind kind = rand.randFrom(choices);
+      expectedArray->modifyTile({x, y})->collision = kind;
+      wideArray->modifyTile({x, y})->collision = kind;
+    }
+  }
+
+  CollisionGenerator generator;
+  auto freshen = [&generator](ServerTileSectorArrayPtr const& tileArray, RectI const& region) {
+    WorldImpl::freshenCollision(tileArray, generator, region, [&tileArray](int x, int y) {
+        return tileArray->tile({x, y}).getCollision();
+      });
+  };
+  freshen(expectedArray, RectI(0, 0, 40, 40));
+  freshen(wideArray, RectI(-13, 0, 45, 40));
+
+  for (int x = 0; x < 40; ++x) {
+    for (int y = 0; y < 40; ++y) {
+      auto const& expected = expectedArray->tile({x, y});
+      auto const& wide = wideArray->tile({x, y});
+      EXPECT_FALSE(wide.collisionCacheDirty);
+      ASSERT_EQ(wide.collisionCache.size(), expected.collisionCache.size());
+      for (size_t i = 0; i < expected.collisionCache.size(); ++i)
+        EXPECT_EQ(wide.collisionCache[i].poly, expected.collisionCache[i].poly);
+    }
+  }
+}
@@ -0,0 +1,138 @@
+#include "StarDungeonGenerator.hpp"
+#include "StarRandom.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+TEST(DungeonGeneratorTest, TileFootprint) {
+  Dungeon::TileFootprint footprint({{3, 2}, {-1, 0}, {3, 2}, {70, 1}});
+  EXPECT_EQ(footprint.bounds(), RectI(-1, 0, 71, 3));
+  EXPECT_EQ(footprint.rowWords(), 2u);
+  EXPECT_EQ(footprint.tiles(), List<Vec2I>({{-1, 0}, {70, 1}, {3, 2}}));
+  EXPECT_EQ(footprint.row(1)[1], (uint64_t)1 << 7);
+
+  EXPECT_TRUE(Dungeon::TileFootprint().empty());
+}
+
+TEST(DungeonGeneratorTest, TileBitmapSet) {
+  RandomSource rand(55);
+  auto randomFootprint = [&rand]() {
+    List<Vec2I> positions;
+    Vec2I size(rand.randInt(1, 150), rand.randInt(1, 20));
+    for (int i = 0; i < 40; ++i)
+      positions.append(Vec2I(rand.randInt(0, size[0] - 1), rand.randInt(0, size[1] - 1)));
+    return Dungeon::TileFootprint(positions);
+  };
+
+  Dungeon::TileBitmapSet set;
+  Set<Vec2I> expected;
+  for (int i = 0; i < 200; ++i) {
+    auto footprint = randomFootprint();
+    Vec2I pos(rand.randInt(-300, 300), rand.randInt(-100, 100));
+
+    bool intersects = false;
+    for (auto const& tile : footprint.tiles())
+      intersects |= expected.contains(pos + tile);
+
+    auto intersection = set.findIntersection(pos, footprint);
+    ASSERT_EQ(intersection.isValid(), intersects);
+    if (intersection) {
+      EXPECT_TRUE(expected.contains(*intersection));
+    }
+
+    if (!intersects || i % 2 == 0) {
+      set.add(pos, footprint);
+      for (auto const& tile : footprint.tiles())
+        expected.add(pos + tile);
+    }
+  }
+
+  for (int x = -400; x < 500; ++x) {
+    for (int y = -120; y < 140; ++y)
+      ASSERT_EQ(set.contains({x, y}), expected.contains({x, y})) << x << ", " << y;
+  }
+}
+
+namespace {
+  // Only knows which tiles belong to other dungeons, and counts how often each
+  // one is looked up.
+  class DungeonIdFacade : public DungeonGeneratorWorldFacade {
+  public:
+    void markRegion(RectI const&) override {}
+    void markTerrain(PolyF const&) override {}
+    void markSpace(PolyF const&) override {}
+    void setForegroundMaterial(Vec2I const&, MaterialId, MaterialHue, MaterialColorVariant) override {}
+    void setBackgroundMaterial(Vec2I const&, MaterialId, MaterialHue, MaterialColorVariant) override {}
+    void setForegroundMod(Vec2I const&, ModId, MaterialHue) override {}
+    void setBackgroundMod(Vec2I const&, ModId, MaterialHue) override {}
+    void placeObject(Vec2I const&, String const&, Star::Direction, Json const&) override {}
+    void placeVehicle(Vec2F const&, String const&, Json const&) override {}
+    void placeSurfaceBiomeItems(Vec2I const&) override {}
+    void placeBiomeTree(Vec2I const&) override {}
+    void addDrop(Vec2F const&, ItemDescriptor const&) override {}
+    void spawnNpc(Vec2F const&, Json const&) override {}
+    void spawnStagehand(Vec2F const&, Json const&) override {}
+    void setLiquid(Vec2I const&, LiquidStore const&) override {}
+    void connectWireGroup(List<Vec2I> const&) override {}
+    void setTileProtection(DungeonId, bool) override {}
+    bool checkSolid(Vec2I const&, TileLayer) override { return false; }
+    bool checkOpen(Vec2I const&, TileLayer) override { return true; }
+    bool checkOceanLiquid(Vec2I const&) override { return false; }
+    void clearTileEntities(RectI const&, Set<Vec2I> const&, bool) override {}
+    WorldGeometry getWorldGeometry() const override { return WorldGeometry(1000, 1000); }
+    void setPlayerStart(Vec2F const&) override {}
+
+    DungeonId getDungeonIdAt(Vec2I const& position) override {
+      ++lookups[position];
+      return dungeonIds.value(position, NoDungeonId);
+    }
+
+    void setDungeonIdAt(Vec2I const& position, DungeonId dungeonId) override {
+      dungeonIds[position] = dungeonId;
+    }
+
+    HashMap<Vec2I, DungeonId> dungeonIds;
+    HashMap<Vec2I, int> lookups;
+  };
+}
+
+TEST(DungeonGeneratorTest, FindOtherDungeon) {
+  RandomSource rand(56);
+  auto facade = make_shared<DungeonIdFacade>();
+  for (int i = 0; i < 300; ++i)
+    facade->dungeonIds[Vec2I(rand.randInt(-200, 200), rand.randInt(-50, 50))] = 1;
+
+  Dungeon::DungeonGeneratorWriter writer(facade, {}, {});
+  for (int i = 0; i < 300; ++i) {
+    List<Vec2I> positions;
+    Vec2I size(rand.randInt(1, 100), rand.randInt(1, 20));
+    for (int j = 0; j < 40; ++j)
+      positions.append(Vec2I(rand.randInt(0, size[0] - 1), rand.randInt(0, size[1] - 1)));
+    Dungeon::TileFootprint footprint(positions);
+    Vec2I pos(rand.randInt(-200, 200), rand.randInt(-50, 50));
+
+    bool present = false;
+    for (auto const& tile : footprint.tiles())
+      present |= facade->dungeonIds.contains(pos + tile);
+
+    auto found = writer.findOtherDungeon(pos, footprint);
+    ASSERT_EQ(found.isValid(), present);
+    if (found) {
+      EXPECT_TRUE(facade->dungeonIds.contains(*found));
+    }
+  }
+
+  // Each tile is only looked up in the world once.
+  for (auto const& p : facade->lookups)
+    ASSERT_EQ(p.second, 1) << p.first;
+
+  // Until the writer flushes its own dungeon ids into the world.
+  Dungeon::TileFootprint footprint({{0, 0}, {1, 0}});
+  Vec2I pos(2000, 0);
+  EXPECT_FALSE(writer.findOtherDungeon(pos, footprint));
+  writer.setDungeonId(pos, 2);
+  writer.flush();
+  EXPECT_TRUE(writer.findOtherDungeon(pos, footprint));
+  EXPECT_EQ(facade->lookups.get(pos), 2);
+}
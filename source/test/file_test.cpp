@@ -1,6 +1,7 @@
 #include "StarFile.hpp"
 #include "StarString.hpp"
 #include "StarFormat.hpp"
+#include "StarCasting.hpp"
 
 #include "gtest/gtest.h"
 
@@ -49,3 +50,29 @@ TEST(FileTest, All) {
   EXPECT_EQ(File::relativeTo("/foo", "/bar/"), "/bar/");
 #endif
 }
+
+TEST(FileTest, Mapping) {
+  auto file = File::ephemeralFile();
+  file->writeFull("0123456789", 10);
+
+  auto mapping = file->map();
+  EXPECT_EQ(mapping->size(), 10);
+  EXPECT_EQ(String(mapping->ptr(), 10), "0123456789");
+
+  char buffer[4];
+  EXPECT_EQ(mapping->readAbsolute(8, buffer, 4), 2u);
+  EXPECT_EQ(String(buffer, 2), "89");
+  mapping->seek(3);
+  mapping->readFull(buffer, 4);
+  EXPECT_EQ(String(buffer, 4), "3456");
+
+  // Writes through the file are visible through an existing mapping.
+  file->writeFullAbsolute(0, "abc", 3);
+  EXPECT_EQ(String(mapping->ptr(), 3), "abc");
+
+  // The mapping remains valid after the file is closed.
+  file->close();
+  auto cloned = as<FileMapping>(mapping->clone());
+  EXPECT_EQ(cloned->pos(), 0);
+  EXPECT_EQ(String(cloned->ptr(), 10), "abc3456789");
+}
@@ -0,0 +1,98 @@
+#include "StarImageProcessing.hpp"
+#include "StarDirectives.hpp"
+#include "StarImage.hpp"
+#include "StarStringView.hpp"
+#include "StarRandom.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  // A small sprite using a handful of palette colors in runs, with some fully
+  // transparent pixels.
+  Image testImage(PixelFormat format) {
+    List<Vec4B> palette = {{0, 0, 0, 0}, {255, 0, 0, 255}, {0, 255, 0, 255}, {10, 20, 30, 128}, {200, 180, 160, 255}};
+    RandomSource random(7);
+    Image image(37, 23, format);
+    Vec4B color = palette[0];
+    for (unsigned y = 0; y < image.height(); ++y) {
+      for (unsigned x = 0; x < image.width(); ++x) {
+        if (random.randu32() % 4 == 0)
+          color = random.randFrom(palette);
+        image.setrgb(x, y, color);
+      }
+    }
+    return image;
+  }
+
+  bool sameImage(Image const& a, Image const& b) {
+    if (a.size() != b.size() || a.pixelFormat() != b.pixelFormat())
+      return false;
+    size_t bytes = (size_t)a.width() * a.height() * a.bytesPerPixel();
+    return bytes == 0 || memcmp(a.data(), b.data(), bytes) == 0;
+  }
+
+  Image processSequentially(String const& directives, Image image) {
+    for (auto const& operation : parseImageOperations(directives))
+      processImageOperation(operation, image);
+    return image;
+  }
+}
+
+namespace {
+  StringList const TestDirectives = {
+    "?replace;ff0000=00ff00;00ff00=0000ff?replace;0000ff=ffffff;c8b4a0=ff0000",
+    "?replace;ff0000=0a141e80?hueshift=40?saturation=-20?brightness=30?border=1;ff000080;00000000",
+    "?multiply=ff808080?fade=202020=0.4?setcolor=ff00ff?multiply=80ff80ff",
+    "?scanlines=000000=0.3=ffffff=0.2?hueshift=-90?replace;000000=ff0000ff",
+    "?flipx?brightness=-50?crop;2;2;30;20?saturation=50?scalenearest=2?fade=ff0000=0.1",
+  };
+}
+
+TEST(ImageProcessingTest, PipelineMatchesSequential) {
+  for (auto format : {PixelFormat::RGBA32, PixelFormat::RGB24, PixelFormat::BGRA32}) {
+    Image image = testImage(format);
+    for (auto const& directives : TestDirectives) {
+      Image expected = processSequentially(directives, image);
+      Image result = processImageOperations(parseImageOperations(directives), image);
+      ASSERT_EQ(result.size(), expected.size()) << directives;
+      ASSERT_EQ(result.pixelFormat(), expected.pixelFormat()) << directives;
+      for (unsigned y = 0; y < result.height(); ++y) {
+        for (unsigned x = 0; x < result.width(); ++x)
+          ASSERT_EQ(result.get(x, y), expected.get(x, y)) << directives << " at " << x << ", " << y;
+      }
+    }
+  }
+}
+
+TEST(ImageProcessingTest, PipelineFusesPixelOperations) {
+  EXPECT_EQ(ImageOperationPipeline(parseImageOperations("?replace;ff0000=00ff00?hueshift=40?brightness=30?multiply=ff8080")).passes(), 1u);
+  EXPECT_EQ(ImageOperationPipeline(parseImageOperations("?replace;ff0000=00ff00?border=1;ff0000;000000?hueshift=40")).passes(), 3u);
+  EXPECT_TRUE(ImageOperationPipeline().empty());
+}
+
+TEST(ImageProcessingTest, DirectivesShareCachedPipelines) {
+  Image image = testImage(PixelFormat::RGBA32);
+  List<Image> expected;
+  for (auto const& directives : TestDirectives)
+    expected.append(processSequentially(directives, image));
+
+  // Every thread applies every directive group several times, so most
+  // applications find a pipeline compiled by another thread.
+  List<ThreadFunction<void>> threads;
+  atomic<size_t> mismatches(0);
+  for (size_t t = 0; t < 4; ++t) {
+    threads.append(Thread::invoke("DirectivesShareCachedPipelines", [&, t]() {
+        for (size_t i = 0; i < 8; ++i) {
+          size_t index = (t + i) % TestDirectives.size();
+          if (!sameImage(DirectivesGroup(TestDirectives[index]).applyNewImage(image), expected[index]))
+            ++mismatches;
+        }
+      }));
+  }
+  for (auto& thread : threads)
+    thread.finish();
+
+  EXPECT_EQ(mismatches, 0u);
+}
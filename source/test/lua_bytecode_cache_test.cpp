@@ -0,0 +1,103 @@
+#include "StarLuaBytecodeCache.hpp"
+#include "StarFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  ByteArray const AssetsDigest = ByteArray::fromCString("assets");
+  ByteArray const ScriptSource = ByteArray::fromCString("function answer() return 42 end");
+
+  // Runs the bytecode to make sure it is the compiled script and not just
+  // anything that was stored under its path.
+  int runAnswer(LuaEngine& engine, ByteArray const& bytecode) {
+    auto context = engine.createContext();
+    context.load(bytecode);
+    return context.invokePath<int>("answer");
+  }
+}
+
+TEST(LuaBytecodeCacheTest, MemoryOnly) {
+  auto engine = LuaEngine::create();
+  LuaBytecodeCache cache(AssetsDigest, LuaBytecodeCache::engineSignature(*engine));
+  EXPECT_FALSE(cache.find("/answer.lua", ScriptSource));
+
+  auto bytecode = cache.compile(*engine, "/answer.lua", ScriptSource);
+  EXPECT_EQ(runAnswer(*engine, *bytecode), 42);
+  EXPECT_EQ(cache.compile(*engine, "/answer.lua", ScriptSource), bytecode);
+  EXPECT_EQ(cache.find("/answer.lua", ScriptSource), bytecode);
+
+  // Changed scripts are compiled again.
+  ByteArray changedSource = ByteArray::fromCString("function answer() return 43 end");
+  EXPECT_FALSE(cache.find("/answer.lua", changedSource));
+  EXPECT_EQ(runAnswer(*engine, *cache.compile(*engine, "/answer.lua", changedSource)), 43);
+  EXPECT_FALSE(cache.find("/answer.lua", ScriptSource));
+
+  // Without a storage file there is nothing to save.
+  cache.save();
+  cache.finishSaving();
+}
+
+TEST(LuaBytecodeCacheTest, Storage) {
+  auto engine = LuaEngine::create();
+  ByteArray signature = LuaBytecodeCache::engineSignature(*engine);
+  auto dir = File::temporaryDirectory();
+  auto finallyGuard = finally([&dir]() { File::removeDirectoryRecursive(dir); });
+  String storageFile = File::relativeTo(dir, "lua/bytecode.cache");
+
+  {
+    LuaBytecodeCache cache(AssetsDigest, signature, storageFile);
+    cache.compile(*engine, "/answer.lua", ScriptSource);
+    cache.save();
+    cache.finishSaving();
+    EXPECT_TRUE(File::isFile(storageFile));
+
+    // Saving again without compiling anything new leaves the file alone.
+    File::remove(storageFile);
+    cache.save();
+    cache.finishSaving();
+    EXPECT_FALSE(File::isFile(storageFile));
+
+    cache.compile(*engine, "/other.lua", ByteArray::fromCString("function answer() return 7 end"));
+    cache.save();
+  }
+  // Destroying the cache waits for the last save.
+  EXPECT_TRUE(File::isFile(storageFile));
+
+  // Scripts are loaded back for the same assets, engine and source.
+  {
+    LuaBytecodeCache cache(AssetsDigest, signature, storageFile);
+    auto bytecode = cache.find("/answer.lua", ScriptSource);
+    ASSERT_TRUE(bytecode);
+    EXPECT_EQ(runAnswer(*engine, *bytecode), 42);
+    ASSERT_TRUE(cache.find("/other.lua", ByteArray::fromCString("function answer() return 7 end")));
+    EXPECT_FALSE(cache.find("/answer.lua", ByteArray::fromCString("function answer() return 43 end")));
+  }
+
+  // The whole file is ignored if the assets have changed, or if the scripts
+  // were compiled by a different engine.
+  EXPECT_FALSE(LuaBytecodeCache(ByteArray::fromCString("changed"), signature, storageFile).find("/answer.lua", ScriptSource));
+  EXPECT_FALSE(LuaBytecodeCache(AssetsDigest, ByteArray::fromCString("changed"), storageFile).find("/answer.lua", ScriptSource));
+
+  // As is a damaged file, whether truncated or with any byte changed.
+  ByteArray contents = File::readFile(storageFile);
+  File::writeFile(contents.left(contents.size() / 2), storageFile);
+  EXPECT_FALSE(LuaBytecodeCache(AssetsDigest, signature, storageFile).find("/answer.lua", ScriptSource));
+  File::writeFile(contents.left(4), storageFile);
+  EXPECT_FALSE(LuaBytecodeCache(AssetsDigest, signature, storageFile).find("/answer.lua", ScriptSource));
+  for (size_t i = 0; i < contents.size(); i += 7) {
+    ByteArray damaged = contents;
+    damaged[i] = ~damaged[i];
+    File::writeFile(damaged, storageFile);
+    EXPECT_FALSE(LuaBytecodeCache(AssetsDigest, signature, storageFile).find("/answer.lua", ScriptSource)) << "changed byte " << i;
+  }
+
+  // A damaged file is replaced on the next save.
+  {
+    LuaBytecodeCache cache(AssetsDigest, signature, storageFile);
+    cache.compile(*engine, "/answer.lua", ScriptSource);
+    cache.save();
+  }
+  EXPECT_TRUE(LuaBytecodeCache(AssetsDigest, signature, storageFile).find("/answer.lua", ScriptSource));
+}
@@ -412,3 +412,52 @@ TEST(LuaJsonTest, IntFloat) {
   EXPECT_EQ(context.invokePath<String>("printNumber", 1.0), "1.0");
   EXPECT_EQ(context.invokePath<String>("printNumber", 1), "1");
 }
+
+TEST(LuaJsonTest, NestedContainers) {
+  auto engine = LuaEngine::create();
+  auto context = engine->createContext();
+
+  context.load(
+      R"SCRIPT(
+        function identity(arg)
+          return arg
+        end
+
+        function modify(arg)
+          arg.list[2] = nil
+          arg.list[5] = "five"
+          arg.object.removed = nil
+          arg.object.null = "set"
+          arg.object.inner[1] = {}
+          return arg
+        end
+
+        function hasKey(arg, key)
+          return arg[key] ~= nil
+        end
+      )SCRIPT");
+
+  Json nested = JsonObject{
+    {"list", JsonArray{1, 2.5, Json(), "four"}},
+    {"object", JsonObject{{"removed", true}, {"null", Json()}, {"inner", JsonArray{Json(), JsonObject{}}}}},
+    {"emptyList", JsonArray{}},
+    {"emptyObject", JsonObject{}},
+    {"string", String("with\0null", 9)}
+  };
+  EXPECT_EQ(context.invokePath<Json>("identity", nested), nested);
+  EXPECT_TRUE(context.invokePath<Json>("identity", nested).get("emptyList").isType(Json::Type::Array));
+  EXPECT_TRUE(context.invokePath<Json>("identity", nested).get("emptyObject").isType(Json::Type::Object));
+
+  Json modified = JsonObject{
+    {"list", JsonArray{1, Json(), Json(), "four", "five"}},
+    {"object", JsonObject{{"null", "set"}, {"inner", JsonArray{JsonObject{}, JsonObject{}}}}},
+    {"emptyList", JsonArray{}},
+    {"emptyObject", JsonObject{}},
+    {"string", String("with\0null", 9)}
+  };
+  EXPECT_EQ(context.invokePath<Json>("modify", nested), modified);
+
+  EXPECT_TRUE(context.invokePath<bool>("hasKey", JsonArray{1, 2}, 2));
+  EXPECT_FALSE(context.invokePath<bool>("hasKey", JsonArray{1, Json()}, 2));
+  EXPECT_FALSE(context.invokePath<bool>("hasKey", JsonObject{{"a", Json()}}, "a"));
+}
@@ -0,0 +1,131 @@
+#include "StarLuaRoot.hpp"
+#include "StarLogging.hpp"
+#include "StarRoot.hpp"
+#include "StarAssets.hpp"
+
+#include "StarTestUniverse.hpp"
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+StringList logMapKeysWithPrefix(String const& prefix) {
+  StringList keys;
+  for (auto const& p : LogMap::getValues()) {
+    if (p.first.beginsWith(prefix))
+      keys.append(p.first);
+  }
+  return keys;
+}
+
+TEST(LuaRootTest, SampledProfile) {
+  auto luaRoot = make_shared<LuaRoot>();
+  auto context = luaRoot->createContext();
+  context.eval(R"SCRIPT(
+      function work(n)
+        local t = {}
+        for i = 1, n do
+          t[i] = {i}
+        end
+        return #t
+      end
+    )SCRIPT");
+
+  StringList const scripts = {"/outer.lua", "/shared.lua"};
+  String const outerFunction = "outer";
+  String const innerFunction = "inner";
+  auto invoke = [&](String const& category) {
+    luaRoot->setProfileCategory(category);
+    LuaProfileSample outerSample(luaRoot.get(), scripts, outerFunction);
+    context.invokePath<int>("work", 1000);
+    LuaProfileSample innerSample(luaRoot.get(), scripts, innerFunction);
+    context.invokePath<int>("work", 5000);
+  };
+
+  // Nothing is measured while sampling is disabled.
+  luaRoot->setProfileSampleInterval(0);
+  invoke("monster");
+  EXPECT_TRUE(luaRoot->sampledProfile().empty());
+
+  luaRoot->setProfileSampleInterval(1);
+  invoke("monster");
+  invoke("monster");
+  invoke("npc");
+
+  auto profile = luaRoot->sampledProfile();
+  ASSERT_EQ(profile.size(), 4u);
+  Map<pair<String, String>, LuaScriptProfileEntry> entries;
+  for (auto const& entry : profile) {
+    EXPECT_EQ(entry.scripts, "/outer.lua, /shared.lua");
+    entries[{entry.category, entry.function}] = entry;
+  }
+
+  auto monsterOuter = entries.get({"monster", "outer"});
+  auto monsterInner = entries.get({"monster", "inner"});
+  EXPECT_EQ(monsterOuter.samples, 2u);
+  EXPECT_EQ(monsterInner.samples, 2u);
+  EXPECT_EQ(entries.get({"npc", "outer"}).samples, 1u);
+  EXPECT_EQ(entries.get({"npc", "inner"}).samples, 1u);
+
+  // The nested invocation does five times the work, and is subtracted out of
+  // the self cost of the outer one.
+  EXPECT_GT(monsterInner.instructions, monsterOuter.instructions);
+  EXPECT_GT(monsterInner.allocatedBytes, monsterOuter.allocatedBytes);
+  EXPECT_GE(monsterOuter.totalTime, monsterInner.totalTime);
+  EXPECT_EQ(monsterInner.selfTime, monsterInner.totalTime);
+  EXPECT_EQ(luaRoot->sampledProfile(2).size(), 2u);
+
+  // Only the top entries are logged, and lines are removed from LogMap once
+  // they are no longer in the report.
+  String const logPrefix = "lua_root_test_profile";
+  luaRoot->logSampledProfile(logPrefix, 3);
+  EXPECT_EQ(logMapKeysWithPrefix(logPrefix).sorted(), StringList({"lua_root_test_profile_1", "lua_root_test_profile_2", "lua_root_test_profile_3"}));
+  EXPECT_TRUE(LogMap::getValue("lua_root_test_profile_1").contains("(/outer.lua, /shared.lua)"));
+
+  luaRoot->clearSampledProfile();
+  EXPECT_TRUE(luaRoot->sampledProfile().empty());
+  invoke("monster");
+  luaRoot->logSampledProfile(logPrefix, 3);
+  EXPECT_EQ(logMapKeysWithPrefix(logPrefix).sorted(), StringList({"lua_root_test_profile_1", "lua_root_test_profile_2"}));
+
+  // Only one in every 'sampleInterval' top level invocations is measured.
+  luaRoot->setProfileSampleInterval(3);
+  EXPECT_TRUE(luaRoot->sampledProfile().empty());
+  for (size_t i = 0; i < 7; ++i)
+    LuaProfileSample sample(luaRoot.get(), scripts, outerFunction);
+  profile = luaRoot->sampledProfile();
+  ASSERT_EQ(profile.size(), 1u);
+  EXPECT_EQ(profile[0].samples, 2u);
+  luaRoot->logSampledProfile(logPrefix, 3);
+  EXPECT_EQ(logMapKeysWithPrefix(logPrefix), StringList({"lua_root_test_profile_1"}));
+
+  luaRoot->setProfileSampleInterval(0);
+  EXPECT_TRUE(luaRoot->sampledProfile().empty());
+  luaRoot->logSampledProfile(logPrefix, 3);
+  EXPECT_TRUE(logMapKeysWithPrefix(logPrefix).empty());
+}
+
+TEST(LuaRootTest, ProfileCommand) {
+  auto& root = Root::singleton();
+  StringList instanceWorlds = root.assets()->json("/instance_worlds.config").toObject().keys();
+  ASSERT_GT(instanceWorlds.size(), 0u);
+  WorldId instanceWorld = InstanceWorldId(instanceWorlds.sorted().first());
+
+  TestUniverse testUniverse(Vec2U(100, 100));
+  testUniverse.warpPlayer(instanceWorld);
+  String worldName = printWorldId(instanceWorld);
+  String logPrefix = strf("server_{}_lua_profile", worldName);
+
+  EXPECT_TRUE(testUniverse.adminCommand("luaprofile").beginsWith("Script profiling is not enabled"));
+
+  EXPECT_TRUE(testUniverse.adminCommand("luaprofile interval 1").beginsWith("Set script profile sample interval to 1 on "));
+  testUniverse.update(20);
+  StringList report = testUniverse.adminCommand("luaprofile 5").split("\n");
+  EXPECT_TRUE(report.contains(strf("{}:", worldName)));
+  EXPECT_EQ(testUniverse.adminCommand("luaprofile reset"), "Cleared script profiles");
+
+  // Every world removes its profile from LogMap once sampling is disabled.
+  testUniverse.adminCommand("luaprofile interval 0");
+  testUniverse.update(20);
+  EXPECT_TRUE(logMapKeysWithPrefix(logPrefix).empty());
+  EXPECT_TRUE(testUniverse.adminCommand("luaprofile").beginsWith("Script profiling is not enabled"));
+}
@@ -836,3 +836,27 @@ TEST(LuaTest, ProfilingTest) {
   EXPECT_TRUE(names.contains("function2"));
   EXPECT_TRUE(names.contains("function3"));
 }
+
+TEST(LuaTest, CostCounters) {
+  auto luaEngine = LuaEngine::create();
+  luaEngine->setInstructionLimit(100000000);
+  luaEngine->setInstructionMeasureInterval(1000);
+
+  auto context = luaEngine->createContext();
+  uint64_t instructions = luaEngine->instructionCount();
+  uint64_t allocatedBytes = luaEngine->allocatedBytes();
+  context.eval(R"SCRIPT(
+      local t = {}
+      for i = 1, 10000 do
+        t[i] = {i}
+      end
+    )SCRIPT");
+
+  EXPECT_GT(luaEngine->instructionCount() - instructions, 10000u);
+  EXPECT_GT(luaEngine->allocatedBytes() - allocatedBytes, 10000u * 16);
+
+  // Neither is reset between calls, unlike the instruction limit count
+  instructions = luaEngine->instructionCount();
+  context.eval("for i = 1, 10000 do end");
+  EXPECT_GT(luaEngine->instructionCount(), instructions);
+}
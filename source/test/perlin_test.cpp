@@ -0,0 +1,44 @@
+#include "StarPerlin.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  template <typename Float>
+  void checkBatches(Perlin<Float> const& perlin) {
+    RandomSource random(42);
+    // More than one batch, and not a multiple of the batch size
+    size_t const count = 150;
+    List<Float> x(count);
+    for (size_t i = 0; i < count; ++i) {
+      x[i] = random.randf(-1000, 1000);
+      // Some samples on lattice points when the frequency is 1
+      if (i % 7 == 0)
+        x[i] = round(x[i]);
+      // And some past the range the SSE2 path handles, but that still fit an
+      // int through three octaves
+      if (i % 31 == 0)
+        x[i] = 3e8 + i;
+    }
+
+    List<Float> out(count);
+    for (Float y : {(Float)0, (Float)-3, (Float)random.randf(-1000, 1000)}) {
+      perlin.getRow(x.ptr(), y, out.ptr(), count);
+      for (size_t i = 0; i < count; ++i)
+        ASSERT_EQ(out[i], perlin.get(x[i], y));
+    }
+  }
+}
+
+TEST(PerlinTest, BatchMatchesSingle) {
+  for (auto type : {PerlinType::Perlin, PerlinType::Billow, PerlinType::RidgedMulti}) {
+    checkBatches(PerlinF(type, 4, 0.05f, 10.0f, 1.0f, 2.0f, 2.0f, 1234));
+    checkBatches(PerlinD(type, 3, 0.01, 3.0, -0.5, 1.5, 2.5, 5678));
+    checkBatches(PerlinF(type, 3, 1.0f, 1.0f, 0.0f, 2.0f, 2.0f, 91011));
+  }
+
+  List<float> out(1);
+  float x = 0;
+  EXPECT_THROW(PerlinF().getRow(&x, 0, out.ptr(), 1), PerlinException);
+}
@@ -0,0 +1,71 @@
+#include "StarProcessedImageCache.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+TEST(ProcessedImageCacheTest, All) {
+  auto dir = File::temporaryDirectory();
+  String filename = File::relativeTo(dir, "cache/images.cache");
+
+  // Each image record is a little over 16KiB
+  Image red = Image::filled({64, 64}, {255, 0, 0, 255});
+  Image green = Image::filled({64, 64}, {0, 255, 0, 255});
+  Image blue = Image::filled({32, 128}, {0, 0, 255, 128}, PixelFormat::BGRA32);
+
+  {
+    ProcessedImageCache cache(filename, 40 * 1024);
+    EXPECT_FALSE(cache.get("/red.png?replace", 1));
+    cache.set("/red.png?replace", 1, red);
+    cache.set("/green.png?replace", 2, green);
+    // Would put the file past its maximum size
+    cache.set("/blue.png?replace", 3, blue);
+    EXPECT_EQ(cache.count(), 2u);
+
+    auto image = cache.get("/red.png?replace", 1);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image->size(), red.size());
+    EXPECT_EQ(image->get(10, 10), Vec4B(255, 0, 0, 255));
+    EXPECT_FALSE(cache.get("/red.png?replace", 4));
+
+    // The file is locked to the cache that opened it first
+    ProcessedImageCache otherCache(filename, 40 * 1024);
+    EXPECT_EQ(otherCache.count(), 0u);
+    EXPECT_FALSE(otherCache.get("/red.png?replace", 1));
+  }
+
+  {
+    ProcessedImageCache cache(filename, 64 * 1024);
+    EXPECT_EQ(cache.count(), 2u);
+
+    // Replacing an image with a new digest keeps the old record in the file
+    // until it is next compacted
+    cache.set("/red.png?replace", 4, blue);
+    EXPECT_EQ(cache.count(), 2u);
+    EXPECT_FALSE(cache.get("/red.png?replace", 1));
+  }
+
+  {
+    // With a smaller maximum size only the most recently used image is kept,
+    // as green has not been used since the first run
+    ProcessedImageCache cache(filename, 30 * 1024);
+    EXPECT_EQ(cache.count(), 1u);
+    auto image = cache.get("/red.png?replace", 4);
+    ASSERT_TRUE(image);
+    EXPECT_EQ(image->pixelFormat(), PixelFormat::BGRA32);
+    EXPECT_EQ(image->size(), blue.size());
+    EXPECT_EQ(image->get(31, 127), Vec4B(0, 0, 255, 128));
+    EXPECT_LE(cache.size(), 30u * 1024);
+  }
+
+  // A truncated file loses only the last record
+  File::open(filename, IOMode::ReadWrite)->resize(File::open(filename, IOMode::Read)->size() - 100);
+  {
+    ProcessedImageCache cache(filename, 40 * 1024);
+    EXPECT_EQ(cache.count(), 0u);
+    cache.set("/green.png?replace", 2, green);
+    EXPECT_TRUE(cache.get("/green.png?replace", 2));
+  }
+
+  File::removeDirectoryRecursive(dir);
+}
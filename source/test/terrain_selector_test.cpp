@@ -0,0 +1,57 @@
+#include "StarPerlinSelector.hpp"
+#include "StarRidgeBlocksSelector.hpp"
+#include "StarWormCave.hpp"
+#include "StarFlatSurfaceSelector.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  void checkRegion(TerrainSelector const& selector, RectI const& region) {
+    List<float> values(region.volume());
+    selector.getRegion(region, values.ptr());
+    size_t i = 0;
+    for (int y = region.yMin(); y < region.yMax(); ++y) {
+      for (int x = region.xMin(); x < region.xMax(); ++x)
+        ASSERT_EQ(values[i++], selector.get(x, y)) << selector.type << " at " << x << ", " << y;
+    }
+  }
+}
+
+TEST(TerrainSelectorTest, RegionMatchesPoints) {
+  TerrainSelectorParameters parameters;
+  parameters.seed = 1234;
+  parameters.worldWidth = 1000;
+  parameters.baseHeight = 500;
+
+  List<RectI> regions = {RectI(0, 0, 32, 32), RectI(-37, -5, 11, 40), RectI(100, 250, 101, 251)};
+
+  PerlinSelector perlin(JsonObject{{"function", "billow"}, {"octaves", 3}, {"freq", 0.05}, {"amp", 10}, {"yInfluence", 0.5}}, parameters);
+  RidgeBlocksSelector ridgeBlocks(JsonObject{{"amplitude", 10}, {"frequency", 0.1}, {"bias", -1}, {"noiseAmplitude", 3}, {"noiseFrequency", 0.2}}, parameters);
+  WormCaveSelector wormCave(JsonObject{
+      {"sectorSize", 16},
+      {"numberOfWormsPerSectorRange", JsonArray{0.5, 1.5}},
+      {"wormSizeRange", JsonArray{2, 6}},
+      {"wormLengthRange", JsonArray{10, 40}},
+      {"wormTaperDistance", 5},
+      {"wormAngleRange", JsonArray{0, 6.28}},
+      {"wormTurnChance", 0.2},
+      {"wormTurnRate", 0.1},
+      {"sectorRadius", 2}
+    }, parameters);
+  FlatSurfaceSelector flatSurface(JsonObject{{"adjustment", 3}}, parameters);
+
+  for (auto const& region : regions) {
+    checkRegion(perlin, region);
+    checkRegion(ridgeBlocks, region);
+    checkRegion(wormCave, region);
+    checkRegion(flatSurface, region);
+  }
+
+  List<Vec2I> points = {{5, 5}, {6, 5}, {5, 7}, {-20, 3}};
+  List<float> values(points.size());
+  perlin.getPoints(points, values.ptr());
+  for (size_t i = 0; i < points.size(); ++i)
+    EXPECT_EQ(values[i], perlin.get(points[i][0], points[i][1]));
+}
@@ -0,0 +1,78 @@
+#include "StarZSTDCompression.hpp"
+#include "StarRandom.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace Star;
+
+namespace {
+  // Small messages with a lot of structure shared between them, but little
+  // repetition inside any one of them, like a step's worth of entity updates.
+  ByteArray sampleMessage(RandomSource& random) {
+    static StringList const Keys = {"position", "velocity", "rotation", "animationState", "statusEffects", "health", "energy", "facingDirection"};
+    String message;
+    for (size_t i = random.randu32() % 4 + 2; i > 0; --i) {
+      String const& key = random.randFrom(Keys);
+      message += strf("{{\"entity\":{},\"{}\":[{},{}]}}", random.randu32() % 1000, key, random.randInt(-500, 500), random.randInt(-500, 500));
+    }
+    return ByteArray(message.utf8Ptr(), message.utf8Size());
+  }
+
+  List<ByteArray> sampleMessages(uint64_t seed, size_t count) {
+    RandomSource random(seed);
+    List<ByteArray> messages;
+    for (size_t i = 0; i < count; ++i)
+      messages.append(sampleMessage(random));
+    return messages;
+  }
+
+  // Compresses every message as a separate flush of one stream, and checks
+  // that they come back out of a decompression stream that is fed one byte
+  // at a time.
+  size_t streamRoundTrip(List<ByteArray> const& messages, ByteArray const& compressionDictionary, List<ByteArray> const& decompressionDictionaries) {
+    CompressionStream compressionStream;
+    if (!compressionDictionary.empty())
+      compressionStream.setDictionary(compressionDictionary);
+    DecompressionStream decompressionStream;
+    for (auto const& dictionary : decompressionDictionaries)
+      decompressionStream.addDictionary(dictionary);
+
+    size_t compressedSize = 0;
+    for (auto const& message : messages) {
+      ByteArray compressed = compressionStream.compress(message);
+      compressedSize += compressed.size();
+
+      ByteArray decompressed;
+      for (size_t i = 0; i < compressed.size(); ++i)
+        decompressionStream.decompress(compressed.ptr() + i, 1, decompressed);
+      EXPECT_EQ(decompressed, message);
+    }
+    return compressedSize;
+  }
+}
+
+TEST(ZstdCompressionTest, StreamDictionary) {
+  auto dictionary = ZstdCompression::trainDictionary(sampleMessages(1, 2000), 16 * 1024);
+  EXPECT_NE(ZstdCompression::dictionaryId(dictionary), 0u);
+  EXPECT_LE(dictionary.size(), 16u * 1024);
+
+  auto otherDictionary = ZstdCompression::trainDictionary(sampleMessages(2, 2000), 8 * 1024);
+  EXPECT_NE(ZstdCompression::dictionaryId(otherDictionary), ZstdCompression::dictionaryId(dictionary));
+
+  auto messages = sampleMessages(3, 100);
+  size_t plainSize = streamRoundTrip(messages, {}, {});
+  size_t dictionarySize = streamRoundTrip(messages, dictionary, {otherDictionary, dictionary});
+  EXPECT_LT(dictionarySize, plainSize);
+
+  // Streams without a dictionary still decompress when dictionaries are
+  // offered
+  EXPECT_EQ(streamRoundTrip(messages, {}, {dictionary}), plainSize);
+
+  // But a stream compressed with a dictionary the other end does not have
+  // cannot be
+  CompressionStream compressionStream;
+  compressionStream.setDictionary(dictionary);
+  DecompressionStream decompressionStream;
+  decompressionStream.addDictionary(otherDictionary);
+  EXPECT_THROW(decompressionStream.decompress(compressionStream.compress(messages[0])), IOException);
+}
@@ -0,0 +1,97 @@
+#include "StarBTreeDatabase.hpp"
+#include "StarFile.hpp"
+#include "StarLexicalCast.hpp"
+#include "StarRandom.hpp"
+#include "StarTime.hpp"
+
+using namespace Star;
+
+ByteArray toKey(uint32_t k) {
+  k = toBigEndian(k);
+  return ByteArray((char*)(&k), sizeof(k));
+}
+
+ByteArray makeValue(uint32_t k) {
+  return ByteArray(k % 400 + 1, (char)k);
+}
+
+// Reports snapshot read throughput from 1 up to the number of processors in
+// reader threads, optionally while another thread keeps inserting and
+// committing.
+void benchmarkCommittedReads(BTreeDatabase& db, uint32_t keyCount, size_t totalReads, bool writing) {
+  unsigned maxThreads = max(Thread::numberOfProcessors(), 1u);
+  for (unsigned threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+    atomic<bool> done(false);
+    atomic<size_t> commits(0);
+    ThreadFunction<void> writer;
+    if (writing) {
+      writer = Thread::invoke("btreeBenchmarkWriter", [&db, &done, &commits, keyCount]() {
+          RandomSource rand(1);
+          while (!done) {
+            for (size_t i = 0; i < 50; ++i) {
+              uint32_t k = rand.randu32() % keyCount;
+              db.insert(toKey(k), makeValue(k));
+            }
+            db.commit();
+            ++commits;
+          }
+        });
+    }
+
+    double start = Time::monotonicTime();
+    List<ThreadFunction<void>> readers;
+    for (unsigned i = 0; i < threadCount; ++i) {
+      readers.append(Thread::invoke("btreeBenchmarkReader", [&db, keyCount, totalReads, threadCount, i]() {
+          RandomSource rand(i + 2);
+          for (size_t j = 0; j < totalReads / threadCount; ++j) {
+            uint32_t k = rand.randu32() % keyCount;
+            if (!db.findCommitted(toKey(k)))
+              throw StarException::format("Missing key {}", k);
+          }
+        }));
+    }
+    for (auto& reader : readers)
+      reader.finish();
+    double elapsed = Time::monotonicTime() - start;
+
+    done = true;
+    if (writer)
+      writer.finish();
+
+    if (writing)
+      coutf("committed reads with {} thread(s) while committing: {:.0f} reads/s, {:.0f} commits/s\n", threadCount, totalReads / elapsed, commits / elapsed);
+    else
+      coutf("committed reads with {} thread(s): {:.0f} reads/s\n", threadCount, totalReads / elapsed);
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    size_t totalReads = 200000;
+    if (argc > 1)
+      totalReads = lexicalCast<size_t>(argv[1]);
+
+    uint32_t const KeyCount = 20000;
+
+    auto tmpFile = File::temporaryFile();
+    auto finallyGuard = finally([&tmpFile]() { tmpFile->remove(); });
+
+    BTreeDatabase db("BenchmarkDB", 4);
+    db.setAutoCommit(false);
+    db.setIODevice(tmpFile);
+    db.open();
+
+    for (uint32_t k = 0; k < KeyCount; ++k)
+      db.insert(toKey(k), makeValue(k));
+    db.commit();
+
+    benchmarkCommittedReads(db, KeyCount, totalReads, false);
+    benchmarkCommittedReads(db, KeyCount, totalReads, true);
+
+    db.close();
+    return 0;
+  } catch (std::exception const& e) {
+    cerrf("exception caught: {}\n", outputException(e, true));
+    return 1;
+  }
+}
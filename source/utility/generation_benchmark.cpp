@@ -2,9 +2,47 @@
 #include "StarCelestialDatabase.hpp"
 #include "StarWorldTemplate.hpp"
 #include "StarWorldServer.hpp"
+#include "StarPerlin.hpp"
 
 using namespace Star;
 
+// Reports samples per second for 2d perlin noise of each type, evaluated a
+// sample at a time and through getRow.
+void benchmarkPerlin(unsigned samples) {
+  unsigned const RowSize = 256;
+  unsigned rows = max(samples / RowSize, 1u);
+
+  List<float> xValues(RowSize);
+  for (unsigned i = 0; i < RowSize; ++i)
+    xValues[i] = i * 0.7f;
+  List<float> out(RowSize);
+
+  for (auto type : {PerlinType::Perlin, PerlinType::Billow, PerlinType::RidgedMulti}) {
+    PerlinF perlin(type, 4, 0.01f, 10.0f, 0.0f, 2.0f, 2.0f, 1);
+
+    // Accumulated so that evaluation cannot be optimized away
+    float total = 0.0f;
+
+    double start = Time::monotonicTime();
+    for (unsigned y = 0; y < rows; ++y) {
+      for (unsigned i = 0; i < RowSize; ++i)
+        total += perlin.get(xValues[i], y * 1.3f);
+    }
+    double singleTime = Time::monotonicTime() - start;
+
+    start = Time::monotonicTime();
+    for (unsigned y = 0; y < rows; ++y) {
+      perlin.getRow(xValues.ptr(), y * 1.3f, out.ptr(), RowSize);
+      total += out[0];
+    }
+    double rowTime = Time::monotonicTime() - start;
+
+    double count = (double)rows * RowSize;
+    coutf("Perlin {}: get {:.0f} samples/s | getRow {:.0f} samples/s ({})\n",
+        PerlinTypeNames.getRight(type), count / singleTime, count / rowTime, total);
+  }
+}
+
 int main(int argc, char** argv) {
   try {
     RootLoader rootLoader({{}, {}, {}, LogLevel::Error, false, {}});
@@ -12,11 +50,22 @@ int main(int argc, char** argv) {
     rootLoader.addParameter("regions", "regions", OptionParser::Optional, "number of regions to generate, default 1000");
     rootLoader.addParameter("regionsize", "size", OptionParser::Optional, "width / height of each generation region, default 10");
     rootLoader.addParameter("reportevery", "report regions", OptionParser::Optional, "number of generation regions before each progress report, default 20");
+    rootLoader.addParameter("perlinsamples", "samples", OptionParser::Optional, "number of samples of each type of perlin noise to benchmark, default 4194304");
+    rootLoader.addSwitch("perlinonly", "only benchmark perlin noise, without loading assets or generating a world");
 
     RootUPtr root;
     OptionParser::Options options;
     tie(root, options) = rootLoader.commandInitOrDie(argc, argv);
 
+    unsigned perlinSamples = 4194304;
+    if (auto perlinSamplesOption = options.parameters.maybe("perlinsamples"))
+      perlinSamples = lexicalCast<unsigned>(perlinSamplesOption->first());
+
+    if (perlinSamples > 0)
+      benchmarkPerlin(perlinSamples);
+    if (options.switches.contains("perlinonly"))
+      return 0;
+
     coutf("Fully loading root...");
     root->fullyLoad();
     coutf(" done\n");
@@ -47,30 +96,39 @@ int main(int argc, char** argv) {
     coutf("testing generation on coordinate {}\n", coordinate);
 
     auto worldParameters = celestialDatabase.parameters(coordinate).take();
-    auto worldTemplate = make_shared<WorldTemplate>(worldParameters.visitableParameters(), SkyParameters(), worldParameters.seed());
 
-    auto rand = RandomSource(worldTemplate->worldSeed());
+    // Generates the same regions in a fresh world, and returns the time taken
+    auto generateWorld = [&](bool pregenerate) {
+      auto worldTemplate = make_shared<WorldTemplate>(worldParameters.visitableParameters(), SkyParameters(), worldParameters.seed());
+      auto rand = RandomSource(worldTemplate->worldSeed());
 
-    WorldServer worldServer(std::move(worldTemplate), File::ephemeralFile());
-    Vec2U worldSize = worldServer.geometry().size();
+      WorldServer worldServer(std::move(worldTemplate), File::ephemeralFile());
+      Vec2U worldSize = worldServer.geometry().size();
 
-    double start = Time::monotonicTime();
-    double lastReport = Time::monotonicTime();
+      double start = Time::monotonicTime();
+      double lastReport = Time::monotonicTime();
 
-    coutf("Starting world generation for {} regions\n", regionsToGenerate);
+      coutf("Starting world generation for {} regions{}\n", regionsToGenerate, pregenerate ? " with pregeneration" : "");
 
-    for (unsigned i = 0; i < regionsToGenerate; ++i) {
-      if (i != 0 && i % reportEvery == 0) {
-        float gps = reportEvery / (Time::monotonicTime() - lastReport);
-        lastReport = Time::monotonicTime();
-        coutf("[{}] {}s | Generatons Per Second: {}\n", i, Time::monotonicTime() - start, gps);
+      for (unsigned i = 0; i < regionsToGenerate; ++i) {
+        if (i != 0 && i % reportEvery == 0) {
+          float gps = reportEvery / (Time::monotonicTime() - lastReport);
+          lastReport = Time::monotonicTime();
+          coutf("[{}] {}s | Generatons Per Second: {}\n", i, Time::monotonicTime() - start, gps);
+        }
+
+        RectI region = RectI::withCenter(Vec2I(rand.randInt(0, worldSize[0]), rand.randInt(0, worldSize[1])), Vec2I::filled(regionSize));
+        worldServer.generateRegion(region, pregenerate);
       }
 
-      RectI region = RectI::withCenter(Vec2I(rand.randInt(0, worldSize[0]), rand.randInt(0, worldSize[1])), Vec2I::filled(regionSize));
-      worldServer.generateRegion(region);
-    }
+      double time = Time::monotonicTime() - start;
+      coutf("Finished generating {} regions with size {}x{} in world '{}' in {} seconds\n", regionsToGenerate, regionSize, regionSize, coordinate, time);
+      return time;
+    };
 
-    coutf("Finished generating {} regions with size {}x{} in world '{}' in {} seconds", regionsToGenerate, regionSize, regionSize, coordinate, Time::monotonicTime() - start);
+    double serialTime = generateWorld(false);
+    double pregeneratedTime = generateWorld(true);
+    coutf("Pregeneration speedup: {:.2f}x\n", serialTime / pregeneratedTime);
 
     return 0;
 
@@ -0,0 +1,80 @@
+#include "StarCellularLightingFixture.hpp"
+#include "StarLexicalCast.hpp"
+#include "StarTime.hpp"
+
+using namespace Star;
+
+// Reports the best time out of the given number of runs for spreading light
+// over a view sized CellularLightArray, both with the cell by cell reference
+// algorithm and with the column based one, which uses SSE2 where available.
+template <typename LightTraits>
+void benchmarkSpread(String const& name, size_t runs, function<typename LightTraits::Value(RandomSource&)> randomLight) {
+  RandomSource rand(1);
+  CellularLightArray<LightTraits> lightArray;
+  auto initialCells = beginLightSpreadFixture<LightTraits>(lightArray, rand, randomLight);
+
+  size_t border = lightArray.borderCells();
+  size_t width = LightingFixtureViewWidth + border * 2;
+  size_t height = LightingFixtureViewHeight + border * 2;
+
+  double referenceTime = highest<double>();
+  for (size_t run = 0; run < runs; ++run) {
+    auto cells = initialCells;
+    double start = Time::monotonicTime();
+    referenceLightSpread<LightTraits>(cells, height, 0, 0, width, height);
+    referenceTime = min(referenceTime, Time::monotonicTime() - start);
+  }
+
+  double columnTime = highest<double>();
+  for (size_t run = 0; run < runs; ++run) {
+    for (size_t i = 0; i < width * height; ++i)
+      lightArray.cellAtIndex(i) = initialCells[i];
+    double start = Time::monotonicTime();
+    lightArray.calculate(border, border, width - border, height - border);
+    columnTime = min(columnTime, Time::monotonicTime() - start);
+  }
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  char const* columnName = "SSE2";
+#else
+  char const* columnName = "column";
+#endif
+  coutf("{}x{} {} light spread: reference {:.2f}ms, {} {:.2f}ms ({:.2f}x)\n",
+      width, height, name, referenceTime * 1000, columnName, columnTime * 1000, referenceTime / columnTime);
+}
+
+// Reports the best time out of the given number of runs for calculating
+// colored lighting over a view sized region with each number of threads.
+void benchmarkThreadedLighting(size_t runs) {
+  auto fixture = makeColoredLightingFixture(2);
+  CellularLightingCalculator calculator;
+  for (unsigned threadCount : {1, 2, 4, 8}) {
+    double bestTime = highest<double>();
+    for (size_t run = 0; run < runs; ++run) {
+      fixture.begin(calculator, threadCount);
+      Lightmap lightmap;
+      double start = Time::monotonicTime();
+      calculator.calculate(lightmap);
+      bestTime = min(bestTime, Time::monotonicTime() - start);
+    }
+
+    coutf("{}x{} colored lighting, {} threads: {:.2f}ms\n", LightingFixtureViewWidth, LightingFixtureViewHeight, threadCount, bestTime * 1000);
+  }
+}
+
+int main(int argc, char** argv) {
+  try {
+    size_t runs = 10;
+    if (argc > 1)
+      runs = lexicalCast<size_t>(argv[1]);
+
+    benchmarkSpread<ScalarLightTraits>("scalar", runs, [](RandomSource& rand) { return rand.randf(); });
+    benchmarkSpread<ColoredLightTraits>("colored", runs, [](RandomSource& rand) { return Vec3F(rand.randf(), rand.randf(), rand.randf()); });
+    benchmarkThreadedLighting(runs);
+
+    return 0;
+  } catch (std::exception const& e) {
+    cerrf("exception caught: {}\n", outputException(e, true));
+    return 1;
+  }
+}
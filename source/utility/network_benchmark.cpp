@@ -0,0 +1,118 @@
+#include "StarLexicalCast.hpp"
+#include "StarLogging.hpp"
+#include "StarTime.hpp"
+#include "StarUniverseConnection.hpp"
+
+#include <ctime>
+
+using namespace Star;
+
+// Echoes ping packets through a UniverseConnectionServer over loopback TCP,
+// from a number of simulated clients that each send one packet every step.
+// Reports the round trip latency and the CPU time used by the whole process
+// per connection, with the network workers either polling sockets or
+// sleeping between checks.
+struct BenchmarkResult {
+  double averageLatency;
+  double worstLatency;
+  double cpuPerConnection;
+};
+
+BenchmarkResult runBenchmark(uint16_t port, size_t clientCount, bool pollSockets, double duration, unsigned workerThreads) {
+  auto connectionServer = make_shared<UniverseConnectionServer>([](UniverseConnectionServer* server, ConnectionId clientId, List<PacketPtr> packets) {
+      server->sendPackets(clientId, std::move(packets));
+    }, workerThreads, pollSockets);
+
+  TcpServer tcpServer(HostAddressWithPort("127.0.0.1", port));
+  List<TcpPacketSocketUPtr> clients;
+  for (size_t i = 0; i < clientCount; ++i) {
+    auto clientSocket = TcpSocket::connectTo(HostAddressWithPort("127.0.0.1", port));
+    auto serverSocket = tcpServer.accept(1000);
+    if (!serverSocket)
+      throw StarException("Timed out accepting benchmark connection");
+    connectionServer->addConnection(i + 1, UniverseConnection(TcpPacketSocket::open(std::move(serverSocket))));
+    clients.append(TcpPacketSocket::open(std::move(clientSocket)));
+  }
+
+  int64_t const StepInterval = 16666;
+  // Clients are spread out evenly over each step
+  List<int64_t> nextSend;
+  int64_t start = Time::monotonicMicroseconds();
+  for (size_t i = 0; i < clientCount; ++i)
+    nextSend.append(start + StepInterval * i / clientCount);
+  List<Maybe<int64_t>> sentTime(clientCount);
+  double totalLatency = 0.0;
+  double worstLatency = 0.0;
+  size_t roundTrips = 0;
+
+  std::clock_t cpuStart = std::clock();
+  int64_t end = Time::monotonicMicroseconds() + (int64_t)(duration * 1000000);
+  while (Time::monotonicMicroseconds() < end) {
+    SocketPollQuery query;
+    int64_t wakeTime = end;
+    for (size_t i = 0; i < clientCount; ++i) {
+      int64_t now = Time::monotonicMicroseconds();
+      if (!sentTime[i] && now >= nextSend[i]) {
+        clients[i]->sendPackets({make_shared<PingPacket>(now)});
+        clients[i]->writeData();
+        sentTime[i] = now;
+        nextSend[i] += StepInterval;
+      }
+      if (!sentTime[i])
+        wakeTime = min(wakeTime, nextSend[i]);
+      query.add(clients[i]->pollSocket(), {true, clients[i]->sentPacketsPending()});
+    }
+
+    // Only wake up for replies, or when the next client is due to send
+    Socket::poll(query, (max<int64_t>(wakeTime - Time::monotonicMicroseconds(), 0) + 999) / 1000);
+
+    for (size_t i = 0; i < clientCount; ++i) {
+      clients[i]->writeData();
+      clients[i]->readData();
+      for (auto const& packet : clients[i]->receivePackets()) {
+        if (as<PingPacket>(packet) && sentTime[i]) {
+          double latency = (Time::monotonicMicroseconds() - *take(sentTime[i])) / 1000.0;
+          totalLatency += latency;
+          worstLatency = max(worstLatency, latency);
+          ++roundTrips;
+        }
+      }
+    }
+  }
+  double cpuTime = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+  connectionServer.reset();
+  for (auto& client : clients)
+    client->close();
+
+  return {roundTrips ? totalLatency / roundTrips : 0.0, worstLatency, cpuTime / duration / clientCount * 1000.0};
+}
+
+int main(int argc, char** argv) {
+  try {
+    uint16_t port = 21080;
+    if (argc > 1)
+      port = lexicalCast<uint16_t>(argv[1]);
+    double duration = 5.0;
+    if (argc > 2)
+      duration = lexicalCast<double>(argv[2]);
+    unsigned workerThreads = 2;
+    if (argc > 3)
+      workerThreads = lexicalCast<unsigned>(argv[3]);
+
+    Logger::stdoutSink()->setLevel(LogLevel::Warn);
+
+    for (size_t clientCount : {1, 50, 200}) {
+      for (bool pollSockets : {false, true}) {
+        auto result = runBenchmark(port, clientCount, pollSockets, duration, workerThreads);
+        coutf("{} clients, {}: average round trip {:.3f}ms, worst {:.3f}ms, cpu {:.3f}ms/s per connection\n",
+            clientCount, pollSockets ? "polling" : "sleeping", result.averageLatency, result.worstLatency, result.cpuPerConnection);
+      }
+    }
+
+    return 0;
+  } catch (std::exception const& e) {
+    cerrf("exception caught: {}\n", outputException(e, true));
+    return 1;
+  }
+}
@@ -0,0 +1,77 @@
+#include "StarFile.hpp"
+#include "StarDataStreamDevices.hpp"
+#include "StarZSTDCompression.hpp"
+
+using namespace Star;
+
+// Trains a dictionary for the network compression stream from the captures
+// written by a server with "compressionCaptureDirectory" set in its
+// connectionSettings.  Each flush of the stream is one training sample.
+size_t const DictionarySize = 64 * 1024;
+
+List<ByteArray> readCapture(String const& path) {
+  List<ByteArray> samples;
+  DataStreamBuffer ds(File::readFile(path));
+  while (!ds.atEnd())
+    samples.append(ds.read<ByteArray>());
+  return samples;
+}
+
+size_t streamCompressedSize(List<List<ByteArray>> const& captures, ByteArray const& dictionary) {
+  size_t size = 0;
+  for (auto const& capture : captures) {
+    CompressionStream compressionStream;
+    if (!dictionary.empty())
+      compressionStream.setDictionary(dictionary);
+    for (auto const& sample : capture)
+      size += compressionStream.compress(sample).size();
+  }
+  return size;
+}
+
+int main(int argc, char** argv) {
+  try {
+    if (argc < 3) {
+      coutf("Usage, {} <output_dictionary> <capture_file_or_directory> [<capture_file_or_directory>...]\n", argv[0]);
+      return -1;
+    }
+
+    StringList capturePaths;
+    for (int i = 2; i < argc; ++i) {
+      String path = argv[i];
+      if (File::isDirectory(path)) {
+        for (auto const& entry : File::dirList(path)) {
+          if (!entry.second && entry.first.endsWith(".capture"))
+            capturePaths.append(File::relativeTo(path, entry.first));
+        }
+      } else {
+        capturePaths.append(path);
+      }
+    }
+
+    List<List<ByteArray>> captures;
+    List<ByteArray> samples;
+    size_t uncompressedSize = 0;
+    for (auto const& path : capturePaths) {
+      auto capture = readCapture(path);
+      for (auto const& sample : capture)
+        uncompressedSize += sample.size();
+      samples.appendAll(capture);
+      captures.append(std::move(capture));
+    }
+    coutf("Read {} samples, {} bytes, from {} captures\n", samples.size(), uncompressedSize, captures.size());
+
+    auto dictionary = ZstdCompression::trainDictionary(samples, DictionarySize);
+    File::writeFile(dictionary, argv[1]);
+    coutf("Wrote {} byte dictionary with id {} to {}\n", dictionary.size(), ZstdCompression::dictionaryId(dictionary), argv[1]);
+
+    size_t plainSize = streamCompressedSize(captures, {});
+    size_t dictionarySize = streamCompressedSize(captures, dictionary);
+    coutf("Stream compressed size without dictionary {} ({:.1f}%), with dictionary {} ({:.1f}%)\n",
+        plainSize, plainSize * 100.0 / uncompressedSize, dictionarySize, dictionarySize * 100.0 / uncompressedSize);
+    return 0;
+  } catch (std::exception const& e) {
+    coutf("Error! Caught exception {}\n", outputException(e, true));
+    return 1;
+  }
+}